@@ -29,6 +29,16 @@
 #'   override existing groups. To instead add to the existing groups,
 #'   use \code{add = TRUE}
 #' @inheritParams filter
+#' @section Sorted data:
+#'
+#' When the rows of each group are already stored next to each other, e.g.
+#' because the data was sorted by the grouping variables, \code{group_by_sorted}
+#' finds the groups in a single pass without hashing and only stores the
+#' size of each group. This is not checked: rows of the same group that are
+#' not adjacent form separate groups. The grouping is kept by
+#' \code{\link{filter}}, \code{\link{mutate}}, \code{\link{summarise}} and
+#' by \code{\link{arrange}} when the data is sorted by the grouping variables
+#' first. Other verbs fall back to the usual grouping.
 #' @export
 #' @examples
 #' by_cyl <- group_by(mtcars, cyl)
@@ -57,11 +67,22 @@
 #'
 #' # Duplicate groups are silently dropped
 #' groups(group_by(by_cyl, cyl, cyl))
+#'
+#' # Data sorted by the grouping variables
+#' sorted <- arrange(mtcars, cyl)
+#' summarise(group_by_sorted(sorted, cyl), mean(disp))
 #' @aliases regroup
 group_by <- function(.data, ..., add = FALSE) {
   group_by_(.data, .dots = lazyeval::lazy_dots(...), add = add)
 }
 
+#' @export
+#' @rdname group_by
+group_by_sorted <- function(.data, ..., add = FALSE) {
+  groups <- group_by_prepare(.data, .dots = lazyeval::lazy_dots(...), add = add)
+  grouped_df(groups$data, groups$groups, sorted = TRUE)
+}
+
 #' @export
 #' @rdname group_by
 group_by_ <- function(.data, ..., .dots, add = FALSE) {
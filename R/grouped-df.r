@@ -9,13 +9,22 @@
 #' @param vars a list of quoted variables.
 #' @param drop if \code{TRUE} preserve all factor levels, even those without
 #'   data.
+#' @param sorted if \code{TRUE}, the rows of each group are assumed to be
+#'   stored next to each other, e.g. because \code{data} is sorted by
+#'   \code{vars}. Groups are then found in a single pass over the data
+#'   and only their sizes are stored. This is not checked.
 #' @export
-grouped_df <- function(data, vars, drop = TRUE) {
+grouped_df <- function(data, vars, drop = TRUE, sorted = FALSE) {
   if (length(vars) == 0) {
     return(tbl_df(data))
   }
-  assert_that(is.data.frame(data), is.list(vars), all(sapply(vars,is.name)), is.flag(drop))
-  grouped_df_impl(data, unname(vars), drop)
+  assert_that(is.data.frame(data), is.list(vars), all(sapply(vars,is.name)),
+    is.flag(drop), is.flag(sorted))
+  if (sorted) {
+    grouped_df_adj_impl(data, unname(vars), drop)
+  } else {
+    grouped_df_impl(data, unname(vars), drop)
+  }
 }
 
 #' @rdname grouped_df
@@ -26,7 +35,7 @@ is.grouped_df <- function(x) inherits(x, "grouped_df")
 print.grouped_df <- function(x, ..., n = NULL, width = NULL) {
   cat("Source: local data frame ", dim_desc(x), "\n", sep = "")
 
-  grps <- if (is.null(attr(x, "indices"))) "?" else length(attr(x, "indices"))
+  grps <- if (is.null(attr(x, "group_sizes"))) "?" else length(attr(x, "group_sizes"))
   cat("Groups: ", commas(deparse_all(groups(x))), " [", big_mark(grps), "]\n", sep = "")
   cat("\n")
   print(trunc_mat(x, n = n, width = width), ...)
@@ -40,7 +49,7 @@ group_size.grouped_df <- function(x) {
 
 #' @export
 n_groups.grouped_df <- function(x) {
-  length(attr(x, "indices"))
+  length(attr(x, "group_sizes"))
 }
 
 #' @export
@@ -128,9 +137,9 @@ rename_.grouped_df <- function(.data, ..., .dots) {
 #' @export
 do_.grouped_df <- function(.data, ..., env = parent.frame(), .dots) {
   # Force computation of indices
-  if (is.null(attr(.data, "indices"))) {
-    .data <- grouped_df_impl(.data, attr(.data, "vars"),
-      attr(.data, "drop") %||% TRUE)
+  if (is.null(attr(.data, "group_sizes"))) {
+    .data <- grouped_df(.data, attr(.data, "vars"),
+      attr(.data, "drop") %||% TRUE, sorted = is_adj_grouped(.data))
   }
 
   # Create ungroup version of data frame suitable for subsetting
@@ -141,7 +150,7 @@ do_.grouped_df <- function(.data, ..., env = parent.frame(), .dots) {
   env <- new.env(parent = lazyeval::common_env(args))
   labels <- attr(.data, "labels")
 
-  index <- attr(.data, "indices")
+  index <- group_index_list(.data)
   n <- length(index)
   m <- length(args)
 
@@ -187,6 +196,20 @@ do_.grouped_df <- function(.data, ..., env = parent.frame(), .dots) {
   }
 }
 
+is_adj_grouped <- function(x) inherits(x, "adj_grouped_df")
+
+# Zero-based row indices of each group. Adjacent groups only store their
+# sizes, the rows of a group follow those of the previous one.
+group_index_list <- function(x) {
+  if (!is_adj_grouped(x)) {
+    return(attr(x, "indices"))
+  }
+  sizes <- attr(x, "group_sizes")
+  starts <- cumsum(c(0L, sizes[-length(sizes)]))
+  mapply(function(start, size) start + seq_len(size) - 1L, starts, sizes,
+    SIMPLIFY = FALSE, USE.NAMES = FALSE)
+}
+
 # Set operations ---------------------------------------------------------------
 
 #' @export
@@ -207,14 +230,9 @@ sample_n.grouped_df <- function(tbl, size, replace = FALSE, weight = NULL,
   .env = parent.frame()) {
 
   assert_that(is.numeric(size), length(size) == 1, size >= 0)
-  weight <- substitute(weight)
-
-  index <- attr(tbl, "indices")
-  sampled <- lapply(index, sample_group, frac = FALSE,
-    tbl = tbl, size = size, replace = replace, weight = weight, .env = .env)
-  idx <- unlist(sampled) + 1
+  weight <- group_weight(tbl, substitute(weight), .env)
 
-  grouped_df(tbl[idx, , drop = FALSE], vars = groups(tbl))
+  sample_grouped_impl(tbl, size, FALSE, replace, weight)
 }
 
 #' @export
@@ -226,28 +244,18 @@ sample_frac.grouped_df <- function(tbl, size = 1, replace = FALSE, weight = NULL
     stop("Sampled fraction can't be greater than one unless replace = TRUE",
       call. = FALSE)
   }
-  weight <- substitute(weight)
-
-  index <- attr(tbl, "indices")
-  sampled <- lapply(index, sample_group, frac = TRUE,
-    tbl = tbl, size = size, replace = replace, weight = weight, .env = .env)
-  idx <- unlist(sampled) + 1
+  weight <- group_weight(tbl, substitute(weight), .env)
 
-  grouped_df(tbl[idx, , drop = FALSE], vars = groups(tbl))
+  sample_grouped_impl(tbl, size, TRUE, replace, weight)
 }
 
-sample_group <- function(tbl, i, frac = FALSE, size, replace = TRUE,
-  weight = NULL, .env = parent.frame()) {
-  n <- length(i)
-  if (frac) size <- round(size * n)
+# Weights are evaluated within each group, as in mutate()
+group_weight <- function(tbl, weight, .env) {
+  if (is.null(weight)) return(NULL)
 
-  check_size(size, n, replace)
-
-  # weight use standard evaluation in this function
-  if (!is.null(weight)) {
-    weight <- eval(weight, tbl[i + 1, , drop = FALSE], .env)
-    weight <- check_weight(weight, n)
+  weight <- mutate_(tbl, .weight = lazyeval::as.lazy(weight, .env))$.weight
+  if (!is.numeric(weight)) {
+    stop("Weights must be numeric", call. = FALSE)
   }
-
-  i[sample.int(n, size, replace = replace, prob = weight)]
+  as.numeric(weight)
 }
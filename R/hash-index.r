@@ -0,0 +1,50 @@
+#' Index a data frame by key variables
+#'
+#' \code{index_by()} builds a hash index of the rows of a data frame by the
+#' values of key variables, and stores it with the data. Joins and filters
+#' that look up rows by those keys then only hash the rows they look up,
+#' instead of hashing the whole table each time: \code{semi_join()} with an
+#' indexed \code{x} or \code{y}, \code{inner_join()} and \code{left_join()}
+#' with an indexed \code{y}, joining by exactly the keys of the index, and an
+#' ungrouped \code{filter()} on a single \code{key == value} or
+#' \code{key \%in\% values} condition, for an index on one variable. The
+#' results are the same as without the index.
+#'
+#' The keys must be logical, integer, double or character vectors, or dates.
+#' They are only compared by value with columns or values of the same type
+#' and class, other lookups hash the rows as usual.
+#'
+#' The index is stored in the \code{"hash_index"} attribute, and belongs to
+#' the key columns it was built from: it is ignored when they are modified or
+#' replaced, and when the data is saved and loaded again. Verbs that return
+#' new rows do not keep it. \code{index_by()} with no variables drops it.
+#'
+#' @param .data,x A data frame.
+#' @param ... Names of the key variables.
+#' @return \code{index_by()} returns \code{.data} with the index,
+#'   \code{indexed_vars()} the keys of a valid index of \code{x}, or an
+#'   empty character vector.
+#' @export
+#' @examples
+#' flights <- data.frame(id = c(1L, 3L, 2L, 3L), delay = c(5, 0, 12, 3))
+#' planes <- index_by(data.frame(id = 1:3, seats = c(100L, 150L, 200L)), id)
+#' indexed_vars(planes)
+#'
+#' left_join(flights, planes, by = "id")
+#' semi_join(planes, flights, by = "id")
+#' filter(planes, id %in% c(2L, 3L))
+index_by <- function(.data, ...) {
+  dots <- lazyeval::lazy_dots(...)
+  is_name <- vapply(dots, function(x) is.name(x$expr), logical(1))
+  if (!all(is_name)) {
+    stop("Data can only be indexed by existing variables", call. = FALSE)
+  }
+  vars <- vapply(dots, function(x) as.character(x$expr), character(1))
+  index_by_impl(.data, unname(vars))
+}
+
+#' @export
+#' @rdname index_by
+indexed_vars <- function(x) {
+  indexed_vars_impl(x)
+}
@@ -0,0 +1,53 @@
+#' Profile the verbs of the local backend
+#'
+#' \code{profile_verbs()} records what the data frame verbs do while
+#' \code{code} runs, and \code{last_profile()} returns the records of the
+#' last profiled run. This is to data frames what \code{\link{explain}()} is
+#' to databases: it shows whether each expression was evaluated by one of
+#' dplyr's hybrid handlers, in C++, or fell back to calling R once per
+#' group, and where the time goes.
+#'
+#' Each row of the profile is a phase of a verb: \code{"index"} (computing
+#' the groups), \code{"evaluate"} (one expression), \code{"order"},
+#' \code{"subset"} or \code{"structure"} (building the result), with:
+#'
+#' \describe{
+#'   \item{verb, phase}{The verb and the phase.}
+#'   \item{name, fun}{For expressions, the name of the result, if any, and
+#'     the function that is called.}
+#'   \item{handler}{For expressions, how it was evaluated: \code{"hybrid"}
+#'     without calling back to R, \code{"R"} when R code was evaluated,
+#'     \code{"elementwise"} when R code was evaluated once on whole columns
+#'     instead of once per group, \code{"column"} for an existing variable,
+#'     or \code{"constant"}. For the index of \code{group_by()},
+#'     \code{"cache"} when an index of the same columns was reused, and
+#'     \code{"sorted"} when the groups were found as runs of sorted rows, see
+#'     \code{\link{sorted_by}}. For \code{filter()}, \code{"sorted"} when the
+#'     rows were found by binary search, and \code{"index"} when they were
+#'     looked up in a hash index, see \code{\link{index_by}}.}
+#'   \item{rows, groups}{The number of rows and groups processed.}
+#'   \item{callbacks}{The number of times R code was evaluated.}
+#'   \item{seconds}{Time spent in the phase.}
+#'   \item{bytes}{Size of the vector produced by an expression. R does not
+#'     count the memory it allocates, so this does not include temporaries.}
+#' }
+#'
+#' @param code Code to profile.
+#' @return \code{profile_verbs()} returns the value of \code{code}
+#'   invisibly, \code{last_profile()} a data frame.
+#' @export
+#' @examples
+#' by_year <- group_by(nasa, year)
+#' profile_verbs(summarise(by_year, ozone = mean(ozone), n = length(unique(month))))
+#' last_profile()
+profile_verbs <- function(code) {
+  profile_start()
+  on.exit(profile_stop())
+  invisible(code)
+}
+
+#' @export
+#' @rdname profile_verbs
+last_profile <- function() {
+  profile_get()
+}
@@ -46,14 +46,22 @@ Query <- R6::R6Class("Query",
       out
     },
 
-    fetch_paged = function(chunk_size = 1e4, callback) {
+    fetch_paged = function(chunk_size = 1e4, callback, n = -1L,
+                           warn_incomplete = FALSE) {
       qry <- dbSendQuery(self$con, self$sql)
       on.exit(dbClearResult(qry))
 
-      while (!dbHasCompleted(qry)) {
-        chunk <- fetch(qry, chunk_size)
+      remaining <- if (n < 0) Inf else n
+      while (remaining > 0 && !dbHasCompleted(qry)) {
+        chunk <- fetch(qry, min(chunk_size, remaining))
+        if (nrow(chunk) == 0) break
+
+        remaining <- remaining - nrow(chunk)
         callback(chunk)
       }
+      if (warn_incomplete) {
+        res_warn_incomplete(qry, "n = Inf")
+      }
 
       invisible(TRUE)
     },
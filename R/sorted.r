@@ -0,0 +1,56 @@
+#' Variables a data frame is sorted by
+#'
+#' \code{arrange()} records the leading variables it sorts by in ascending
+#' order, up to the first expression that is not a variable or is wrapped in
+#' \code{desc()}. \code{sorted_by()} declares them for data sorted by other
+#' means, after checking in one pass that the rows are in the order
+#' \code{arrange()} would give them, and \code{sorted_by()} with no variables
+#' forgets them. \code{filter()} keeps them.
+#'
+#' Data frames known to be sorted are grouped by the leading sorted
+#' variables without hashing, an ungrouped \code{filter()} on a single
+#' \code{key == value} or \code{key \%in\% values} condition finds the rows
+#' of the first variable by binary search, and \code{inner_join()} and
+#' \code{left_join()} of two tables sorted by their only key merge the keys.
+#' The searches and merges are limited to numeric and logical keys without a
+#' class, and dates for joins.
+#'
+#' The variables are stored in the \code{"dplyr_sorted"} attribute, which
+#' other functions may carry over to data that is no longer sorted. They are
+#' only used for columns that dplyr sorted or checked: data with the attribute
+#' is checked, once, the first time it is used. dplyr remembers the columns
+#' it sorted or checked, without keeping them in memory. \code{sorted_vars()}
+#' gives the variables that pass that check. Data tables are never marked as
+#' sorted, as their own \code{"sorted"} attribute has another meaning.
+#'
+#' @param .data,x A data frame.
+#' @param ... Names of the variables, in order.
+#' @return \code{sorted_by()} returns \code{.data} with its sorted variables,
+#'   \code{sorted_vars()} a character vector, empty when \code{x} is not known
+#'   to be sorted.
+#' @export
+#' @examples
+#' by_cyl <- arrange(mtcars, cyl, desc(mpg))
+#' sorted_vars(by_cyl)
+#' filter(by_cyl, cyl == 6)
+#'
+#' x <- sorted_by(data.frame(id = 1:5, x = letters[1:5]), id)
+#' sorted_vars(x)
+#' \dontrun{
+#' sorted_by(data.frame(id = 5:1), id)
+#' }
+sorted_by <- function(.data, ...) {
+  dots <- lazyeval::lazy_dots(...)
+  is_name <- vapply(dots, function(x) is.name(x$expr), logical(1))
+  if (!all(is_name)) {
+    stop("Data can only be sorted by existing variables", call. = FALSE)
+  }
+  vars <- vapply(dots, function(x) as.character(x$expr), character(1))
+  sorted_by_impl(.data, unname(vars))
+}
+
+#' @export
+#' @rdname sorted_by
+sorted_vars <- function(x) {
+  sorted_vars_impl(x)
+}
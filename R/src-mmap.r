@@ -0,0 +1,377 @@
+#' A source of memory-mapped columnar tables
+#'
+#' \code{src_mmap()} stores tables in a directory on disk, one file per
+#' column: the values of logical, integer and double columns, and the codes
+#' of character columns, whose strings are stored once in a dictionary.
+#' Factors are stored as their codes, and the attributes of the columns,
+#' e.g. their class and levels, are kept with the table.
+#'
+#' Opening a table with \code{tbl()} only reads its description, and the
+#' files of its columns are mapped in memory the first time they are used.
+#' The verbs then only read the columns and the rows that they need:
+#' \code{select()}, \code{rename()}, \code{group_by()} and \code{head()}
+#' only update the description of the table; \code{filter()} and
+#' \code{arrange()} read the columns of their conditions and record the
+#' rows they keep, and \code{semi_join()} and \code{anti_join()} the
+#' columns of the join; \code{summarise()} reads the grouping variables and
+#' the columns of the summaries; \code{inner_join()} and \code{left_join()}
+#' join the columns of the join and read the other columns of the rows that
+#' match. \code{mutate()}, \code{distinct()}, \code{slice()} and
+#' \code{do()}, and the other joins, work on the data frame given by
+#' \code{collect()}; call \code{collect()} before using other verbs.
+#'
+#' @param path Directory of the tables.
+#' @param create If \code{FALSE}, \code{path} must already exist.
+#' @export
+#' @examples
+#' mmap <- src_mmap(tempfile(), create = TRUE)
+#' nasa_mmap <- copy_to(mmap, as.data.frame(nasa), "nasa")
+#' nasa_mmap %>% filter(year == 2000) %>% group_by(month) %>%
+#'   summarise(ozone = mean(ozone))
+src_mmap <- function(path, create = FALSE) {
+  assert_that(is.string(path))
+  if (!file.exists(path)) {
+    if (!create) {
+      stop("Path does not exist and create = FALSE", call. = FALSE)
+    }
+    dir.create(path, recursive = TRUE)
+  }
+
+  structure(
+    list(path = normalizePath(path)),
+    class = c("src_mmap", "src")
+  )
+}
+
+#' @export
+src_tbls.src_mmap <- function(x, ...) {
+  tbls <- list.files(x$path)
+  tbls[file.exists(file.path(x$path, tbls, "meta.rds"))]
+}
+
+#' @export
+format.src_mmap <- function(x, ...) {
+  paste0("src:  mmap [", x$path, "]\n",
+    wrap("tbls: ", paste0(sort(src_tbls(x)), collapse = ", ")))
+}
+
+#' @export
+copy_to.src_mmap <- function(dest, df, name = deparse(substitute(df)),
+                             overwrite = FALSE, ...) {
+  assert_that(is.data.frame(df), is.string(name), is.flag(overwrite))
+  df <- ungroup(df)
+  types <- vapply(df, mmap_type, integer(1))
+
+  dir <- file.path(dest$path, name)
+  if (file.exists(dir)) {
+    if (!overwrite) {
+      stop("Table ", name, " already exists.", call. = FALSE)
+    }
+    unlink(dir, recursive = TRUE)
+  }
+  dir.create(dir)
+  for (j in seq_along(df)) {
+    write_mapped_column_impl(df[[j]], dir, j)
+  }
+
+  # written last, a table is only listed once its columns are complete
+  meta <- list(nrow = nrow(df), types = unname(types), prototype = df[0, , drop = FALSE])
+  saveRDS(meta, file.path(dir, "meta.rds"))
+
+  tbl(dest, name)
+}
+
+# the SEXPTYPE a column is stored as
+mmap_type <- function(x) {
+  switch(typeof(x),
+    logical = 10L,
+    integer = 13L,
+    double = 14L,
+    character = 16L,
+    stop("Can't store column of type ", typeof(x), call. = FALSE)
+  )
+}
+
+#' @export
+tbl.src_mmap <- function(src, from, ...) {
+  dir <- file.path(src$path, from)
+  meta_path <- file.path(dir, "meta.rds")
+  if (!file.exists(meta_path)) {
+    stop("Table ", from, " not found", call. = FALSE)
+  }
+  meta <- readRDS(meta_path)
+  vars <- names(meta$prototype)
+
+  structure(
+    list(
+      src = src,
+      name = from,
+      table = mapped_table(dir, meta$types, meta$nrow),
+      prototype = meta$prototype,
+      nrow = meta$nrow,
+      # names of the columns, named by their names in the tbl
+      vars = stats::setNames(vars, vars),
+      # rows of the table, in order, or NULL for all of them
+      rows = NULL,
+      groups = character()
+    ),
+    class = c("tbl_mmap", "tbl")
+  )
+}
+
+# Reading columns ---------------------------------------------------------
+
+# the columns vars of x, as a data frame
+mmap_columns <- function(x, vars = names(x$vars), rows = x$rows) {
+  cols <- lapply(vars, function(var) {
+    stored <- x$vars[[var]]
+    col <- mapped_table_column(x$table, match(stored, names(x$prototype)), rows)
+    attributes(col) <- attributes(x$prototype[[stored]])
+    col
+  })
+  names(cols) <- vars
+
+  n <- if (is.null(rows)) x$nrow else length(rows)
+  attr(cols, "row.names") <- .set_row_names(n)
+  class(cols) <- c("tbl_df", "tbl", "data.frame")
+  cols
+}
+
+# the rows of x, even when all of them are used
+mmap_rows <- function(x) {
+  x$rows %||% seq_len(x$nrow)
+}
+
+# the variables of x used by the expressions of dots
+mmap_used_vars <- function(x, dots) {
+  used <- unique(unlist(lapply(dots, function(dot) all.names(dot$expr))))
+  intersect(names(x$vars), union(x$groups, used))
+}
+
+#' @export
+collect.tbl_mmap <- function(x, ...) {
+  grouped_df(mmap_columns(x), lapply(x$groups, as.name))
+}
+
+#' @export
+as.data.frame.tbl_mmap <- function(x, row.names = NULL, optional = FALSE, ...) {
+  as.data.frame(mmap_columns(x))
+}
+
+#' @export
+print.tbl_mmap <- function(x, ..., n = NULL, width = NULL) {
+  cat("Source:   mmap table ", x$name, " ", dim_desc(x), "\n", sep = "")
+  if (length(x$groups) > 0) {
+    cat("Groups: ", commas(x$groups), "\n", sep = "")
+  }
+  cat("\n")
+
+  n <- n %||% 10L
+  print(trunc_mat(mmap_columns(head(x, n)), n = n, width = width))
+  invisible(x)
+}
+
+#' @export
+tbl_vars.tbl_mmap <- function(x) names(x$vars)
+
+#' @export
+groups.tbl_mmap <- function(x) lapply(x$groups, as.name)
+
+#' @export
+dim.tbl_mmap <- function(x) {
+  n <- if (is.null(x$rows)) x$nrow else length(x$rows)
+  c(n, length(x$vars))
+}
+
+#' @export
+dimnames.tbl_mmap <- function(x) {
+  list(NULL, names(x$vars))
+}
+
+#' @export
+same_src.tbl_mmap <- function(x, y) {
+  inherits(y, "tbl_mmap") && identical(x$src$path, y$src$path)
+}
+
+#' @export
+head.tbl_mmap <- function(x, n = 6L, ...) {
+  x$rows <- utils::head(mmap_rows(x), n)
+  x
+}
+
+# Verbs -------------------------------------------------------------------
+
+#' @export
+select_.tbl_mmap <- function(.data, ..., .dots) {
+  dots <- lazyeval::all_dots(.dots, ...)
+  vars <- select_vars_(names(.data$vars), dots, include = .data$groups)
+
+  .data$vars <- stats::setNames(.data$vars[vars], names(vars))
+  .data
+}
+
+#' @export
+rename_.tbl_mmap <- function(.data, ..., .dots) {
+  dots <- lazyeval::all_dots(.dots, ...)
+  vars <- rename_vars_(names(.data$vars), dots)
+
+  .data$groups <- names(vars)[match(.data$groups, vars)]
+  .data$vars <- stats::setNames(.data$vars[vars], names(vars))
+  .data
+}
+
+#' @export
+group_by_.tbl_mmap <- function(.data, ..., .dots, add = FALSE) {
+  dots <- lazyeval::all_dots(.dots, ...)
+  is_name <- vapply(dots, function(x) is.name(x$expr), logical(1))
+  if (!all(is_name) || any(names2(dots) != "")) {
+    # new variables, in memory
+    return(group_by_(collect(.data), .dots = dots, add = add))
+  }
+
+  vars <- vapply(dots, function(x) as.character(x$expr), character(1))
+  unknown <- setdiff(vars, names(.data$vars))
+  if (length(unknown) > 0) {
+    stop("unknown variable to group by : ", unknown[1], call. = FALSE)
+  }
+  if (add) {
+    vars <- c(.data$groups, vars)
+  }
+  .data$groups <- unique(unname(vars))
+  .data
+}
+
+#' @export
+ungroup.tbl_mmap <- function(x, ...) {
+  x$groups <- character()
+  x
+}
+
+#' @export
+filter_.tbl_mmap <- function(.data, ..., .dots) {
+  dots <- lazyeval::all_dots(.dots, ...)
+  .data$rows <- mmap_kept_rows(.data, dots, filter_)
+  .data
+}
+
+#' @export
+arrange_.tbl_mmap <- function(.data, ..., .dots) {
+  dots <- lazyeval::all_dots(.dots, ...)
+  .data$rows <- mmap_kept_rows(ungroup(.data), dots, arrange_)
+  .data
+}
+
+# the rows given by verb on the columns of x used by dots
+mmap_kept_rows <- function(x, dots, verb) {
+  df <- mmap_columns(x, mmap_used_vars(x, dots))
+  df$.mmap_row <- mmap_rows(x)
+  df <- grouped_df(df, lapply(x$groups, as.name))
+  verb(df, .dots = dots)$.mmap_row
+}
+
+#' @export
+summarise_.tbl_mmap <- function(.data, ..., .dots) {
+  dots <- lazyeval::all_dots(.dots, ..., all_named = TRUE)
+  df <- mmap_columns(.data, mmap_used_vars(.data, dots))
+  df <- grouped_df(df, lapply(.data$groups, as.name))
+  summarise_(df, .dots = dots)
+}
+
+#' @export
+mutate_.tbl_mmap <- function(.data, ..., .dots) {
+  mutate_(collect(.data), ..., .dots = .dots)
+}
+
+#' @export
+distinct_.tbl_mmap <- function(.data, ..., .dots, .keep_all = FALSE) {
+  distinct_(collect(.data), ..., .dots = .dots, .keep_all = .keep_all)
+}
+
+#' @export
+slice_.tbl_mmap <- function(.data, ..., .dots) {
+  slice_(collect(.data), ..., .dots = .dots)
+}
+
+#' @export
+do_.tbl_mmap <- function(.data, ..., .dots) {
+  do_(collect(.data), ..., .dots = .dots)
+}
+
+# Joins -------------------------------------------------------------------
+
+# the columns of y, if it is a tbl_mmap only these columns are read
+mmap_join_y <- function(y, vars = tbl_vars(y)) {
+  if (inherits(y, "tbl_mmap")) {
+    mmap_columns(y, vars)
+  } else {
+    select_(tbl_df(y), .dots = vars)
+  }
+}
+
+#' @export
+semi_join.tbl_mmap <- function(x, y, by = NULL, copy = FALSE, ...) {
+  by <- common_by(by, x, y)
+  x$rows <- mmap_filter_join(x, y, by, semi_join)
+  x
+}
+
+#' @export
+anti_join.tbl_mmap <- function(x, y, by = NULL, copy = FALSE, ...) {
+  by <- common_by(by, x, y)
+  x$rows <- mmap_filter_join(x, y, by, anti_join)
+  x
+}
+
+mmap_filter_join <- function(x, y, by, join) {
+  keys <- mmap_columns(x, by$x)
+  keys$.mmap_row <- mmap_rows(x)
+  join(keys, mmap_join_y(y, by$y), by = stats::setNames(by$y, by$x))$.mmap_row
+}
+
+#' @export
+inner_join.tbl_mmap <- function(x, y, by = NULL, copy = FALSE,
+                                suffix = c(".x", ".y"), ...) {
+  mmap_mutating_join(x, y, by, suffix, inner_join, ...)
+}
+
+#' @export
+left_join.tbl_mmap <- function(x, y, by = NULL, copy = FALSE,
+                               suffix = c(".x", ".y"), ...) {
+  mmap_mutating_join(x, y, by, suffix, left_join, ...)
+}
+
+#' @export
+right_join.tbl_mmap <- function(x, y, by = NULL, copy = FALSE,
+                                suffix = c(".x", ".y"), ...) {
+  right_join(collect(x), mmap_join_y(y), by = by, suffix = suffix, ...)
+}
+
+#' @export
+full_join.tbl_mmap <- function(x, y, by = NULL, copy = FALSE,
+                               suffix = c(".x", ".y"), ...) {
+  full_join(collect(x), mmap_join_y(y), by = by, suffix = suffix, ...)
+}
+
+# joins the key columns of x with y, then reads the other columns of x at
+# the rows of the result
+mmap_mutating_join <- function(x, y, by, suffix, join, ...) {
+  by <- common_by(by, x, y)
+  y <- mmap_join_y(y)
+
+  # names that need a suffix are only known with all the columns of x
+  others <- setdiff(names(x$vars), by$x)
+  if (any(names(y) %in% c(others, ".mmap_row"))) {
+    return(join(collect(x), y, by = by, suffix = suffix, ...))
+  }
+
+  keys <- mmap_columns(x, by$x)
+  keys$.mmap_row <- mmap_rows(x)
+  joined <- join(keys, y, by = stats::setNames(by$y, by$x), ...)
+
+  x$rows <- joined$.mmap_row
+  out <- mmap_columns(x, names(x$vars))
+  for (var in setdiff(names(joined), c(by$x, ".mmap_row"))) {
+    out[[var]] <- joined[[var]]
+  }
+  out
+}
@@ -0,0 +1,226 @@
+#' Summarise data that comes in chunks
+#'
+#' A \code{tbl_chunked} is a source of data that is only read one chunk of
+#' rows at a time, e.g. a table too large to fit in memory.
+#' \code{summarise()} of a grouped \code{tbl_chunked} keeps one partial
+#' state per group and aggregate, updated with each chunk. When the groups
+#' and their states grow beyond \code{.memory} bytes, they are written to
+#' temporary files, one per hash partition of the groups, and the memory is
+#' released. The files are read back one partition at a time at the end, so
+#' that the summary of many more groups than fit in memory can be computed
+#' as long as the groups of one partition do.
+#'
+#' The summaries are \code{n()}, and \code{sum()}, \code{mean()},
+#' \code{var()}, \code{sd()}, \code{min()}, \code{max()} and
+#' \code{n_distinct()} of a numeric or logical column, with an optional
+#' \code{na.rm} argument. The mean is computed in extended precision rather
+#' than refined with a second pass, so it can differ from \code{mean()} in
+#' the last bits.
+#'
+#' @param source The chunks: a list of data frames, a function that returns
+#'   the next data frame each time it is called and \code{NULL} after the
+#'   last one, the path of a csv file, or a \code{tbl_sql}.
+#' @param chunk_size Number of rows of each chunk read from a file or a
+#'   database.
+#' @return A \code{tbl_chunked}.
+#' @export
+#' @examples
+#' chunks <- split(mtcars, rep(1:4, length.out = nrow(mtcars)))
+#' by_cyl <- group_by(chunked(chunks), cyl)
+#' summarise(by_cyl, n = n(), mpg = mean(mpg), hp = max(hp), .memory = 1024)
+chunked <- function(source, chunk_size = 1e5) {
+  if (is.data.frame(source)) {
+    source <- list(source)
+  } else if (is.character(source)) {
+    assert_that(is.string(source))
+  } else if (!is.list(source) && !is.function(source) && !inherits(source, "tbl_sql")) {
+    stop("`source` must be a list of data frames, a function, a file or a ",
+      "tbl_sql", call. = FALSE)
+  }
+  structure(
+    list(source = source, chunk_size = chunk_size, groups = NULL),
+    class = c("tbl_chunked", "tbl")
+  )
+}
+
+#' @export
+print.tbl_chunked <- function(x, ...) {
+  cat("Source: chunked ", class(x$source)[1], "\n", sep = "")
+  if (length(x$groups)) {
+    cat("Groups: ", commas(x$groups), "\n", sep = "")
+  }
+  invisible(x)
+}
+
+#' @export
+groups.tbl_chunked <- function(x) {
+  lapply(x$groups, as.name)
+}
+
+#' @export
+group_by_.tbl_chunked <- function(.data, ..., .dots, add = FALSE) {
+  dots <- lazyeval::all_dots(.dots, ...)
+  is_name <- vapply(dots, function(x) is.name(x$expr), logical(1))
+  if (!all(is_name) || any(names2(dots) != "")) {
+    stop("Chunked data can only be grouped by existing variables", call. = FALSE)
+  }
+  vars <- vapply(dots, function(x) as.character(x$expr), character(1))
+  if (add) {
+    vars <- c(.data$groups, vars)
+  }
+  .data$groups <- unique(unname(vars))
+  .data
+}
+
+#' @export
+ungroup.tbl_chunked <- function(x, ...) {
+  x$groups <- NULL
+  x
+}
+
+#' @export
+collect.tbl_chunked <- function(x, ...) {
+  builder <- paged_collecter(x$groups %||% character())
+  each_chunk(x, function(chunk) paged_collecter_push(builder, chunk))
+  out <- paged_collecter_get(builder)
+  if (is.null(out)) {
+    stop("No rows in chunked data", call. = FALSE)
+  }
+  out
+}
+
+#' @rdname chunked
+#' @param .memory Number of bytes of partial states to keep in memory before
+#'   they are written to disk.
+#' @inheritParams summarise
+#' @export
+summarise_.tbl_chunked <- function(.data, ..., .dots, .memory = 1e8) {
+  dots <- lazyeval::all_dots(.dots, ..., all_named = TRUE)
+  # summarise() passes .memory along with the summaries
+  if (!is.null(dots$.memory)) {
+    .memory <- lazyeval::lazy_eval(dots$.memory)
+    dots$.memory <- NULL
+  }
+  specs <- Map(chunk_summary, names(dots), dots)
+  vars <- .data$groups
+
+  dir <- tempfile("dplyr-spill")
+  dir.create(dir)
+  on.exit(unlink(dir, recursive = TRUE))
+
+  first <- NULL
+  typed <- character()
+  summariser <- external_summariser(vars %||% character(), specs, dir, .memory)
+  each_chunk(.data, function(chunk) {
+    if (is.null(first)) {
+      first <<- chunk[0, , drop = FALSE]
+    }
+    # as with bind_rows(), a column of logical NA takes the class of the
+    # column in the next chunks
+    for (var in setdiff(names(chunk), typed)) {
+      x <- chunk[[var]]
+      if (!is.logical(x) || !all(is.na(x))) {
+        first[[var]] <<- x[0]
+        typed <<- c(typed, var)
+      }
+    }
+    external_summariser_push(summariser, chunk)
+  })
+  out <- external_summariser_get(summariser)
+  if (is.null(out)) {
+    stop("No rows in chunked data", call. = FALSE)
+  }
+
+  # the keys and the extrema are stored as bare vectors
+  for (var in vars) {
+    out[[var]] <- restore_chunk_column(out[[var]], first[[var]])
+  }
+  for (spec in specs) {
+    if (spec[[2]] %in% c("min", "max")) {
+      out[[spec[[1]]]] <- restore_chunk_column(out[[spec[[1]]]], first[[spec[[3]]]])
+    }
+  }
+
+  if (length(vars)) {
+    out <- arrange_(out, .dots = lapply(vars, as.name))
+  }
+  grouped_df(out, lapply(vars[-length(vars)], as.name))
+}
+
+# list(name, function, column or NULL, na.rm) of a summary
+chunk_summary <- function(name, dot) {
+  expr <- dot$expr
+  unsupported <- function() {
+    stop("Only n() and sum(), mean(), var(), sd(), min(), max() or ",
+      "n_distinct() of a column are supported in chunks, not ",
+      deparse(expr), call. = FALSE)
+  }
+  if (!is.call(expr) || !is.name(expr[[1]])) unsupported()
+
+  fun <- as.character(expr[[1]])
+  if (fun == "n") {
+    if (length(expr) != 1) unsupported()
+    return(list(name, fun, NULL, FALSE))
+  }
+  if (!fun %in% c("sum", "mean", "var", "sd", "min", "max", "n_distinct")) {
+    unsupported()
+  }
+
+  args <- as.list(expr[-1])
+  na_rm <- if (is.null(args$na.rm)) FALSE else eval(args$na.rm, dot$env)
+  args$na.rm <- NULL
+  if (length(args) != 1 || !is.name(args[[1]])) unsupported()
+  if (!is.logical(na_rm) || length(na_rm) != 1 || is.na(na_rm)) {
+    stop("`na.rm` must be TRUE or FALSE", call. = FALSE)
+  }
+
+  list(name, fun, as.character(args[[1]]), na_rm)
+}
+
+# gives x the class of the column of the chunks it comes from, factors are
+# summarised by their levels
+restore_chunk_column <- function(x, template) {
+  if (is.factor(template)) {
+    factor(x, levels = union(levels(template), sort(unique(x))))
+  } else if (is.numeric(template) || is.logical(template)) {
+    if (is.logical(template) && is.integer(x)) {
+      x <- as.logical(x)
+    }
+    attributes(x) <- attributes(template)
+    x
+  } else {
+    x
+  }
+}
+
+# calls f with each chunk of x
+each_chunk <- function(x, f) {
+  source <- x$source
+  if (inherits(source, "tbl_sql")) {
+    query <- query(source$src$con, sql_render(source), op_vars(source))
+    query$fetch_paged(x$chunk_size, f)
+  } else if (is.character(source)) {
+    con <- file(source, "r")
+    on.exit(close(con))
+    chunk <- utils::read.csv(con, nrows = x$chunk_size, stringsAsFactors = FALSE)
+    cols <- names(chunk)
+    while (nrow(chunk) > 0) {
+      f(chunk)
+      if (nrow(chunk) < x$chunk_size) break
+      chunk <- tryCatch(
+        utils::read.csv(con, header = FALSE, nrows = x$chunk_size,
+          col.names = cols, stringsAsFactors = FALSE),
+        error = function(e) chunk[0, , drop = FALSE]
+      )
+    }
+  } else if (is.function(source)) {
+    while (!is.null(chunk <- source())) {
+      f(chunk)
+    }
+  } else {
+    for (chunk in source) {
+      f(chunk)
+    }
+  }
+  invisible()
+}
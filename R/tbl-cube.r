@@ -305,12 +305,21 @@ filter_.tbl_cube <- function(.data, ..., .dots) {
 
   idx <- vapply(dots, function(d) find_index_check(d$expr, names(.data$dims)),
     integer(1))
+
+  # Conditions only touch the (small) dimensions, the positions they keep
+  # are accumulated so that each measure is subset once
+  keep <- lapply(.data$dims, seq_along)
   for(i in seq_along(dots)) {
     sel <- eval(dots[[i]]$expr, .data$dims, dots[[i]]$env)
     sel <- sel & !is.na(sel)
 
     .data$dims[[idx[i]]] <- .data$dims[[idx[i]]][sel]
-    .data$mets <- lapply(.data$mets, subs_index, idx[i], sel)
+    keep[[idx[i]]] <- keep[[idx[i]]][sel]
+  }
+
+  if (length(dots) > 0) {
+    filtered <- unique(idx)
+    .data$mets <- lapply(.data$mets, subs_index, filtered, keep[filtered])
   }
 
   .data
@@ -370,6 +379,21 @@ summarise_.tbl_cube <- function(.data, ..., .dots) {
     out_mets[[nm]] <- array(logical(), n)
   }
 
+  # Simple reductions of a measure are computed in C++, in one pass over
+  # the measure for all groups
+  if (length(.data$groups) > 0) {
+    fast <- lapply(dots, function(dot) cube_reduction(dot$expr, .data))
+  } else {
+    fast <- vector("list", length(dots))
+  }
+  for (j in which(!vapply(fast, is.null, logical(1)))) {
+    out_mets[[j]] <- array(fast[[j]](.data), n)
+  }
+  slow <- which(vapply(fast, is.null, logical(1)))
+  if (length(slow) == 0) {
+    return(structure(list(dims = out_dims, mets = out_mets), class = "tbl_cube"))
+  }
+
   slices <- expand.grid(lapply(out_dims, seq_along), KEEP.OUT.ATTRS = FALSE)
 
   # Loop over each group
@@ -378,8 +402,8 @@ summarise_.tbl_cube <- function(.data, ..., .dots) {
     mets <- lapply(.data$mets, subs_index, i = .data$groups, val = index,
       drop = TRUE)
 
-    # Loop over each expression
-    for (j in seq_along(dots)) {
+    # Loop over each remaining expression
+    for (j in slow) {
       res <- eval(dots[[j]]$expr, mets, dots[[j]]$env)
       out_mets[[j]][i] <- res
     }
@@ -388,6 +412,43 @@ summarise_.tbl_cube <- function(.data, ..., .dots) {
   structure(list(dims = out_dims, mets = out_mets), class = "tbl_cube")
 }
 
+# Returns a function computing expr for all groups of the cube when expr is
+# n() or fun(measure) or fun(measure, na.rm = TRUE/FALSE) for one of the
+# reductions implemented in cube_summarise_impl(), NULL otherwise
+cube_reduction <- function(expr, .data) {
+  if (!is.call(expr) || !is.name(expr[[1]])) return(NULL)
+  fun <- as.character(expr[[1]])
+  args <- as.list(expr[-1])
+
+  if (fun == "n" && length(args) == 0) {
+    size <- prod(vapply(.data$dims[-.data$groups], length, integer(1)))
+    return(function(.data) as.integer(size))
+  }
+
+  if (!fun %in% c("sum", "mean", "min", "max", "var", "sd")) return(NULL)
+  if (length(args) == 0 || length(args) > 2) return(NULL)
+
+  arg_names <- names2(args)
+  if (arg_names[1] != "" || !is.name(args[[1]])) return(NULL)
+  measure <- .data$mets[[as.character(args[[1]])]]
+  if (!(is.integer(measure) || is.double(measure)) || is.object(measure)) {
+    return(NULL)
+  }
+
+  na.rm <- FALSE
+  if (length(args) == 2) {
+    if (arg_names[2] != "na.rm" || !is.logical(args[[2]]) ||
+        length(args[[2]]) != 1 || is.na(args[[2]])) {
+      return(NULL)
+    }
+    na.rm <- args[[2]]
+  }
+
+  function(.data) {
+    cube_summarise_impl(measure, .data$groups, fun, na.rm)
+  }
+}
+
 subs_index <- function(x, i, val, drop = FALSE) {
   dims <- length(dim(x) %||% 1)
 
@@ -390,6 +390,10 @@ collect.tbl_sql <- function(x, ..., n = 1e5, warn_incomplete = TRUE) {
   }
 
   sql <- sql_render(x)
+  if (n < 0 || n > 1e5) {
+    return(collect_paged(x, sql, n, warn_incomplete))
+  }
+
   res <- dbSendQuery(x$src$con, sql)
   on.exit(dbClearResult(res))
 
@@ -401,6 +405,27 @@ collect.tbl_sql <- function(x, ..., n = 1e5, warn_incomplete = TRUE) {
   grouped_df(out, groups(x))
 }
 
+# Large results are fetched one page at a time. Pages are copied into
+# growable columns as they arrive and the group index is updated with each
+# page, so there is never more than one page in flight on top of the result.
+collect_paged <- function(x, sql, n = -1L, warn_incomplete = TRUE,
+                          page_size = 1e5) {
+  vars <- vapply(groups(x), as.character, character(1))
+  builder <- paged_collecter(vars)
+
+  query <- query(x$src$con, sql, op_vars(x))
+  query$fetch_paged(page_size, function(chunk) {
+    paged_collecter_push(builder, chunk)
+  }, n = n, warn_incomplete = warn_incomplete)
+
+  out <- paged_collecter_get(builder)
+  if (is.null(out)) {
+    # no rows, fetch the empty result to get the column types
+    out <- grouped_df(query$fetch(0L), groups(x))
+  }
+  out
+}
+
 # Do ---------------------------------------------------------------------------
 
 #' @export
@@ -430,46 +455,35 @@ do_.tbl_sql <- function(.data, ..., .dots, .chunk_size = 1e4L) {
   p <- progress_estimated(n * m, min_time = 2)
   env <- new.env(parent = lazyeval::common_env(args))
 
-  # Create ungrouped data frame suitable for chunked retrieval
-  query <- query(.data$src$con, sql_render(ungroup(.data)), op_vars(.data))
+  # Retrieve rows sorted by the grouping variables, so that each group is
+  # a run of adjacent rows. A group can span several pages: the splitter
+  # holds on to the last group of each page until it sees where it ends.
+  sorted <- arrange_(ungroup(.data), .dots = group_by)
+  query <- query(.data$src$con, sql_render(sorted), op_vars(.data))
+  splitter <- group_splitter(vapply(group_by, as.character, character(1)))
 
-  # When retrieving in pages, there's no guarantee we'll get a complete group.
-  # So we always assume the last group in the chunk is incomplete, and leave
-  # it for the next. If the group size is large than chunk size, it may
-  # take a couple of iterations to get the entire group, but that should
-  # be an unusual situation.
-  last_group <- NULL
   i <- 0
-  gvars <- seq_along(group_by)
-
-  query$fetch_paged(.chunk_size, function(chunk) {
-    if (!is.null(last_group)) {
-      chunk <- rbind(last_group, chunk)
+  process <- function(group) {
+    i <<- i + 1
+    env$. <- group
+    for (k in seq_len(m)) {
+      out[[k]][i] <<- list(eval(args[[k]]$expr, envir = env))
+      p$tick()$print()
     }
+  }
 
-    # Create an id for each group
-    grouped <- chunk %>% group_by_(.dots = names(chunk)[gvars])
-    index <- attr(grouped, "indices") # zero indexed
-
-    last_group <<- chunk[index[[length(index)]] + 1L, , drop = FALSE]
-
-    for (j in seq_len(n - 1)) {
-      env$. <- chunk[index[[j]] + 1L, , drop = FALSE]
-      for (k in seq_len(m)) {
-        out[[k]][i + j] <<- list(eval(args[[k]]$expr, envir = env))
-        p$tick()$print()
-      }
-    }
-    i <<- i + (n - 1)
+  query$fetch_paged(.chunk_size, function(chunk) {
+    lapply(group_splitter_push(splitter, chunk), process)
   })
-
-  # Process last group
+  last_group <- group_splitter_flush(splitter)
   if (!is.null(last_group)) {
-    env$. <- last_group
-    for (k in seq_len(m)) {
-      out[[k]][i + 1] <- list(eval(args[[k]]$expr, envir = env))
-      p$tick()$print()
-    }
+    process(last_group)
+  }
+
+  # Labels in the order the groups were seen
+  if (i > 0) {
+    labels <- group_splitter_labels(splitter)
+    out <- lapply(out, `[`, seq_len(i))
   }
 
   if (!named) {
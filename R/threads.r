@@ -0,0 +1,45 @@
+#' Number of threads used by dplyr
+#'
+#' Some computations of dplyr's C++ code can be split between several
+#' threads, e.g. \code{summarise()} of a large grouped \code{tbl_cube}, or
+#' \code{sum()}, \code{mean()}, \code{var()}, \code{sd()}, \code{min()} and
+#' \code{max()} over many rows of a data frame. The number of threads is the
+#' \code{dplyr.threads} option, which is set from the \code{DPLYR_NUM_THREADS}
+#' environment variable when dplyr is loaded, and is 1 by default. Only one
+#' thread is used when dplyr was not compiled with OpenMP.
+#'
+#' @param n Number of threads. If \code{NULL}, the number is not changed.
+#' @param code Code to run with \code{n} threads.
+#' @return \code{dplyr_threads()} returns the number of threads that dplyr
+#'   uses, or the previous value of the option, invisibly, when \code{n} is
+#'   given. \code{with_dplyr_threads()} returns the value of \code{code}.
+#' @export
+#' @examples
+#' dplyr_threads()
+#' by_year <- group_by(nasa, year)
+#' with_dplyr_threads(2, summarise(by_year, ozone = mean(ozone)))
+dplyr_threads <- function(n = NULL) {
+  if (is.null(n)) {
+    return(threads_impl())
+  }
+  if (!is.numeric(n) || length(n) != 1 || is.na(n) || n < 1) {
+    stop("`n` must be a single number, at least 1", call. = FALSE)
+  }
+
+  old <- getOption("dplyr.threads")
+  options(dplyr.threads = as.integer(n))
+  invisible(old)
+}
+
+#' @export
+#' @rdname dplyr_threads
+with_dplyr_threads <- function(n, code) {
+  old <- dplyr_threads(n)
+  on.exit(options(dplyr.threads = old))
+  code
+}
+
+default_threads <- function() {
+  n <- suppressWarnings(as.integer(Sys.getenv("DPLYR_NUM_THREADS", "1")))
+  if (is.na(n) || n < 1) 1L else n
+}
@@ -2,7 +2,10 @@
   op <- options()
   op.dplyr <- list(
     dplyr.strict_sql = FALSE,
-    dplyr.show_progress = TRUE
+    dplyr.show_progress = TRUE,
+    dplyr.string_cache_size = 1e6,
+    dplyr.group_index_cache_size = 0,
+    dplyr.threads = default_threads()
   )
   toset <- !(names(op.dplyr) %in% names(op))
   if(any(toset)) options(op.dplyr[toset])
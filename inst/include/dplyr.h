@@ -21,6 +21,8 @@ using namespace Rcpp ;
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/functional/hash.hpp>
+#include <clocale>
+#include <Rcpp/Benchmark/Timer.h>
 
 #ifndef dplyr_hash_map
     #if defined(_WIN32)
@@ -63,9 +65,15 @@ dplyr::Result* get_handler( SEXP, const dplyr::LazySubsets&, const Environment&
 dplyr::Result* nth_prototype( SEXP call, const dplyr::LazySubsets& subsets, int nargs) ;
 dplyr::Result* first_prototype( SEXP call, const dplyr::LazySubsets& subsets, int nargs) ;
 dplyr::Result* last_prototype( SEXP call, const dplyr::LazySubsets& subsets, int nargs) ;
+dplyr::Result* roll_sum_prototype( SEXP call, const dplyr::LazySubsets& subsets, int nargs) ;
+dplyr::Result* roll_mean_prototype( SEXP call, const dplyr::LazySubsets& subsets, int nargs) ;
+dplyr::Result* roll_min_prototype( SEXP call, const dplyr::LazySubsets& subsets, int nargs) ;
+dplyr::Result* roll_max_prototype( SEXP call, const dplyr::LazySubsets& subsets, int nargs) ;
+dplyr::Result* roll_sd_prototype( SEXP call, const dplyr::LazySubsets& subsets, int nargs) ;
 bool argmatch( const std::string& target, const std::string& s) ;
 
 bool can_simplify(SEXP) ;
+bool is_elementwise( SEXP, const dplyr::LazySubsets&, SEXP ) ;
 
 void assert_all_white_list(const DataFrame&) ;
 inline SEXP shared_SEXP(SEXP x){
@@ -110,6 +118,10 @@ typedef dplyr::Result* (*HybridHandler)(SEXP, const dplyr::LazySubsets&, int) ;
 
 #if defined(COMPILING_DPLYR)
     DataFrame build_index_cpp( DataFrame data ) ;
+    DataFrame build_index_adj( DataFrame data, ListOf<Symbol> symbols ) ;
+    DataFrame build_index_sorted( DataFrame data, const CharacterVector& vars ) ;
+    bool build_index_direct( DataFrame& data, const CharacterVector& vars ) ;
+    void set_adjacent_index( DataFrame& data, const std::vector<int>& sizes, DataFrame labels ) ;
     void registerHybridHandler( const char* , HybridHandler ) ;
     SEXP get_time_classes() ;
     SEXP get_date_classes() ;
@@ -118,6 +130,8 @@ typedef dplyr::Result* (*HybridHandler)(SEXP, const dplyr::LazySubsets&, int) ;
 #include <dplyr/registration.h>
 
 #include <dplyr/DataFrameAble.h>
+#include <dplyr/StringCache.h>
+#include <dplyr/GroupIndexCache.h>
 #include <dplyr/CharacterVectorOrderer.h>
 #include <dplyr/white_list.h>
 #include <dplyr/check_supported_type.h>
@@ -131,6 +145,7 @@ typedef dplyr::Result* (*HybridHandler)(SEXP, const dplyr::LazySubsets&, int) ;
 #include <dplyr/GroupedDataFrame.h>
 #include <dplyr/RowwiseDataFrame.h>
 #include <dplyr/tbl_cpp.h>
+#include <dplyr/Profiler.h>
 #include <dplyr/comparisons.h>
 #include <dplyr/comparisons_different.h>
 #include <dplyr/VectorVisitor.h>
@@ -138,6 +153,7 @@ typedef dplyr::Result* (*HybridHandler)(SEXP, const dplyr::LazySubsets&, int) ;
 #include <dplyr/OrderVisitor.h>
 #include <dplyr/VectorVisitorImpl.h>
 #include <dplyr/SubsetVectorVisitorImpl.h>
+#include <dplyr/PackedKeys.h>
 #include <dplyr/DataFrameVisitors.h>
 #include <dplyr/MultipleVectorVisitors.h>
 #include <dplyr/DataFrameSubsetVisitors.h>
@@ -148,10 +164,15 @@ typedef dplyr::Result* (*HybridHandler)(SEXP, const dplyr::LazySubsets&, int) ;
 #include <dplyr/subset_visitor.h>
 #include <dplyr/visitor.h>
 #include <dplyr/OrderVisitorImpl.h>
+#include <dplyr/StringDictionary.h>
 #include <dplyr/JoinVisitor.h>
 #include <dplyr/JoinVisitorImpl.h>
 #include <dplyr/DataFrameJoinVisitors.h>
+#include <dplyr/ExecutionContext.h>
+#include <dplyr/RowPartitions.h>
 #include <dplyr/Order.h>
+#include <dplyr/SortedKeys.h>
+#include <dplyr/DirectIndex.h>
 #include <dplyr/SummarisedVariable.h>
 #include <dplyr/Result/all.h>
 #include <dplyr/vector_class.h>
@@ -160,6 +181,11 @@ typedef dplyr::Result* (*HybridHandler)(SEXP, const dplyr::LazySubsets&, int) ;
 #include <dplyr/Collecter.h>
 #include <dplyr/NamedListAccumulator.h>
 #include <dplyr/train.h>
+#include <dplyr/DataFrameCollecter.h>
+#include <dplyr/GroupSplitter.h>
+#include <dplyr/ExternalSummariser.h>
+#include <dplyr/MappedTable.h>
+#include <dplyr/HashIndex.h>
 
 void check_not_groups(const CharacterVector& result_names, const GroupedDataFrame& gdf) ;
 void check_not_groups(const CharacterVector& result_names, const RowwiseDataFrame& gdf) ;
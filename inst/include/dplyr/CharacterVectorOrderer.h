@@ -3,6 +3,8 @@
 
 namespace dplyr {
 
+    // ranks of the strings of a character vector, in sort() order. Only the
+    // relative order of the ranks is meaningful
     class CharacterVectorOrderer {
     public:
 
@@ -14,7 +16,6 @@ namespace dplyr {
 
     private:
         CharacterVector data ;
-        dplyr_hash_set<SEXP> set ;
         IntegerVector orders ;
     } ;
 
@@ -3,6 +3,20 @@
 
 namespace dplyr {
 
+    // target[index[i]] = source[i]. When binding, the index is the range of
+    // rows of a chunk, so this is a plain copy
+    template <typename STORAGE>
+    inline void collect_index( STORAGE* target, const SlicingIndex& index, const STORAGE* source ){
+        int n = index.size() ;
+        if( index.contiguous() ){
+            std::copy( source, source + n, target + index.start() ) ;
+        } else {
+            for( int i=0; i<n; i++){
+                target[index[i]] = source[i] ;
+            }
+        }
+    }
+
     class Collecter {
     public:
         virtual ~Collecter(){} ;
@@ -29,8 +43,13 @@ namespace dplyr {
         void collect( const SlicingIndex& index, SEXP v ){
             Vector<RTYPE> source(v) ;
             STORAGE* source_ptr = Rcpp::internal::r_vector_start<RTYPE>(source) ;
-            for( int i=0; i<index.size(); i++){
-                data[index[i]] = source_ptr[i] ;
+            if( RTYPE == VECSXP ){
+                // list elements must go through the write barrier
+                for( int i=0; i<index.size(); i++){
+                    data[index[i]] = source_ptr[i] ;
+                }
+            } else {
+                collect_index( Rcpp::internal::r_vector_start<RTYPE>(data), index, source_ptr ) ;
             }
         }
 
@@ -65,10 +84,7 @@ namespace dplyr {
 
         void collect( const SlicingIndex& index, SEXP v ){
             NumericVector source(v) ;
-            double* source_ptr = source.begin() ;
-            for( int i=0; i<index.size(); i++){
-                data[index[i]] = source_ptr[i] ;
-            }
+            collect_index( data.begin(), index, source.begin() ) ;
         }
 
         inline SEXP get(){
@@ -133,10 +149,7 @@ namespace dplyr {
         void collect_strings( const SlicingIndex& index, CharacterVector source){
             SEXP* p_source = Rcpp::internal::r_vector_start<STRSXP>(source) ;
             SEXP* p_data   = Rcpp::internal::r_vector_start<STRSXP>(data) ;
-            int n = index.size() ;
-            for( int i=0; i<n; i++){
-                p_data[index[i]] = p_source[i] ;
-            }
+            collect_index( p_data, index, p_source ) ;
         }
 
         void collect_factor( const SlicingIndex& index, IntegerVector source ){
@@ -159,10 +172,7 @@ namespace dplyr {
 
         void collect( const SlicingIndex& index, SEXP v ){
             IntegerVector source(v) ;
-            int* source_ptr = source.begin() ;
-            for( int i=0; i<index.size(); i++){
-                data[index[i]] = source_ptr[i] ;
-            }
+            collect_index( data.begin(), index, source.begin() ) ;
         }
 
         inline SEXP get(){
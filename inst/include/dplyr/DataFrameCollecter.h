@@ -0,0 +1,329 @@
+#ifndef dplyr_DataFrameCollecter_H
+#define dplyr_DataFrameCollecter_H
+
+namespace dplyr {
+
+    // identifies the group of a row by the values of the grouping variables,
+    // comparable across pages. Strings (and factor levels) are identified by
+    // their CHARSXP, numbers by their value as a double, so that a column
+    // promoted from one page to the next keeps the same keys. With by_value,
+    // strings are identified by their UTF-8 bytes instead, so that keys can
+    // be written to disk and read back by read_group_key(), and NA of any
+    // type gives the same key, as a column of logical NA may be combined
+    // with columns of any type
+    class GroupKeyBuilder {
+    public:
+        GroupKeyBuilder( const std::vector<SEXP>& columns_, bool by_value_ = false ) :
+            columns(columns_), levels(columns_.size(), R_NilValue), by_value(by_value_)
+        {
+            for( size_t j=0; j<columns.size(); j++){
+                SEXP x = columns[j] ;
+                if( Rf_inherits( x, "factor" ) ){
+                    levels[j] = Rf_getAttrib( x, R_LevelsSymbol ) ;
+                } else if( TYPEOF(x) != LGLSXP && TYPEOF(x) != INTSXP && TYPEOF(x) != REALSXP && TYPEOF(x) != STRSXP ){
+                    stop( "cannot group column of class '%s'", get_single_class(x) ) ;
+                }
+            }
+        }
+
+        inline void key( int i, std::string& out ) const {
+            out.clear() ;
+            for( size_t j=0; j<columns.size(); j++){
+                SEXP x = columns[j] ;
+                switch( TYPEOF(x) ){
+                case LGLSXP:
+                case INTSXP:
+                    {
+                        int value = INTEGER(x)[i] ;
+                        if( levels[j] != R_NilValue ){
+                            append_string( out, value == NA_INTEGER ? NA_STRING : STRING_ELT(levels[j], value - 1) ) ;
+                        } else {
+                            append_number( out, value == NA_INTEGER ? NA_REAL : (double)value ) ;
+                        }
+                        break ;
+                    }
+                case REALSXP:
+                    append_number( out, REAL(x)[i] ) ;
+                    break ;
+                case STRSXP:
+                    append_string( out, STRING_ELT(x, i) ) ;
+                    break ;
+                default:
+                    break ;
+                }
+            }
+        }
+
+    private:
+        inline void append_number( std::string& out, double value ) const {
+            if( by_value && R_IsNA(value) ){
+                out.push_back('a') ;
+                return ;
+            }
+            if( R_IsNA(value) ) value = NA_REAL ;
+            else if( R_IsNaN(value) ) value = R_NaN ;
+            else if( value == 0.0 ) value = 0.0 ;
+            out.push_back('n') ;
+            out.append( reinterpret_cast<const char*>(&value), sizeof(double) ) ;
+        }
+
+        inline void append_string( std::string& out, SEXP s ) const {
+            if( by_value && s == NA_STRING ){
+                out.push_back('a') ;
+                return ;
+            }
+            out.push_back('s') ;
+            if( !by_value ){
+                out.append( reinterpret_cast<const char*>(&s), sizeof(SEXP) ) ;
+                return ;
+            }
+            // the length, then the bytes
+            const char* chars = Rf_translateCharUTF8(s) ;
+            int n = strlen(chars) ;
+            out.append( reinterpret_cast<const char*>(&n), sizeof(int) ) ;
+            out.append( chars, n ) ;
+        }
+
+        const std::vector<SEXP>& columns ;
+        std::vector<SEXP> levels ;
+        bool by_value ;
+    } ;
+
+    // the values of a key made by a GroupKeyBuilder with by_value, into
+    // element i of the columns, whose types say how numbers are read back
+    inline void read_group_key( const std::string& key, const std::vector<SEXP>& columns, int i ){
+        const char* p = key.data() ;
+        for( size_t j=0; j<columns.size(); j++){
+            SEXP x = columns[j] ;
+            char tag = *p++ ;
+            if( tag == 'a' ){
+                switch( TYPEOF(x) ){
+                case LGLSXP:
+                case INTSXP: INTEGER(x)[i] = NA_INTEGER ; break ;
+                case REALSXP: REAL(x)[i] = NA_REAL ; break ;
+                case STRSXP: SET_STRING_ELT( x, i, NA_STRING ) ; break ;
+                default: stop( "incompatible key" ) ;
+                }
+            } else if( tag == 'n' ){
+                double value ;
+                memcpy( &value, p, sizeof(double) ) ;
+                p += sizeof(double) ;
+                switch( TYPEOF(x) ){
+                case LGLSXP:
+                case INTSXP: INTEGER(x)[i] = R_IsNA(value) ? NA_INTEGER : (int)value ; break ;
+                case REALSXP: REAL(x)[i] = value ; break ;
+                default: stop( "incompatible key" ) ;
+                }
+            } else {
+                int n ;
+                memcpy( &n, p, sizeof(int) ) ;
+                p += sizeof(int) ;
+                if( TYPEOF(x) != STRSXP ) stop( "incompatible key" ) ;
+                SET_STRING_ELT( x, i, Rf_mkCharLenCE( p, n, CE_UTF8 ) ) ;
+                p += n ;
+            }
+        }
+    }
+
+    // builds a data frame from pages of rows that arrive one at a time, e.g.
+    // fetched from a database. Each column is a Collecter whose capacity grows
+    // geometrically, so pages are copied once (plus amortised regrowth) instead
+    // of being bound together at the end. When grouping variables are given,
+    // the group index is updated with each page.
+    class DataFrameCollecter {
+    public:
+        typedef dplyr_hash_map<std::string,int> GroupMap ;
+
+        DataFrameCollecter( const CharacterVector& vars_ ) :
+            columns(), names(), vars(vars_), nrows(0), capacity(0), npages(0),
+            group_map(), chunks(), first_row()
+        {}
+
+        void push( const DataFrame& page ){
+            int ncol = page.size() ;
+            int n = page.nrows() ;
+            CharacterVector page_names = page.names() ;
+
+            if( npages == 0 ){
+                names = page_names ;
+                for( int j=0; j<ncol; j++){
+                    columns.push_back( collecter( page[j], std::max(n, 1) ) ) ;
+                }
+                capacity = std::max(n, 1) ;
+                resolve_groups() ;
+            } else if( ncol != (int)columns.size() ){
+                stop( "incompatible number of columns (%d, expecting %d)", ncol, columns.size() ) ;
+            }
+            npages++ ;
+
+            reserve( nrows + n ) ;
+            for( int j=0; j<ncol; j++){
+                collect_column( j, page[j], n ) ;
+            }
+            train_groups( page, n ) ;
+            nrows += n ;
+        }
+
+        inline int size() const { return nrows ; }
+        inline int pages() const { return npages ; }
+
+        DataFrame get(){
+            int ncol = columns.size() ;
+            List out(ncol) ;
+            for( int j=0; j<ncol; j++){
+                out[j] = shrink( columns[j]->get() ) ;
+            }
+            out.names() = names ;
+            set_rownames( out, nrows ) ;
+
+            if( !vars.size() ){
+                out.attr( "class" ) = classes_not_grouped() ;
+                return out ;
+            }
+            return structure_groups( out ) ;
+        }
+
+    private:
+
+        void reserve( int n ){
+            if( n <= capacity ) return ;
+            int new_capacity = std::max( n, 2 * capacity ) ;
+            int ncol = columns.size() ;
+            for( int j=0; j<ncol; j++){
+                SEXP data = columns[j]->get() ;
+                Collecter* bigger = collecter( data, new_capacity ) ;
+                bigger->collect( SlicingIndex(0, nrows), data ) ;
+                delete columns[j] ;
+                columns[j] = bigger ;
+            }
+            capacity = new_capacity ;
+        }
+
+        // same logic as rbind_all
+        void collect_column( int j, SEXP source, int n ){
+            Collecter* coll = columns[j] ;
+            if( coll->compatible(source) ){
+                coll->collect( SlicingIndex(nrows, n), source ) ;
+            } else if( coll->can_promote(source) ){
+                Collecter* new_collecter = promote_collecter( source, capacity, coll ) ;
+                new_collecter->collect( SlicingIndex(nrows, n), source ) ;
+                new_collecter->collect( SlicingIndex(0, nrows), coll->get() ) ;
+                delete coll ;
+                columns[j] = new_collecter ;
+            } else if( all_na(source) ){
+                // the collecter is already initialized with the right NA
+            } else if( coll->is_logical_all_na() ){
+                Collecter* new_collecter = collecter( source, capacity ) ;
+                new_collecter->collect( SlicingIndex(nrows, n), source ) ;
+                delete coll ;
+                columns[j] = new_collecter ;
+            } else {
+                std::string column_name( CHAR(STRING_ELT(names, j)) ) ;
+                stop(
+                  "Can not automatically convert from %s to %s in column \"%s\".",
+                  coll->describe(), get_single_class(source), column_name
+                ) ;
+            }
+        }
+
+        void resolve_groups(){
+            int nvars = vars.size() ;
+            group_columns.resize(nvars) ;
+            for( int i=0; i<nvars; i++){
+                int pos = -1 ;
+                for( int j=0; j<names.size(); j++){
+                    if( STRING_ELT(names, j) == STRING_ELT(vars, i) ){
+                        pos = j ;
+                        break ;
+                    }
+                }
+                if( pos < 0 ) stop( "unknown column '%s' ", CHAR(STRING_ELT(vars, i)) ) ;
+                group_columns[i] = pos ;
+            }
+        }
+
+        void train_groups( const DataFrame& page, int n ){
+            int nvars = group_columns.size() ;
+            if( !nvars ) return ;
+
+            std::vector<SEXP> keys_data(nvars) ;
+            for( int i=0; i<nvars; i++) keys_data[i] = page[ group_columns[i] ] ;
+            GroupKeyBuilder builder( keys_data ) ;
+
+            std::string key ;
+            for( int i=0; i<n; i++){
+                builder.key( i, key ) ;
+                GroupMap::iterator it = group_map.find(key) ;
+                int g ;
+                if( it == group_map.end() ){
+                    g = chunks.size() ;
+                    group_map.insert( std::make_pair(key, g) ) ;
+                    chunks.push_back( std::vector<int>() ) ;
+                    first_row.push_back( nrows + i ) ;
+                } else {
+                    g = it->second ;
+                }
+                chunks[g].push_back( nrows + i ) ;
+            }
+        }
+
+        // same structure as build_index_cpp, with groups sorted by labels
+        DataFrame structure_groups( List out ){
+            int nvars = vars.size() ;
+            List symbols(nvars) ;
+            for( int i=0; i<nvars; i++){
+                symbols[i] = Rf_installChar( vars[i] ) ;
+            }
+            out.attr( "vars" ) = symbols ;
+            out.attr( "drop" ) = true ;
+            // a data frame already, so that DataFrame does not go through
+            // as.data.frame(), which would drop the attributes
+            out.attr( "class" ) = classes_not_grouped() ;
+            DataFrame data(out) ;
+
+            DataFrame labels = DataFrameSubsetVisitors(data, vars).subset( first_row, "data.frame") ;
+            int ngroups = labels.nrows() ;
+            IntegerVector labels_order = OrderVisitors(labels).apply() ;
+            labels = DataFrameSubsetVisitors(labels).subset(labels_order, "data.frame" ) ;
+
+            List indices(ngroups) ;
+            IntegerVector group_sizes = no_init( ngroups );
+            int biggest_group = 0 ;
+            for( int i=0; i<ngroups; i++){
+                const std::vector<int>& chunk = chunks[ labels_order[i] ] ;
+                indices[i] = chunk ;
+                group_sizes[i] = chunk.size() ;
+                biggest_group = std::max( biggest_group, (int)chunk.size() );
+            }
+
+            data.attr( "indices" ) = indices ;
+            data.attr( "group_sizes") = group_sizes ;
+            data.attr( "biggest_group_size" ) = biggest_group ;
+            data.attr( "labels" ) = labels ;
+            data.attr( "class" ) = classes_grouped<GroupedDataFrame>() ;
+            return data ;
+        }
+
+        inline SEXP shrink( SEXP x ){
+            if( Rf_length(x) == nrows ) return x ;
+            Shield<SEXP> out( Rf_lengthgets(x, nrows) ) ;
+            copy_most_attributes( out, x ) ;
+            return out ;
+        }
+
+        pointer_vector<Collecter> columns ;
+        CharacterVector names ;
+        CharacterVector vars ;
+        std::vector<int> group_columns ;
+        int nrows ;
+        int capacity ;
+        int npages ;
+
+        GroupMap group_map ;
+        std::vector< std::vector<int> > chunks ;
+        std::vector<int> first_row ;
+    } ;
+
+}
+
+#endif
@@ -32,6 +32,22 @@ namespace dplyr{
             return nvisitors ;
         }
 
+        // keys of several whole number columns are hashed and compared by
+        // their packed keys, packed by the first hash
+        inline bool packed() const {
+            return keys.packed() ;
+        }
+
+        inline size_t hash( int j ) const {
+            if( keys.packed() ) return keys.hash(j) ;
+            return VisitorSetHash<DataFrameJoinVisitors>::hash(j) ;
+        }
+
+        inline bool equal( int i, int j ) const {
+            if( keys.ready() ) return keys.equal(i, j) ;
+            return VisitorSetEqual<DataFrameJoinVisitors>::equal(i, j) ;
+        }
+
         template <typename Container>
         inline DataFrame subset( const Container& index, const CharacterVector& classes ){
             int nrows = index.size() ;
@@ -60,6 +76,7 @@ namespace dplyr{
         int nvisitors ;
         pointer_vector<JoinVisitor> visitors ;
         bool warn ;
+        mutable PackedKeys keys ;
 
     } ;
 
@@ -15,6 +15,7 @@ namespace dplyr {
             pointer_vector<VectorVisitor> visitors ;
             Rcpp::CharacterVector visitor_names ;
             int nvisitors ;
+            mutable PackedKeys keys ;
 
         public:
             typedef VectorVisitor visitor_type ;
@@ -30,9 +31,27 @@ namespace dplyr {
 
             inline int nrows() const { return data.nrows() ; }
 
+            // rows of several whole number columns are hashed and compared
+            // by their packed keys, packed by the first hash
+            inline size_t hash( int j ) const {
+                if( keys.packed() ) return keys.hash(j) ;
+                return VisitorSetHash<DataFrameVisitors>::hash(j) ;
+            }
+
+            inline bool equal( int i, int j ) const {
+                if( keys.ready() ) return keys.equal(i, j) ;
+                return VisitorSetEqual<DataFrameVisitors>::equal(i, j) ;
+            }
+
+            inline bool equal_or_both_na( int i, int j ) const {
+                if( keys.ready() ) return keys.equal(i, j) ;
+                return VisitorSetEqual<DataFrameVisitors>::equal_or_both_na(i, j) ;
+            }
+
         private:
 
             void structure( List& x, int nrows, CharacterVector classes ) const  ;
+            void pack_keys( const std::vector<SEXP>& columns ) ;
 
     } ;
 
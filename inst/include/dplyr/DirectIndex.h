@@ -0,0 +1,126 @@
+#ifndef dplyr_DirectIndex_H
+#define dplyr_DirectIndex_H
+
+namespace dplyr {
+
+    // an integer vector compared by value: a bare integer vector, or when
+    // factors is true a factor, whose codes are compared
+    inline bool direct_key( SEXP x, bool factors ){
+        if( TYPEOF(x) != INTSXP || !Rf_isNull( Rf_getAttrib(x, R_DimSymbol) ) ) return false ;
+        if( Rf_isNull( Rf_getAttrib(x, R_ClassSymbol) ) ) return true ;
+        return factors && Rf_isFactor(x) ;
+    }
+
+    // whether an array with one slot per value from min to max holds at
+    // most DPLYR_DIRECT_INDEX_RATIO slots per value of n values
+    inline bool dense_span( int min, int max, int n ){
+        double range = (double)max - (double)min + 1.0 ;
+        return range < INT_MAX - 1 && range <= (double)DPLYR_DIRECT_INDEX_RATIO * n ;
+    }
+
+    // the smallest and largest values of x, NA aside, and whether they are
+    // dense. When x only holds NA, min is 0 and max is -1
+    inline bool dense_range( const int* x, int n, int& min, int& max ){
+        min = INT_MAX ;
+        max = INT_MIN ;
+        for( int i=0; i<n; i++){
+            int value = x[i] ;
+            if( value == NA_INTEGER ) continue ;
+            if( value < min ) min = value ;
+            if( value > max ) max = value ;
+        }
+        if( min > max ){
+            min = 0 ;
+            max = -1 ;
+            return true ;
+        }
+        return dense_span( min, max, n ) ;
+    }
+
+    // the rows of an integer vector by value, in an array indexed by the
+    // value minus the smallest value, rather than in a hash table. Slot s
+    // holds the rows, in order, of the value min + s, and the last slot the
+    // rows of NA, so the slots are in the order arrange() sorts the values.
+    //
+    // The rows are sorted by slot with a counting sort: start[s] is the
+    // position in rows of the first row of slot s, and start[s+1] the
+    // position after its last row
+    class DirectIndex {
+    public:
+
+        // the index of x, or 0 when its values are too sparse
+        static DirectIndex* make( SEXP x ){
+            const int* p = INTEGER(x) ;
+            int n = Rf_length(x) ;
+            int min, max ;
+            if( !dense_range( p, n, min, max ) ) return 0 ;
+            return new DirectIndex( p, n, min, max ) ;
+        }
+
+        // the slot of value, or -1 for a value outside of the range
+        inline int slot( int value ) const {
+            if( value == NA_INTEGER ) return nslots - 1 ;
+            if( value < min || value > max ) return -1 ;
+            return value - min ;
+        }
+
+        typedef std::vector<int>::const_iterator const_iterator ;
+
+        inline int slots() const { return nslots ; }
+        inline int size( int s ) const { return start[s+1] - start[s] ; }
+        inline const_iterator begin( int s ) const { return rows.begin() + start[s] ; }
+        inline const_iterator end( int s ) const { return rows.begin() + start[s+1] ; }
+
+    private:
+        DirectIndex( const int* x, int n, int min_, int max_ ) :
+            min(min_), max(max_), nslots( max_ - min_ + 2 ),
+            start( nslots + 1, 0 ), rows( n )
+        {
+            for( int i=0; i<n; i++) start[ slot(x[i]) + 1 ]++ ;
+            for( int s=0; s<nslots; s++) start[s+1] += start[s] ;
+            std::vector<int> next( start.begin(), start.end() - 1 ) ;
+            for( int i=0; i<n; i++) rows[ next[ slot(x[i]) ]++ ] = i ;
+        }
+
+        int min, max, nslots ;
+        std::vector<int> start ;
+        std::vector<int> rows ;
+
+        DirectIndex( const DirectIndex& ) ;
+        DirectIndex& operator=( const DirectIndex& ) ;
+    } ;
+
+    // the number of distinct values of x among the rows of indices, by
+    // flagging the slots of the values in an array, or -1 when the values
+    // are too sparse
+    template <typename Index>
+    int count_distinct_direct( const int* x, const Index& indices, bool na_rm, std::vector<bool>& seen ){
+        int n = indices.size() ;
+        int min = INT_MAX, max = INT_MIN ;
+        bool na = false ;
+        for( int i=0; i<n; i++){
+            int value = x[ indices[i] ] ;
+            if( value == NA_INTEGER ){
+                na = true ;
+                continue ;
+            }
+            if( value < min ) min = value ;
+            if( value > max ) max = value ;
+        }
+        int count = ( na && !na_rm ) ? 1 : 0 ;
+        if( min > max ) return count ;
+        if( !dense_span( min, max, n ) ) return -1 ;
+
+        seen.assign( max - min + 1, false ) ;
+        for( int i=0; i<n; i++){
+            int value = x[ indices[i] ] ;
+            if( value == NA_INTEGER || seen[ value - min ] ) continue ;
+            seen[ value - min ] = true ;
+            count++ ;
+        }
+        return count ;
+    }
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef dplyr_ExecutionContext_H
+#define dplyr_ExecutionContext_H
+
+namespace dplyr {
+
+    // runs loops of the C++ code on several threads. The pool of worker
+    // threads is the OpenMP runtime's, created the first time it is needed;
+    // without OpenMP everything runs on the main thread.
+    //
+    // Workers must not touch the R API, which is not thread safe: they fill
+    // plain buffers (or the data of vectors allocated beforehand), and the
+    // main thread builds R objects from them once run() returns. The main
+    // thread checks for interrupts between rounds, as iterate_with_interupts
+    // does, so long loops can still be interrupted.
+    class ExecutionContext {
+    public:
+        // the number of threads of the session, see dplyr_threads()
+        ExecutionContext() : nthreads( session_threads() ) {}
+
+        // a number of threads for one call
+        ExecutionContext( int nthreads_ ) : nthreads( std::max( nthreads_, 1 ) ) {}
+
+        inline int threads() const {
+            #ifdef _OPENMP
+            return nthreads ;
+            #else
+            return 1 ;
+            #endif
+        }
+
+        // the number of ranges that n iterations are split into, one per thread
+        inline int ranges( int n ) const {
+            return ranges( n, n ) ;
+        }
+
+        // the same for n iterations that together visit work elements, e.g.
+        // partitions of work rows in all
+        inline int ranges( int n, int work ) const {
+            if( work < DPLYR_MIN_PARALLEL_SIZE ) return 1 ;
+            return std::max( std::min( threads(), n ), 1 ) ;
+        }
+
+        // calls body( range, begin, end ) so that the calls for a range cover
+        // its iterations in order, with each range on its own thread. Errors
+        // in the workers are reported by the main thread
+        template <typename Body>
+        void run( int n, Body& body ) const {
+            run( n, n, body ) ;
+        }
+
+        // the same for n iterations that together visit work elements
+        template <typename Body>
+        void run( int n, int work, Body& body ) const {
+            int nranges = ranges(n, work) ;
+            int nrounds = work > DPLYR_MIN_INTERUPT_SIZE ? std::min( n, DPLYR_INTERUPT_TIMES ) : 1 ;
+
+            std::vector<int> bounds( nranges + 1 ) ;
+            for( int i=0; i<=nranges; i++) bounds[i] = (int)( (double)n * i / nranges ) ;
+
+            for( int round=0; round<nrounds; round++){
+                std::string error ;
+
+                #ifdef _OPENMP
+                #pragma omp parallel for num_threads(nranges) schedule(static, 1)
+                #endif
+                for( int i=0; i<nranges; i++){
+                    int size = bounds[i+1] - bounds[i] ;
+                    int begin = bounds[i] + (int)( (double)size * round / nrounds ) ;
+                    int end = bounds[i] + (int)( (double)size * (round + 1) / nrounds ) ;
+                    try {
+                        if( begin < end ) body( i, begin, end ) ;
+                    } catch( std::exception& e ){
+                        #ifdef _OPENMP
+                        #pragma omp critical (dplyr_execution_error)
+                        #endif
+                        error = e.what() ;
+                    } catch( ... ){
+                        #ifdef _OPENMP
+                        #pragma omp critical (dplyr_execution_error)
+                        #endif
+                        error = "unknown error in worker thread" ;
+                    }
+                }
+
+                if( !error.empty() ) stop( error ) ;
+                if( nrounds > 1 ) Rcpp::checkUserInterrupt() ;
+            }
+        }
+
+    private:
+
+        // the dplyr.threads option, set by dplyr_threads(), initially from the
+        // DPLYR_NUM_THREADS environment variable
+        static int session_threads(){
+            SEXP opt = Rf_GetOption1( Rf_install("dplyr.threads") ) ;
+            if( Rf_isNumeric(opt) && Rf_length(opt) == 1 ){
+                int n = Rf_asInteger(opt) ;
+                if( n != NA_INTEGER ) return std::max( n, 1 ) ;
+            }
+            return 1 ;
+        }
+
+        int nthreads ;
+    } ;
+
+}
+
+#endif
@@ -0,0 +1,516 @@
+#ifndef dplyr_ExternalSummariser_H
+#define dplyr_ExternalSummariser_H
+
+namespace dplyr {
+
+    // states are written to spill files as they are in memory, they only hold
+    // plain data. Spill files are only read back by the process that wrote them
+    template <typename State>
+    inline void write_state( FILE* file, const State& state ){
+        if( fwrite( &state, sizeof(State), 1, file ) != 1 ) stop( "cannot write spill file" ) ;
+    }
+
+    template <typename State>
+    inline void read_state( FILE* file, State& state ){
+        if( fread( &state, sizeof(State), 1, file ) != 1 ) stop( "corrupt spill file" ) ;
+    }
+
+    template <typename State>
+    inline double state_bytes( const State& ){
+        return sizeof(State) ;
+    }
+
+    // the set of values of n_distinct(): missing doubles, then the number of
+    // values and the values
+    template <int RTYPE, bool NA_RM>
+    inline void write_state( FILE* file, const CountDistinctState<RTYPE,NA_RM>& state ){
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+        const dplyr_hash_set<STORAGE>& values = state.get_values() ;
+        std::vector<STORAGE> buffer( values.begin(), values.end() ) ;
+        int header[3] = { state.has_na(), state.has_nan(), (int)buffer.size() } ;
+        if( fwrite( header, sizeof(int), 3, file ) != 3 ) stop( "cannot write spill file" ) ;
+        if( buffer.size() && fwrite( &buffer[0], sizeof(STORAGE), buffer.size(), file ) != buffer.size() ){
+            stop( "cannot write spill file" ) ;
+        }
+    }
+
+    template <int RTYPE, bool NA_RM>
+    inline void read_state( FILE* file, CountDistinctState<RTYPE,NA_RM>& state ){
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+        int header[3] ;
+        if( fread( header, sizeof(int), 3, file ) != 3 ) stop( "corrupt spill file" ) ;
+        std::vector<STORAGE> buffer( header[2] ) ;
+        if( header[2] && fread( &buffer[0], sizeof(STORAGE), header[2], file ) != (size_t)header[2] ){
+            stop( "corrupt spill file" ) ;
+        }
+        if( header[0] ) state.add( Rcpp::traits::get_na<RTYPE>() ) ;
+        if( header[1] ) state.add( (STORAGE)R_NaN ) ;
+        for( int i=0; i<header[2]; i++) state.add( buffer[i] ) ;
+    }
+
+    template <int RTYPE, bool NA_RM>
+    inline double state_bytes( const CountDistinctState<RTYPE,NA_RM>& state ){
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+        // the nodes of the hash set
+        return sizeof(CountDistinctState<RTYPE,NA_RM>) + state.get_values().size() * ( sizeof(STORAGE) + 2 * sizeof(void*) ) ;
+    }
+
+    // an aggregate of a summarise() in chunks: the partial states of the
+    // groups, see ExternalSummariser
+    class ExternalAggregate {
+    public:
+        virtual ~ExternalAggregate(){}
+
+        // adds the rows of a chunk, groups[i] being the group of row i
+        virtual void update( SEXP x, const std::vector<int>& groups, int ngroups ) = 0 ;
+
+        virtual void write( FILE* file, int group ) const = 0 ;
+
+        // merges a state written by write() into the state of a group
+        virtual void read( FILE* file, int group, int ngroups ) = 0 ;
+
+        // approximate memory used by the states
+        virtual double bytes() const = 0 ;
+
+        virtual void clear() = 0 ;
+
+        // the result of each group
+        virtual SEXP finalize() const = 0 ;
+    } ;
+
+    // a reduction of chunks of numbers: the states of integers while the
+    // chunks are logical or integer, converted to the states of doubles by the
+    // first chunk of doubles, so that no double is truncated. Each spilled
+    // state is preceded by its type, as the states of a group can be spilled
+    // both before and after the conversion
+    template <template <int,bool> class State, bool NA_RM>
+    class ExternalReduction : public ExternalAggregate {
+    public:
+        typedef State<INTSXP,NA_RM> IntegerState ;
+        typedef State<REALSXP,NA_RM> DoubleState ;
+
+        ExternalReduction( bool doubles_ ) : integers(), doubles(), promoted(doubles_) {}
+
+        void update( SEXP x, const std::vector<int>& groups, int ngroups ){
+            if( !promoted && TYPEOF(x) == REALSXP ) promote() ;
+            if( promoted ){
+                add<REALSXP>( doubles, x, groups, ngroups ) ;
+            } else {
+                add<INTSXP>( integers, x, groups, ngroups ) ;
+            }
+        }
+
+        void write( FILE* file, int group ) const {
+            int type = promoted ? REALSXP : INTSXP ;
+            if( fwrite( &type, sizeof(int), 1, file ) != 1 ) stop( "cannot write spill file" ) ;
+            if( promoted ){
+                write_state( file, doubles[group] ) ;
+            } else {
+                write_state( file, integers[group] ) ;
+            }
+        }
+
+        void read( FILE* file, int group, int ngroups ){
+            int type ;
+            if( fread( &type, sizeof(int), 1, file ) != 1 ) stop( "corrupt spill file" ) ;
+            if( type == REALSXP && !promoted ) promote() ;
+
+            if( type == REALSXP ){
+                DoubleState state ;
+                read_state( file, state ) ;
+                doubles.resize( ngroups ) ;
+                doubles[group].merge( state ) ;
+            } else {
+                IntegerState state ;
+                read_state( file, state ) ;
+                if( promoted ){
+                    doubles.resize( ngroups ) ;
+                    doubles[group].merge( DoubleState(state) ) ;
+                } else {
+                    integers.resize( ngroups ) ;
+                    integers[group].merge( state ) ;
+                }
+            }
+        }
+
+        double bytes() const {
+            double res = 0.0 ;
+            for( size_t i=0; i<integers.size(); i++) res += state_bytes( integers[i] ) ;
+            for( size_t i=0; i<doubles.size(); i++) res += state_bytes( doubles[i] ) ;
+            return res ;
+        }
+
+        void clear(){
+            std::vector<IntegerState>().swap( integers ) ;
+            std::vector<DoubleState>().swap( doubles ) ;
+        }
+
+        SEXP finalize() const {
+            return promoted ? finalize( doubles ) : finalize( integers ) ;
+        }
+
+    private:
+
+        template <int RTYPE, typename S>
+        static void add( std::vector<S>& states, SEXP x, const std::vector<int>& groups, int ngroups ){
+            typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+            states.resize( ngroups ) ;
+            // e.g. logicals in a chunk and integers in the next one
+            Shield<SEXP> column( Rf_coerceVector( x, RTYPE ) ) ;
+            STORAGE* ptr = Rcpp::internal::r_vector_start<RTYPE>(column) ;
+            int n = groups.size() ;
+            for( int i=0; i<n; i++) states[ groups[i] ].add( ptr[i] ) ;
+        }
+
+        template <typename S>
+        static SEXP finalize( const std::vector<S>& states ){
+            typedef typename Rcpp::traits::storage_type<S::OUTPUT>::type OUTPUT_STORAGE ;
+            int n = states.size() ;
+            Shield<SEXP> out( Rf_allocVector( S::OUTPUT, n ) ) ;
+            OUTPUT_STORAGE* ptr = Rcpp::internal::r_vector_start<S::OUTPUT>(out) ;
+            for( int i=0; i<n; i++) ptr[i] = states[i].finalize() ;
+            return out ;
+        }
+
+        // the states so far, as states of doubles
+        void promote(){
+            int n = integers.size() ;
+            doubles.resize( n ) ;
+            for( int i=0; i<n; i++) doubles[i] = DoubleState( integers[i] ) ;
+            std::vector<IntegerState>().swap( integers ) ;
+            promoted = true ;
+        }
+
+        std::vector<IntegerState> integers ;
+        std::vector<DoubleState> doubles ;
+        bool promoted ;
+    } ;
+
+    // n(), which does not look at the values
+    class ExternalCount : public ExternalAggregate {
+    public:
+        ExternalCount() : states() {}
+
+        void update( SEXP, const std::vector<int>& groups, int ngroups ){
+            states.resize( ngroups ) ;
+            int n = groups.size() ;
+            for( int i=0; i<n; i++) states[ groups[i] ].add() ;
+        }
+
+        void write( FILE* file, int group ) const {
+            write_state( file, states[group] ) ;
+        }
+
+        void read( FILE* file, int group, int ngroups ){
+            states.resize( ngroups ) ;
+            CountState state ;
+            read_state( file, state ) ;
+            states[group].merge( state ) ;
+        }
+
+        double bytes() const {
+            return states.size() * (double)sizeof(CountState) ;
+        }
+
+        void clear(){
+            std::vector<CountState>().swap( states ) ;
+        }
+
+        SEXP finalize() const {
+            int n = states.size() ;
+            IntegerVector out = no_init(n) ;
+            for( int i=0; i<n; i++) out[i] = states[i].finalize() ;
+            return out ;
+        }
+
+    private:
+        std::vector<CountState> states ;
+    } ;
+
+    template <template <int,bool> class State>
+    ExternalAggregate* external_reduction( SEXP x, bool na_rm ){
+        if( Rf_isFactor(x) ) return 0 ;
+        switch( TYPEOF(x) ){
+        case LGLSXP:
+        case INTSXP:
+        case REALSXP:
+            {
+                bool doubles = TYPEOF(x) == REALSXP ;
+                if( na_rm ) return new ExternalReduction<State,true>( doubles ) ;
+                return new ExternalReduction<State,false>( doubles ) ;
+            }
+        default: break ;
+        }
+        return 0 ;
+    }
+
+    // the aggregate fun() of the column x, 0 if it is not supported
+    inline ExternalAggregate* external_aggregate( const std::string& fun, SEXP x, bool na_rm ){
+        if( fun == "n" ) return new ExternalCount() ;
+        if( fun == "sum" ) return external_reduction<SumState>( x, na_rm ) ;
+        if( fun == "mean" ) return external_reduction<MeanState>( x, na_rm ) ;
+        if( fun == "var" ) return external_reduction<VarState>( x, na_rm ) ;
+        if( fun == "sd" ) return external_reduction<SdState>( x, na_rm ) ;
+        if( fun == "min" ) return external_reduction<MinState>( x, na_rm ) ;
+        if( fun == "max" ) return external_reduction<MaxState>( x, na_rm ) ;
+        if( fun == "n_distinct" ) return external_reduction<CountDistinctState>( x, na_rm ) ;
+        return 0 ;
+    }
+
+    // a spill file, closed when it goes out of scope
+    class SpillFile {
+    public:
+        SpillFile( const std::string& path, const char* mode ) : file( fopen( path.c_str(), mode ) ) {}
+        ~SpillFile(){
+            if( file ) fclose(file) ;
+        }
+
+        inline FILE* get() const { return file ; }
+
+    private:
+        FILE* file ;
+
+        SpillFile( const SpillFile& ) ;
+        SpillFile& operator=( const SpillFile& ) ;
+    } ;
+
+    // grouped summarise() of data that comes in chunks, without holding more
+    // than a chunk in memory. The aggregates of each group are kept as
+    // partial states, updated with each chunk. When the groups and their
+    // states grow beyond a memory budget, they are spilled to files, one per
+    // hash partition of the keys, and the memory is released. At the end,
+    // the files of each partition are read back one at a time, the states of
+    // a group spilled several times being merged, so that only the groups of
+    // one partition are in memory at once.
+    class ExternalSummariser {
+    public:
+        ExternalSummariser( const CharacterVector& vars_, const List& specs_, const std::string& dir_, double budget_ ) :
+            vars(vars_), specs(specs_), dir(dir_), budget(budget_),
+            aggregates(), key_types(), index(), keys(), key_bytes(0.0), spills(0), nrows(0)
+        {}
+
+        ~ExternalSummariser(){
+            for( size_t k=0; k<aggregates.size(); k++) delete aggregates[k] ;
+        }
+
+        void push( const DataFrame& chunk ){
+            int n = chunk.nrows() ;
+            if( n == 0 ) return ;
+            if( aggregates.empty() ) init( chunk ) ;
+
+            int nvars = vars.size() ;
+            std::vector<SEXP> key_columns(nvars) ;
+            for( int j=0; j<nvars; j++){
+                key_columns[j] = column( chunk, vars[j] ) ;
+                train_key_type( j, key_columns[j] ) ;
+            }
+            GroupKeyBuilder builder( key_columns, true ) ;
+
+            std::vector<int> groups(n) ;
+            std::string key ;
+            for( int i=0; i<n; i++){
+                builder.key( i, key ) ;
+                groups[i] = group( key ) ;
+            }
+
+            int nspecs = specs.size() ;
+            for( int k=0; k<nspecs; k++){
+                SEXP x = R_NilValue ;
+                SEXP var = VECTOR_ELT( VECTOR_ELT(specs, k), 2 ) ;
+                if( !Rf_isNull(var) ) x = column( chunk, STRING_ELT(var, 0) ) ;
+                aggregates[k]->update( x, groups, keys.size() ) ;
+            }
+            nrows += n ;
+
+            if( bytes() > budget ) spill() ;
+        }
+
+        // the summary, or NULL if no row was pushed
+        SEXP get(){
+            if( !nrows ) return R_NilValue ;
+            if( !spills ) return finalize() ;
+
+            spill() ;
+            DataFrameCollecter out( CharacterVector(0) ) ;
+            for( int p=0; p<DPLYR_SPILL_PARTITIONS; p++){
+                if( !load( p ) ) continue ;
+                out.push( finalize() ) ;
+                clear() ;
+            }
+            return out.get() ;
+        }
+
+        inline int nspills() const { return spills ; }
+
+    private:
+
+        void init( const DataFrame& chunk ){
+            int nspecs = specs.size() ;
+            for( int k=0; k<nspecs; k++){
+                List spec = specs[k] ;
+                std::string fun = as<std::string>( spec[1] ) ;
+                SEXP var = spec[2] ;
+                SEXP x = Rf_isNull(var) ? R_NilValue : column( chunk, STRING_ELT(var, 0) ) ;
+                ExternalAggregate* aggregate = external_aggregate( fun, x, as<bool>( spec[3] ) ) ;
+                if( !aggregate ){
+                    stop( "%s() of a column of class '%s' is not supported in chunks", fun, get_single_class(x) ) ;
+                }
+                aggregates.push_back( aggregate ) ;
+            }
+            key_types.resize( vars.size(), NILSXP ) ;
+        }
+
+        SEXP column( const DataFrame& chunk, SEXP name ) const {
+            CharacterVector names = chunk.names() ;
+            int n = names.size() ;
+            for( int j=0; j<n; j++){
+                if( STRING_ELT(names, j) == name ) return chunk[j] ;
+            }
+            stop( "unknown column '%s'", CHAR(name) ) ;
+            return R_NilValue ;
+        }
+
+        // the type of the key column j in the result: the most general type of
+        // the chunks, factors giving strings. As with bind_rows(), a chunk of
+        // logical NA is compatible with any type, and the type stays NILSXP
+        // until a chunk has other values
+        void train_key_type( int j, SEXP x ){
+            if( TYPEOF(x) == LGLSXP && all_na(x) ) return ;
+            int type = Rf_isFactor(x) ? STRSXP : TYPEOF(x) ;
+            int& current = key_types[j] ;
+            if( type == current ) return ;
+            if( current == NILSXP ){
+                current = type ;
+                return ;
+            }
+            bool number = type == LGLSXP || type == INTSXP || type == REALSXP ;
+            bool current_number = current == LGLSXP || current == INTSXP || current == REALSXP ;
+            if( number != current_number ){
+                stop( "incompatible types for the grouping variable '%s'", CHAR(STRING_ELT(vars, j)) ) ;
+            }
+            if( type > current ) current = type ;
+        }
+
+        inline int group( const std::string& key ){
+            GroupIndex::const_iterator it = index.find( key ) ;
+            if( it != index.end() ) return it->second ;
+            int g = keys.size() ;
+            index.insert( std::make_pair( key, g ) ) ;
+            keys.push_back( key ) ;
+            // the key is both in the index and in keys, plus the node of the index
+            key_bytes += 2 * key.size() + 64 ;
+            return g ;
+        }
+
+        double bytes() const {
+            double res = key_bytes ;
+            for( size_t k=0; k<aggregates.size(); k++) res += aggregates[k]->bytes() ;
+            return res ;
+        }
+
+        std::string path( int p ) const {
+            std::stringstream s ;
+            s << dir << "/partition-" << p << ".bin" ;
+            return s.str() ;
+        }
+
+        inline int partition( const std::string& key ) const {
+            return boost::hash<std::string>()( key ) % DPLYR_SPILL_PARTITIONS ;
+        }
+
+        // writes the groups in memory to the files of their partitions
+        void spill(){
+            int ngroups = keys.size() ;
+            if( !ngroups ) return ;
+
+            std::vector< boost::shared_ptr<SpillFile> > files( DPLYR_SPILL_PARTITIONS ) ;
+            for( int g=0; g<ngroups; g++){
+                int p = partition( keys[g] ) ;
+                if( !files[p] ){
+                    files[p].reset( new SpillFile( path(p), "ab" ) ) ;
+                    if( !files[p]->get() ) stop( "cannot open spill file '%s'", path(p) ) ;
+                }
+                FILE* file = files[p]->get() ;
+                int size = keys[g].size() ;
+                if( fwrite( &size, sizeof(int), 1, file ) != 1 || fwrite( keys[g].data(), 1, size, file ) != (size_t)size ){
+                    stop( "cannot write spill file '%s'", path(p) ) ;
+                }
+                for( size_t k=0; k<aggregates.size(); k++) aggregates[k]->write( file, g ) ;
+            }
+            clear() ;
+            spills++ ;
+        }
+
+        // reads back the groups of a partition, false if it has none
+        bool load( int p ){
+            std::string file_path = path(p) ;
+            {
+                SpillFile file( file_path, "rb" ) ;
+                if( !file.get() ) return false ;
+
+                int size ;
+                std::string key ;
+                while( fread( &size, sizeof(int), 1, file.get() ) == 1 ){
+                    key.resize( size ) ;
+                    if( size && fread( &key[0], 1, size, file.get() ) != (size_t)size ) stop( "corrupt spill file" ) ;
+                    int g = group( key ) ;
+                    for( size_t k=0; k<aggregates.size(); k++) aggregates[k]->read( file.get(), g, keys.size() ) ;
+                }
+            }
+            std::remove( file_path.c_str() ) ;
+            return !keys.empty() ;
+        }
+
+        void clear(){
+            for( size_t k=0; k<aggregates.size(); k++) aggregates[k]->clear() ;
+            GroupIndex().swap( index ) ;
+            std::vector<std::string>().swap( keys ) ;
+            key_bytes = 0.0 ;
+        }
+
+        // the groups in memory as a data frame: the grouping variables, then
+        // the aggregates
+        DataFrame finalize() const {
+            int ngroups = keys.size() ;
+            int nvars = vars.size() ;
+            int nspecs = specs.size() ;
+
+            List out( nvars + nspecs ) ;
+            CharacterVector names( nvars + nspecs ) ;
+            std::vector<SEXP> key_columns(nvars) ;
+            for( int j=0; j<nvars; j++){
+                out[j] = Rf_allocVector( key_types[j] == NILSXP ? LGLSXP : key_types[j], ngroups ) ;
+                key_columns[j] = out[j] ;
+                names[j] = vars[j] ;
+            }
+            for( int g=0; g<ngroups; g++) read_group_key( keys[g], key_columns, g ) ;
+
+            for( int k=0; k<nspecs; k++){
+                out[nvars + k] = aggregates[k]->finalize() ;
+                names[nvars + k] = STRING_ELT( VECTOR_ELT( VECTOR_ELT(specs, k), 0 ), 0 ) ;
+            }
+            out.names() = names ;
+            set_rownames( out, ngroups ) ;
+            out.attr( "class" ) = classes_not_grouped() ;
+            return out ;
+        }
+
+        typedef dplyr_hash_map<std::string,int> GroupIndex ;
+
+        CharacterVector vars ;
+        List specs ;
+        std::string dir ;
+        double budget ;
+
+        std::vector<ExternalAggregate*> aggregates ;
+        std::vector<int> key_types ;
+        GroupIndex index ;
+        std::vector<std::string> keys ;
+        double key_bytes ;
+        int spills ;
+        int nrows ;
+    } ;
+
+}
+
+#endif
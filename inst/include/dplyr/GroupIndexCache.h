@@ -0,0 +1,177 @@
+#ifndef dplyr_GroupIndexCache_H
+#define dplyr_GroupIndexCache_H
+
+namespace dplyr {
+
+    // group indices built by the session, so that grouping the same columns
+    // again, e.g. after ungroup(), or after a verb dropped the index, does
+    // not hash the rows again.
+    //
+    // An index is identified by the names of the grouping variables and
+    // their columns: the address and length of each vector, and a
+    // fingerprint of a sample of its values. The cache keeps the columns
+    // alive, so their addresses can not be reused, and marks them as shared
+    // so that R copies them rather than modifying them in place. The
+    // fingerprint guards against code that modifies vectors regardless.
+    //
+    // The cache holds the getOption("dplyr.group_index_cache_size") most
+    // recently used indices, none by default, as it keeps their columns in
+    // memory after the data is gone. It is emptied by
+    // clear_group_index_cache() and when the collation, which orders the
+    // labels, changes.
+    class GroupIndexCache {
+    public:
+        GroupIndexCache() : entries(), nhits(0), collation() {}
+
+        // sets the cached index of the variables vars of data, if there is one
+        bool get( DataFrame& data, const CharacterVector& vars ){
+            check_collation() ;
+            std::vector<SEXP> columns = get_columns( data, vars ) ;
+            size_t print = fingerprint( columns ) ;
+
+            int n = entries.size() ;
+            for( int k=0; k<n; k++){
+                if( !matches( entries[k], vars, columns, print ) ) continue ;
+
+                Entry entry = entries[k] ;
+                entries.erase( entries.begin() + k ) ;
+                entries.insert( entries.begin(), entry ) ;
+
+                data.attr( "indices" ) = VECTOR_ELT( entry.index, 0 ) ;
+                data.attr( "group_sizes" ) = VECTOR_ELT( entry.index, 1 ) ;
+                data.attr( "biggest_group_size" ) = VECTOR_ELT( entry.index, 2 ) ;
+                data.attr( "labels" ) = VECTOR_ELT( entry.index, 3 ) ;
+                nhits++ ;
+                return true ;
+            }
+            return false ;
+        }
+
+        // records the index of data, built by build_index_cpp()
+        void put( const DataFrame& data, const CharacterVector& vars ){
+            int capacity = max_size() ;
+            if( capacity == 0 ) return ;
+            while( (int)entries.size() >= capacity ) evict() ;
+
+            Entry entry ;
+            entry.columns = get_columns( data, vars ) ;
+            for( size_t j=0; j<entry.columns.size(); j++){
+                entry.vars.push_back( CHAR(STRING_ELT(vars, j)) ) ;
+                entry.lengths.push_back( Rf_length(entry.columns[j]) ) ;
+                SET_NAMED( entry.columns[j], 2 ) ;
+            }
+            entry.print = fingerprint( entry.columns ) ;
+
+            int ncolumns = entry.columns.size() ;
+            Shield<SEXP> columns( Rf_allocVector( VECSXP, ncolumns ) ) ;
+            for( int j=0; j<ncolumns; j++) SET_VECTOR_ELT( columns, j, entry.columns[j] ) ;
+            entry.index = Rf_allocVector( VECSXP, 5 ) ;
+            R_PreserveObject( entry.index ) ;
+            SET_VECTOR_ELT( entry.index, 0, data.attr( "indices" ) ) ;
+            SET_VECTOR_ELT( entry.index, 1, data.attr( "group_sizes" ) ) ;
+            SET_VECTOR_ELT( entry.index, 2, data.attr( "biggest_group_size" ) ) ;
+            SET_VECTOR_ELT( entry.index, 3, data.attr( "labels" ) ) ;
+            SET_VECTOR_ELT( entry.index, 4, columns ) ;
+
+            entries.insert( entries.begin(), entry ) ;
+        }
+
+        // the number of indices that were dropped
+        int clear(){
+            int n = entries.size() ;
+            while( !entries.empty() ) evict() ;
+            return n ;
+        }
+
+        inline int hits() const { return nhits ; }
+
+        // the columns of the variables vars of data
+        static std::vector<SEXP> get_columns( const DataFrame& data, const CharacterVector& vars ){
+            CharacterVector names = data.names() ;
+            IntegerVector indx = r_match( vars, names ) ;
+            int n = vars.size() ;
+            std::vector<SEXP> columns(n) ;
+            for( int j=0; j<n; j++) columns[j] = data[ indx[j] - 1 ] ;
+            return columns ;
+        }
+
+        // the type, length and attributes of the columns, and up to 64
+        // values of each, evenly spaced
+        static size_t fingerprint( const std::vector<SEXP>& columns ){
+            size_t seed = 0 ;
+            for( size_t j=0; j<columns.size(); j++){
+                SEXP x = columns[j] ;
+                int n = Rf_length(x) ;
+                boost::hash_combine( seed, TYPEOF(x) ) ;
+                boost::hash_combine( seed, n ) ;
+                boost::hash_combine( seed, reinterpret_cast<size_t>( ATTRIB(x) ) ) ;
+                int step = std::max( n / 64, 1 ) ;
+                for( int i=0; i<n; i+=step){
+                    switch( TYPEOF(x) ){
+                    case LGLSXP:
+                    case INTSXP: boost::hash_combine( seed, INTEGER(x)[i] ) ; break ;
+                    case REALSXP: boost::hash_combine( seed, REAL(x)[i] ) ; break ;
+                    case STRSXP: boost::hash_combine( seed, reinterpret_cast<size_t>( STRING_ELT(x, i) ) ) ; break ;
+                    default: break ;
+                    }
+                }
+            }
+            return seed ;
+        }
+
+        // the number of indices the cache holds
+        static int max_size(){
+            SEXP opt = Rf_GetOption1( Rf_install("dplyr.group_index_cache_size") ) ;
+            if( Rf_isNumeric(opt) && Rf_length(opt) == 1 ){
+                int size = Rf_asInteger(opt) ;
+                if( size != NA_INTEGER ) return std::max( size, 0 ) ;
+            }
+            return 0 ;
+        }
+
+    private:
+
+        struct Entry {
+            std::vector<std::string> vars ;
+            std::vector<SEXP> columns ;
+            std::vector<int> lengths ;
+            size_t print ;
+            // the attributes of the index, and the columns, kept alive
+            SEXP index ;
+        } ;
+
+        static bool matches( const Entry& entry, const CharacterVector& vars, const std::vector<SEXP>& columns, size_t print ){
+            if( entry.columns.size() != columns.size() || entry.print != print ) return false ;
+            for( size_t j=0; j<columns.size(); j++){
+                if( entry.columns[j] != columns[j] || entry.lengths[j] != Rf_length(columns[j]) ) return false ;
+                if( entry.vars[j] != CHAR(STRING_ELT(vars, j)) ) return false ;
+            }
+            return true ;
+        }
+
+        void evict(){
+            R_ReleaseObject( entries.back().index ) ;
+            entries.pop_back() ;
+        }
+
+        // labels are sorted in the collation they were computed in
+        void check_collation(){
+            const char* current = setlocale( LC_COLLATE, NULL ) ;
+            std::string now( current ? current : "" ) ;
+            if( now != collation ){
+                clear() ;
+                collation = now ;
+            }
+        }
+
+        std::vector<Entry> entries ;
+        int nhits ;
+        std::string collation ;
+    } ;
+
+    // the cache of the session
+    GroupIndexCache& group_index_cache() ;
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef dplyr_GroupSplitter_H
+#define dplyr_GroupSplitter_H
+
+namespace dplyr {
+
+    // splits pages of rows sorted by the grouping variables into complete
+    // groups, detecting boundaries between adjacent rows as build_index_adj
+    // does. The last group of a page may continue in the next page, so its
+    // rows are kept aside in a DataFrameCollecter until its end is seen.
+    class GroupSplitter {
+    public:
+        GroupSplitter( const CharacterVector& vars_ ) :
+            vars(vars_), labels( CharacterVector(0) ), partial(), last_key()
+        {}
+
+        // the groups that are known to be complete after this page
+        List push( const DataFrame& page ){
+            int n = page.nrows() ;
+            if( n == 0 ) return List(0) ;
+
+            int nvars = vars.size() ;
+            std::vector<SEXP> key_columns(nvars) ;
+            for( int i=0; i<nvars; i++){
+                key_columns[i] = page[ std::string( CHAR(STRING_ELT(vars, i)) ) ] ;
+            }
+            GroupKeyBuilder keys( key_columns ) ;
+            DataFrameVisitors visitors( page, vars ) ;
+
+            std::string first_key ;
+            keys.key( 0, first_key ) ;
+            bool continues = partial && first_key == last_key ;
+
+            std::vector<int> starts ;
+            if( !continues ) starts.push_back(0) ;
+            for( int i=1; i<n; i++){
+                if( !visitors.equal(i, i-1) ) starts.push_back(i) ;
+            }
+            keys.key( n-1, last_key ) ;
+
+            if( starts.empty() ){
+                // the whole page belongs to the pending group
+                partial->push( page ) ;
+                return List(0) ;
+            }
+            labels.push( DataFrameSubsetVisitors(page, vars).subset( starts, "data.frame" ) ) ;
+
+            DataFrameSubsetVisitors subsetter( page, page.names() ) ;
+            int nstarts = starts.size() ;
+            int done_partial = partial ? 1 : 0 ;
+            List out( done_partial + nstarts - 1 ) ;
+
+            if( partial ){
+                if( continues ) partial->push( subsetter.subset( SlicingIndex(0, starts[0]), "data.frame" ) ) ;
+                out[0] = pending() ;
+            }
+            for( int j=0; j<nstarts-1; j++){
+                out[done_partial + j] = subsetter.subset( SlicingIndex(starts[j], starts[j+1] - starts[j]), "data.frame" ) ;
+            }
+
+            partial.reset( new DataFrameCollecter( CharacterVector(0) ) ) ;
+            partial->push( subsetter.subset( SlicingIndex(starts[nstarts-1], n - starts[nstarts-1]), "data.frame" ) ) ;
+
+            return out ;
+        }
+
+        // the last group, once all pages have been pushed
+        SEXP flush(){
+            if( !partial ) return R_NilValue ;
+            DataFrame res = pending() ;
+            partial.reset() ;
+            return res ;
+        }
+
+        SEXP get_labels(){
+            if( !labels.pages() ) return R_NilValue ;
+            return labels.get() ;
+        }
+
+    private:
+
+        inline DataFrame pending(){
+            DataFrame res = partial->get() ;
+            res.attr( "class" ) = "data.frame" ;
+            return res ;
+        }
+
+        CharacterVector vars ;
+        DataFrameCollecter labels ;
+        boost::scoped_ptr<DataFrameCollecter> partial ;
+        std::string last_key ;
+    } ;
+
+}
+
+#endif
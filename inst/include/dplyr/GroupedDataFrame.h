@@ -39,6 +39,10 @@ namespace Rcpp {
         int i ;
         const GroupedDataFrame& gdf ;
         List indices ;
+
+        // adjacent groups have no indices, only runs of rows
+        bool adjacent ;
+        int start ;
     } ;
 
     class GroupedDataFrame {
@@ -49,13 +53,14 @@ namespace Rcpp {
             group_sizes(),
             biggest_group_size(0),
             symbols( data_.attr("vars") ),
-            labels()
+            labels(),
+            adjacent( Rf_inherits(x, "adj_grouped_df") )
         {
             // handle lazyness
             bool is_lazy = Rf_isNull( data_.attr( "group_sizes") ) || Rf_isNull( data_.attr( "labels") ) ;
 
             if( is_lazy ){
-                data_ = build_index_cpp( data_) ;
+                data_ = adjacent ? build_index_adj( data_, symbols ) : build_index_cpp( data_) ;
             }
             group_sizes = data_.attr( "group_sizes" );
             biggest_group_size  = data_.attr( "biggest_group_size" ) ;
@@ -118,6 +123,11 @@ namespace Rcpp {
             return group_sizes ;
         }
 
+        // groups are runs of adjacent rows, described by their sizes only
+        inline bool is_adjacent() const {
+            return adjacent ;
+        }
+
     private:
 
         DataFrame data_ ;
@@ -125,6 +135,7 @@ namespace Rcpp {
         int biggest_group_size ;
         ListOf<Symbol> symbols ;
         DataFrame labels ;
+        bool adjacent ;
 
     } ;
 
@@ -134,14 +145,18 @@ namespace Rcpp {
     }
 
     inline GroupedDataFrameIndexIterator::GroupedDataFrameIndexIterator( const GroupedDataFrame& gdf_ ) :
-        i(0), gdf(gdf_), indices(gdf.data().attr("indices")) {}
+        i(0), gdf(gdf_), indices(gdf.data().attr("indices")), adjacent(gdf.is_adjacent()), start(0) {}
 
     inline GroupedDataFrameIndexIterator& GroupedDataFrameIndexIterator::operator++(){
+        if( adjacent ) start += gdf.get_group_sizes()[i] ;
         i++;
         return *this ;
     }
 
     inline SlicingIndex GroupedDataFrameIndexIterator::operator*() const {
+        if( adjacent ){
+            return SlicingIndex( start, gdf.get_group_sizes()[i], i ) ;
+        }
         return SlicingIndex( IntegerVector(indices[i]), i ) ;
     }
 
@@ -0,0 +1,222 @@
+#ifndef dplyr_HashIndex_H
+#define dplyr_HashIndex_H
+
+namespace dplyr {
+
+    // strings of the index and of the probe, compared by their UTF-8 bytes
+    // like joins compare them, so that equal strings in different encodings
+    // match
+    class HashIndexStringVisitor : public JoinVisitor {
+    public:
+        HashIndexStringVisitor( CharacterVector left_, CharacterVector right_ ) :
+            left(left_), right(right_)
+        {}
+
+        inline size_t hash( int i ){
+            SEXP s = get(i) ;
+            if( s == NA_STRING ) return 0 ;
+            const void* vmax = vmaxget() ;
+            const char* chars = utf8(s) ;
+            size_t res = boost::hash_range( chars, chars + strlen(chars) ) ;
+            vmaxset(vmax) ;
+            return res ;
+        }
+
+        inline bool equal( int i, int j ){
+            SEXP a = get(i), b = get(j) ;
+            if( a == b ) return true ;
+            if( a == NA_STRING || b == NA_STRING ) return false ;
+            const void* vmax = vmaxget() ;
+            bool res = !strcmp( utf8(a), utf8(b) ) ;
+            vmaxset(vmax) ;
+            return res ;
+        }
+
+        inline SEXP subset( const std::vector<int>& indices ){
+            int n = indices.size() ;
+            CharacterVector res( n ) ;
+            for( int i=0; i<n; i++) res[i] = get( indices[i] ) ;
+            return res ;
+        }
+
+        inline SEXP subset( const VisitorSetIndexSet<DataFrameJoinVisitors>& set ){
+            return subset( std::vector<int>( set.begin(), set.end() ) ) ;
+        }
+
+    private:
+        inline SEXP get( int i ) const {
+            return i >= 0 ? STRING_ELT( left, i ) : STRING_ELT( right, -i-1 ) ;
+        }
+
+        static inline const char* utf8( SEXP s ){
+            if( IS_ASCII(s) || IS_BYTES(s) || IS_UTF8(s) ) return CHAR(s) ;
+            return Rf_translateCharUTF8(s) ;
+        }
+
+        CharacterVector left, right ;
+    } ;
+
+    // the key columns of a hash index, and the columns of the data it is
+    // probed with. Rows of the index are positive and rows of the probe
+    // negative, as with DataFrameJoinVisitors. Columns of the same type are
+    // compared by value, so the hash of a row of the index does not depend
+    // on the probe, and the index is trained once
+    class HashIndexVisitors :
+        public VisitorSetEqual<HashIndexVisitors>,
+        public VisitorSetHash<HashIndexVisitors>
+    {
+    public:
+        typedef JoinVisitor visitor_type ;
+
+        HashIndexVisitors() : visitors() {}
+
+        void reset( const std::vector<SEXP>& keys, const std::vector<SEXP>& probe ){
+            visitors.clear() ;
+            for( size_t k=0; k<keys.size(); k++){
+                visitors.push_back( boost::shared_ptr<JoinVisitor>( visitor( keys[k], probe[k] ) ) ) ;
+            }
+        }
+
+        inline JoinVisitor* get(int k) const {
+            return visitors[k].get() ;
+        }
+        inline int size() const {
+            return visitors.size() ;
+        }
+
+        // whether the column y can be compared by value with the key column x:
+        // logical, integer, double or character vectors of the same type,
+        // without a class, or dates
+        static bool compatible( SEXP x, SEXP y ){
+            if( TYPEOF(x) != TYPEOF(y) ) return false ;
+            switch( TYPEOF(x) ){
+            case LGLSXP:
+            case INTSXP:
+            case STRSXP:
+                break ;
+            case REALSXP:
+                if( Rf_inherits(x, "Date") && Rf_inherits(y, "Date") ) return true ;
+                break ;
+            default:
+                return false ;
+            }
+            return Rf_isNull( Rf_getAttrib(x, R_ClassSymbol) ) && Rf_isNull( Rf_getAttrib(y, R_ClassSymbol) ) ;
+        }
+
+    private:
+
+        static JoinVisitor* visitor( SEXP x, SEXP y ){
+            switch( TYPEOF(x) ){
+            case LGLSXP: return new JoinVisitorImpl<LGLSXP,LGLSXP>( x, y ) ;
+            case INTSXP: return new JoinVisitorImpl<INTSXP,INTSXP>( x, y ) ;
+            case REALSXP: return new JoinVisitorImpl<REALSXP,REALSXP>( x, y ) ;
+            case STRSXP: return new HashIndexStringVisitor( x, y ) ;
+            default: break ;
+            }
+            stop( "cannot index column of type '%s'", Rf_type2char(TYPEOF(x)) ) ;
+            return 0 ;
+        }
+
+        std::vector< boost::shared_ptr<JoinVisitor> > visitors ;
+    } ;
+
+    // the rows of a data frame by the values of its key columns, built once by
+    // index_by() and stored in the "hash_index" attribute, so that repeated
+    // joins and equality filters against the same table only hash the rows
+    // they look up.
+    //
+    // The index belongs to the columns it was built from: it keeps them alive,
+    // marks them as shared and identifies them like the group index cache
+    // does. Data whose key columns were replaced or modified, or an index
+    // restored by readRDS(), whose pointer is NULL, is not indexed
+    class HashIndex {
+    public:
+        typedef VisitorSetIndexMap<HashIndexVisitors, std::vector<int> > Map ;
+
+        HashIndex( const DataFrame& data, const CharacterVector& vars_ ) :
+            vars(vars_),
+            columns( GroupIndexCache::get_columns( data, vars_ ) ),
+            nrows( data.nrows() ),
+            print( GroupIndexCache::fingerprint( columns ) ),
+            visitors(),
+            map( visitors )
+        {
+            for( size_t j=0; j<columns.size(); j++) SET_NAMED( columns[j], 2 ) ;
+            visitors.reset( columns, columns ) ;
+            train_push_back( map, nrows ) ;
+        }
+
+        // whether the key columns of data are the columns of the index
+        bool indexes( const DataFrame& data ) const {
+            if( data.nrows() != nrows ) return false ;
+            CharacterVector names = data.names() ;
+            IntegerVector indx = r_match( vars, names ) ;
+            for( int j=0; j<indx.size(); j++){
+                if( indx[j] == NA_INTEGER || (SEXP)data[ indx[j] - 1 ] != columns[j] ) return false ;
+            }
+            return GroupIndexCache::fingerprint( columns ) == print ;
+        }
+
+        // looks up rows of data: the key by_index[k] of the index is compared
+        // with the column by_data[k] of data. False when the variables are not
+        // the keys of the index, or can not be compared by value
+        bool probe( const DataFrame& data, const CharacterVector& by_data, const CharacterVector& by_index ){
+            int n = vars.size() ;
+            if( by_index.size() != n ) return false ;
+            IntegerVector pos = r_match( vars, by_index ) ;
+            std::vector<SEXP> probe_columns(n) ;
+            for( int k=0; k<n; k++){
+                if( pos[k] == NA_INTEGER ) return false ;
+                probe_columns[k] = data[ std::string( CHAR(STRING_ELT(by_data, pos[k] - 1)) ) ] ;
+            }
+            return probe( probe_columns ) ;
+        }
+
+        bool probe( const std::vector<SEXP>& probe_columns ){
+            for( size_t k=0; k<columns.size(); k++){
+                if( !HashIndexVisitors::compatible( columns[k], probe_columns[k] ) ) return false ;
+            }
+            visitors.reset( columns, probe_columns ) ;
+            return true ;
+        }
+
+        // the rows of the index, in order, whose keys are those of row i of
+        // the probe, or 0
+        inline const std::vector<int>* find( int i ){
+            Map::const_iterator it = map.find( -i-1 ) ;
+            return it == map.end() ? 0 : &it->second ;
+        }
+
+        // the columns, to keep alive with the index
+        SEXP protect() const {
+            int n = columns.size() ;
+            Shield<SEXP> out( Rf_allocVector( VECSXP, n ) ) ;
+            for( int j=0; j<n; j++) SET_VECTOR_ELT( out, j, columns[j] ) ;
+            return out ;
+        }
+
+        inline const CharacterVector& keys() const { return vars ; }
+
+    private:
+        CharacterVector vars ;
+        std::vector<SEXP> columns ;
+        int nrows ;
+        size_t print ;
+        HashIndexVisitors visitors ;
+        Map map ;
+
+        HashIndex( const HashIndex& ) ;
+        HashIndex& operator=( const HashIndex& ) ;
+    } ;
+
+    // the index of data, if it has a valid one
+    inline HashIndex* hash_index( const DataFrame& data ){
+        SEXP index = Rf_getAttrib( data, Rf_install("hash_index") ) ;
+        if( TYPEOF(index) != EXTPTRSXP ) return 0 ;
+        HashIndex* p = static_cast<HashIndex*>( R_ExternalPtrAddr(index) ) ;
+        return p && p->indexes( data ) ? p : 0 ;
+    }
+
+}
+
+#endif
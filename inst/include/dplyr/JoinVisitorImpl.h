@@ -3,8 +3,6 @@
 
 namespace dplyr{
 
-    CharacterVector get_uniques( const CharacterVector& left, const CharacterVector& right) ;
-
     template <int LHS_RTYPE, int RHS_RTYPE>
     class JoinVisitorImpl : public JoinVisitor, public comparisons_different<LHS_RTYPE, RHS_RTYPE>{
     public:
@@ -117,26 +115,25 @@ namespace dplyr{
 
     } ;
 
+    // factors and strings are joined by the codes given to their strings
+    // by a StringDictionary shared by both sides
     class JoinFactorFactorVisitor : public JoinVisitor {
     public:
         typedef CharacterVector Vec ;
 
-        JoinFactorFactorVisitor( const IntegerVector& left_, const IntegerVector& right_ ) :
-            left(left_),
-            right(right_),
-            left_levels (left.attr("levels")),
-            right_levels(right.attr("levels")),
-            uniques( get_uniques(left_levels, right_levels) ),
-            left_match ( match( left_levels, uniques) ),
-            right_match( match( right_levels, uniques) )
+        JoinFactorFactorVisitor( const IntegerVector& left, const IntegerVector& right ) :
+            dictionary(),
+            i_left( dictionary.encode_factor(left) ),
+            i_right( dictionary.encode_factor(right) ),
+            int_visitor( i_left, i_right )
         {}
 
         inline size_t hash(int i){
-            return hash_fun( get(i) ) ;
+            return int_visitor.hash(i) ;
         }
 
         inline bool equal( int i, int j){
-            return get(i) == get(j) ;
+            return int_visitor.equal(i,j) ;
         }
 
         inline SEXP subset( const std::vector<int>& indices ) {
@@ -148,21 +145,13 @@ namespace dplyr{
         }
 
         inline SEXP get(int i) const {
-            if( i >= 0){
-              int pos = left[i] ;
-              return (pos == NA_INTEGER) ? NA_STRING : SEXP( uniques[left_match[pos-1] - 1] ) ;
-            } else {
-              int pos = right[-i-1] ;
-              return (pos == NA_INTEGER) ? NA_STRING : SEXP( uniques[right_match[ pos -1 ] - 1] ) ;
-            }
+            return dictionary.get( int_visitor.get(i) ) ;
         }
 
     private:
-        IntegerVector left, right ;
-        CharacterVector left_levels, right_levels ;
-        CharacterVector uniques ;
-        IntegerVector left_match, right_match ;
-        boost::hash<SEXP> hash_fun ;
+        StringDictionary dictionary ;
+        IntegerVector i_left, i_right ;
+        JoinVisitorImpl<INTSXP,INTSXP> int_visitor ;
 
     } ;
 
@@ -172,13 +161,10 @@ namespace dplyr{
 
         JoinStringStringVisitor( CharacterVector left_, CharacterVector right) :
             left(left_),
-            uniques( get_uniques(left, right) ),
-            i_left( match(left, uniques) ),
-            i_right( match(right, uniques) ),
-            int_visitor( i_left, i_right),
-            p_uniques( internal::r_vector_start<STRSXP>(uniques) ),
-            p_left( i_left.begin() ),
-            p_right( i_right.begin() )
+            dictionary(),
+            i_left( dictionary.encode(left) ),
+            i_right( dictionary.encode(right) ),
+            int_visitor( i_left, i_right)
         {}
 
         inline size_t hash(int i) {
@@ -201,22 +187,14 @@ namespace dplyr{
         }
 
         inline SEXP get(int i) const {
-            if( i >= 0 ){
-                return ( i_left[i] == NA_INTEGER ) ? NA_STRING : p_uniques[ p_left[i] - 1] ;
-            } else {
-                return ( i_right[-i-1] == NA_INTEGER ) ? NA_STRING : p_uniques[ p_right[-i-1] - 1] ;
-            }
+            return dictionary.get( int_visitor.get(i) ) ;
         }
 
     private:
         CharacterVector left ;
-        CharacterVector uniques ;
+        StringDictionary dictionary ;
         IntegerVector i_left, i_right ;
         JoinVisitorImpl<INTSXP,INTSXP> int_visitor ;
-        SEXP* p_uniques ;
-        int* p_left ;
-        int* p_right ;
-
 
     } ;
 
@@ -224,17 +202,11 @@ namespace dplyr{
     public:
         typedef CharacterVector Vec ;
 
-        JoinFactorStringVisitor( const IntegerVector& left_, const CharacterVector& right_ ) :
-            left(left_),
-            left_ptr(left.begin()),
-
-            right(right_),
-            uniques( get_uniques(left.attr("levels"), right) ) ,
-            p_uniques( internal::r_vector_start<STRSXP>(uniques) ),
-
-            i_right( match( right, uniques )),
-            int_visitor( left, i_right )
-
+        JoinFactorStringVisitor( const IntegerVector& left, const CharacterVector& right ) :
+            dictionary(),
+            i_left( dictionary.encode_factor(left) ),
+            i_right( dictionary.encode(right) ),
+            int_visitor( i_left, i_right )
         {}
 
         inline size_t hash(int i){
@@ -258,40 +230,25 @@ namespace dplyr{
         }
 
         inline SEXP get(int i) const {
-            if( i>=0 ){
-                if( left_ptr[i] == NA_INTEGER ) return NA_STRING ;
-                return p_uniques[ left_ptr[i] - 1 ] ;
-            } else {
-                return p_uniques[ i_right[ -i-1 ] - 1] ;
-            }
+            return dictionary.get( int_visitor.get(i) ) ;
         }
 
     private:
-        IntegerVector left ;
-        int* left_ptr ;
-
-        CharacterVector right ;
-        CharacterVector uniques ;
-        SEXP* p_uniques ;
-        IntegerVector i_right ;
-
+        StringDictionary dictionary ;
+        IntegerVector i_left, i_right ;
         JoinVisitorImpl<INTSXP,INTSXP> int_visitor ;
 
-
     } ;
 
     class JoinStringFactorVisitor : public JoinVisitor {
     public:
         typedef CharacterVector Vec ;
 
-        JoinStringFactorVisitor( const CharacterVector& left_, const IntegerVector& right_ ) :
-            left(left_),
-            i_right(right_),
-            uniques( get_uniques(i_right.attr("levels"), left_) ),
-            p_uniques( internal::r_vector_start<STRSXP>(uniques) ),
-            i_left( match(left_, uniques) ),
-
-            int_visitor(i_left, i_right)
+        JoinStringFactorVisitor( const CharacterVector& left, const IntegerVector& right ) :
+            dictionary(),
+            i_left( dictionary.encode(left) ),
+            i_right( dictionary.encode_factor(right) ),
+            int_visitor( i_left, i_right )
         {}
 
         inline size_t hash(int i){
@@ -315,29 +272,12 @@ namespace dplyr{
         }
 
         inline SEXP get(int i) const {
-            SEXP res ;
-
-            if( i>=0 ){
-                res = p_uniques[ i_left[i] - 1 ] ;
-            } else {
-                int index = -i-1 ;
-                if( i_right[index] == NA_INTEGER ) {
-                    res = NA_STRING ;
-                } else {
-                    res = p_uniques[ i_right[index] - 1 ] ;
-                }
-            }
-
-            return res ;
+            return dictionary.get( int_visitor.get(i) ) ;
         }
 
     private:
-        CharacterVector left ;
-        IntegerVector i_right ;
-        CharacterVector uniques ;
-        SEXP* p_uniques ;
-        IntegerVector i_left ;
-
+        StringDictionary dictionary ;
+        IntegerVector i_left, i_right ;
         JoinVisitorImpl<INTSXP, INTSXP> int_visitor ;
 
     } ;
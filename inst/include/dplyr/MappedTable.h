@@ -0,0 +1,254 @@
+#ifndef dplyr_MappedTable_H
+#define dplyr_MappedTable_H
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dplyr {
+
+    // a read only file mapped in memory. Pages are only read from disk when
+    // they are touched, so mapping a large file is cheap. Where mmap() is not
+    // available, the file is read in memory instead
+    class MappedFile {
+    public:
+        MappedFile( const std::string& path ) : data(0), size(0), buffer() {
+        #if defined(_WIN32)
+            FILE* file = fopen( path.c_str(), "rb" ) ;
+            if( !file ) stop( "cannot open '%s'", path ) ;
+            fseek( file, 0, SEEK_END ) ;
+            size = ftell( file ) ;
+            fseek( file, 0, SEEK_SET ) ;
+            buffer.resize( size ) ;
+            size_t read = size ? fread( &buffer[0], 1, size, file ) : 0 ;
+            fclose( file ) ;
+            if( read != size ) stop( "cannot read '%s'", path ) ;
+            if( size ) data = &buffer[0] ;
+        #else
+            int fd = ::open( path.c_str(), O_RDONLY ) ;
+            if( fd < 0 ) stop( "cannot open '%s'", path ) ;
+            struct stat info ;
+            if( fstat( fd, &info ) != 0 ){
+                ::close( fd ) ;
+                stop( "cannot open '%s'", path ) ;
+            }
+            size = info.st_size ;
+            if( size ){
+                void* p = mmap( 0, size, PROT_READ, MAP_SHARED, fd, 0 ) ;
+                if( p == MAP_FAILED ){
+                    ::close( fd ) ;
+                    stop( "cannot map '%s'", path ) ;
+                }
+                data = static_cast<const char*>(p) ;
+            }
+            // the mapping stays valid once the file is closed
+            ::close( fd ) ;
+        #endif
+        }
+
+        ~MappedFile(){
+        #if !defined(_WIN32)
+            if( data ) munmap( const_cast<char*>(data), size ) ;
+        #endif
+        }
+
+        inline const char* begin() const { return data ; }
+        inline size_t bytes() const { return size ; }
+
+    private:
+        const char* data ;
+        size_t size ;
+        std::vector<char> buffer ;
+
+        MappedFile( const MappedFile& ) ;
+        MappedFile& operator=( const MappedFile& ) ;
+    } ;
+
+    // a column of a table written by write_mapped_column(): the values of
+    // a logical, integer or double column, or the codes of a string column,
+    // whose strings are stored once in a dictionary: the number of strings,
+    // their offsets and their bytes in UTF-8. Values are read as they are
+    // stored, missing strings having the code NA_INTEGER
+    class MappedColumn {
+    public:
+        MappedColumn( const std::string& path, int type_, int nrows_ ) :
+            type(type_), nrows(nrows_), values( path + ".bin" ), dictionary()
+        {
+            size_t width = type == REALSXP ? sizeof(double) : sizeof(int) ;
+            if( values.bytes() != width * nrows ) stop( "corrupt column file '%s.bin'", path ) ;
+            if( type == STRSXP ) dictionary.reset( new MappedFile( path + ".dict" ) ) ;
+        }
+
+        // the values of the rows, 1-based, or all the values if rows is NULL
+        SEXP get( SEXP rows ) const {
+            bool all = Rf_isNull(rows) ;
+            int n = all ? nrows : Rf_length(rows) ;
+            const int* idx = all ? 0 : INTEGER(rows) ;
+            for( int i=0; i<n && idx; i++){
+                if( idx[i] < 1 || idx[i] > nrows ) stop( "row %d out of range", idx[i] ) ;
+            }
+
+            switch( type ){
+            case LGLSXP: return copy<LGLSXP>( n, idx ) ;
+            case INTSXP: return copy<INTSXP>( n, idx ) ;
+            case REALSXP: return copy<REALSXP>( n, idx ) ;
+            case STRSXP: return strings( n, idx ) ;
+            default: break ;
+            }
+            stop( "unsupported column type" ) ;
+            return R_NilValue ;
+        }
+
+    private:
+
+        template <int RTYPE>
+        SEXP copy( int n, const int* idx ) const {
+            typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+            const STORAGE* src = reinterpret_cast<const STORAGE*>( values.begin() ) ;
+            Shield<SEXP> out( Rf_allocVector( RTYPE, n ) ) ;
+            STORAGE* ptr = Rcpp::internal::r_vector_start<RTYPE>(out) ;
+            if( !idx ){
+                if( n ) memcpy( ptr, src, n * sizeof(STORAGE) ) ;
+            } else {
+                for( int i=0; i<n; i++) ptr[i] = src[ idx[i] - 1 ] ;
+            }
+            return out ;
+        }
+
+        SEXP strings( int n, const int* idx ) const {
+            const int* codes = reinterpret_cast<const int*>( values.begin() ) ;
+            const int* header = reinterpret_cast<const int*>( dictionary->begin() ) ;
+            int size = header[0] ;
+            const int* offsets = header + 1 ;
+            const char* chars = reinterpret_cast<const char*>( offsets + size + 1 ) ;
+
+            // each string of the dictionary is made once
+            std::vector<SEXP> made( size, R_NilValue ) ;
+            Shield<SEXP> out( Rf_allocVector( STRSXP, n ) ) ;
+            for( int i=0; i<n; i++){
+                int code = codes[ idx ? idx[i] - 1 : i ] ;
+                if( code == NA_INTEGER ){
+                    SET_STRING_ELT( out, i, NA_STRING ) ;
+                    continue ;
+                }
+                if( made[code] == R_NilValue ){
+                    made[code] = Rf_mkCharLenCE( chars + offsets[code], offsets[code+1] - offsets[code], CE_UTF8 ) ;
+                }
+                // protected by out
+                SET_STRING_ELT( out, i, made[code] ) ;
+            }
+            return out ;
+        }
+
+        int type ;
+        int nrows ;
+        MappedFile values ;
+        boost::scoped_ptr<MappedFile> dictionary ;
+    } ;
+
+    // a table written as one file per column in a directory. Opening the table
+    // only records where its columns are, a column is mapped the first time
+    // it is read
+    class MappedTable {
+    public:
+        MappedTable( const std::string& dir_, const IntegerVector& types_, int nrows_ ) :
+            dir(dir_), types(types_), nrows(nrows_), columns( types_.size() )
+        {}
+
+        inline SEXP get( int j, SEXP rows ){
+            if( j < 0 || j >= (int)columns.size() ) stop( "column %d out of range", j + 1 ) ;
+            if( !columns[j] ){
+                columns[j].reset( new MappedColumn( column_path( dir, j ), types[j], nrows ) ) ;
+            }
+            return columns[j]->get( rows ) ;
+        }
+
+        inline int size() const { return nrows ; }
+
+        static std::string column_path( const std::string& dir, int j ){
+            std::stringstream s ;
+            s << dir << "/column-" << ( j + 1 ) ;
+            return s.str() ;
+        }
+
+    private:
+        std::string dir ;
+        IntegerVector types ;
+        int nrows ;
+        std::vector< boost::shared_ptr<MappedColumn> > columns ;
+    } ;
+
+    // writes x where a MappedColumn reads it, with the type of its storage:
+    // factors are written as their codes
+    inline void write_mapped_column( SEXP x, const std::string& path ){
+        int n = Rf_length(x) ;
+        std::string values_path = path + ".bin" ;
+        SpillFile values( values_path, "wb" ) ;
+        if( !values.get() ) stop( "cannot open '%s'", values_path ) ;
+
+        switch( TYPEOF(x) ){
+        case LGLSXP:
+        case INTSXP:
+            if( n && fwrite( INTEGER(x), sizeof(int), n, values.get() ) != (size_t)n ) stop( "cannot write '%s'", values_path ) ;
+            return ;
+        case REALSXP:
+            if( n && fwrite( REAL(x), sizeof(double), n, values.get() ) != (size_t)n ) stop( "cannot write '%s'", values_path ) ;
+            return ;
+        case STRSXP:
+            break ;
+        default:
+            stop( "cannot write column of class '%s'", get_single_class(x) ) ;
+        }
+
+        // codes, and the dictionary of the strings in order of appearance
+        dplyr_hash_map<SEXP,int> index ;
+        dplyr_hash_map<std::string,int> strings ;
+        std::vector<int> codes( n ) ;
+        std::vector<int> offsets( 1, 0 ) ;
+        std::string chars ;
+        for( int i=0; i<n; i++){
+            SEXP s = STRING_ELT(x, i) ;
+            if( s == NA_STRING ){
+                codes[i] = NA_INTEGER ;
+                continue ;
+            }
+            dplyr_hash_map<SEXP,int>::const_iterator it = index.find(s) ;
+            if( it != index.end() ){
+                codes[i] = it->second ;
+                continue ;
+            }
+            // different CHARSXPs can hold the same string in different encodings
+            std::string utf8 = Rf_translateCharUTF8(s) ;
+            dplyr_hash_map<std::string,int>::const_iterator same = strings.find(utf8) ;
+            int code ;
+            if( same != strings.end() ){
+                code = same->second ;
+            } else {
+                code = offsets.size() - 1 ;
+                strings.insert( std::make_pair( utf8, code ) ) ;
+                chars += utf8 ;
+                offsets.push_back( chars.size() ) ;
+            }
+            index.insert( std::make_pair( s, code ) ) ;
+            codes[i] = code ;
+        }
+        if( n && fwrite( &codes[0], sizeof(int), n, values.get() ) != (size_t)n ) stop( "cannot write '%s'", values_path ) ;
+
+        std::string dict_path = path + ".dict" ;
+        SpillFile dict( dict_path, "wb" ) ;
+        if( !dict.get() ) stop( "cannot open '%s'", dict_path ) ;
+        int size = offsets.size() - 1 ;
+        if( fwrite( &size, sizeof(int), 1, dict.get() ) != 1 ||
+            fwrite( &offsets[0], sizeof(int), offsets.size(), dict.get() ) != offsets.size() ||
+            ( chars.size() && fwrite( chars.data(), 1, chars.size(), dict.get() ) != chars.size() )
+        ){
+            stop( "cannot write '%s'", dict_path ) ;
+        }
+    }
+
+}
+
+#endif
@@ -32,6 +32,9 @@ namespace dplyr {
 
         Rcpp::IntegerVector apply() const ;
 
+        // the first k indices of apply(), the other rows are not sorted
+        Rcpp::IntegerVector head( int k ) const ;
+
         pointer_vector<OrderVisitor> visitors ;
         int n;
         int nrows ;
@@ -77,6 +80,15 @@ namespace dplyr {
         return x ;
     }
 
+    inline Rcpp::IntegerVector OrderVisitors::head( int k ) const {
+        k = std::max( 0, std::min( k, nrows ) ) ;
+        if( k == 0 ) return IntegerVector(0);
+        std::vector<int> x( nrows ) ;
+        for( int i=0; i<nrows; i++) x[i] = i ;
+        std::partial_sort( x.begin(), x.begin() + k, x.end(), OrderVisitors_Compare(*this) ) ;
+        return IntegerVector( x.begin(), x.begin() + k ) ;
+    }
+
 
 } // namespace dplyr
 
@@ -0,0 +1,187 @@
+#ifndef dplyr_PackedKeys_H
+#define dplyr_PackedKeys_H
+
+namespace dplyr {
+
+    // the keys of rows of several whole number columns, each encoded once in
+    // a single 64 bit key, so that hashing and comparing a row does not
+    // visit each column. The key is held in two 32 bit words, as C++98 has no
+    // 64 bit integer type.
+    //
+    // Each column takes as many bits as the range of its values needs, its
+    // values from the smallest and NA after the largest, and the columns are
+    // packed from the most significant bits. Logical, integer and factor
+    // columns can be packed, and double columns, e.g. dates, holding whole
+    // numbers that fit an int. Keys are packed the first time they are used,
+    // for both tables of a join, so that equal keys of either table pack
+    // the same.
+    //
+    // Rows of the first table are positive and rows of the second table
+    // negative, as with DataFrameJoinVisitors
+    class PackedKeys {
+    public:
+        struct Key {
+            unsigned int hi ;
+            unsigned int lo ;
+        } ;
+
+        PackedKeys() : left_columns(), right_columns(), left(), right(), state(UNKNOWN) {}
+
+        // the key columns of both tables, the second one being empty, or the
+        // columns of a single table
+        void set( const std::vector<SEXP>& left_columns_, const std::vector<SEXP>& right_columns_ ){
+            left_columns = left_columns_ ;
+            right_columns = right_columns_ ;
+            state = left_columns.size() < 2 ? UNPACKED : UNKNOWN ;
+        }
+
+        // whether the keys are packed, packing them the first time
+        inline bool packed(){
+            if( state == UNKNOWN ) state = pack() ? PACKED : UNPACKED ;
+            return state == PACKED ;
+        }
+
+        // whether the keys were packed already
+        inline bool ready() const { return state == PACKED ; }
+
+        inline size_t hash( int i ) const {
+            const Key& key = get(i) ;
+            size_t seed = key.lo ;
+            boost::hash_combine( seed, key.hi ) ;
+            return seed ;
+        }
+
+        inline bool equal( int i, int j ) const {
+            const Key& a = get(i) ;
+            const Key& b = get(j) ;
+            return a.lo == b.lo && a.hi == b.hi ;
+        }
+
+        // whether a column can be packed, by its type
+        static bool packable( SEXP x ){
+            if( !Rf_isNull( Rf_getAttrib(x, R_DimSymbol) ) ) return false ;
+            return TYPEOF(x) == LGLSXP || TYPEOF(x) == INTSXP || TYPEOF(x) == REALSXP ;
+        }
+
+        // whether columns of two tables joined by value can be packed:
+        // bare columns of the same type, or two dates
+        static bool packable( SEXP x, SEXP y ){
+            if( !packable(x) || !packable(y) ) return false ;
+            if( Rf_inherits(x, "Date") && Rf_inherits(y, "Date") ) return true ;
+            return TYPEOF(x) == TYPEOF(y) &&
+                Rf_isNull( Rf_getAttrib(x, R_ClassSymbol) ) && Rf_isNull( Rf_getAttrib(y, R_ClassSymbol) ) ;
+        }
+
+    private:
+        enum State { UNKNOWN, PACKED, UNPACKED } ;
+
+        inline const Key& get( int i ) const {
+            return i >= 0 ? left[i] : right[-i-1] ;
+        }
+
+        bool pack(){
+            int ncolumns = left_columns.size() ;
+            bool join = !right_columns.empty() ;
+            std::vector<int> mins(ncolumns), widths(ncolumns) ;
+            int bits = 0 ;
+            for( int k=0; k<ncolumns; k++){
+                int min = INT_MAX, max = INT_MIN ;
+                bool na = false ;
+                if( !range( left_columns[k], min, max, na ) ) return false ;
+                if( join && !range( right_columns[k], min, max, na ) ) return false ;
+                if( min > max ){
+                    min = 0 ;
+                    max = -1 ;
+                }
+                double ncodes = (double)max - (double)min + 1.0 + ( na ? 1.0 : 0.0 ) ;
+                int width = 0 ;
+                for( double capacity = 1.0; capacity < ncodes; capacity *= 2.0 ) width++ ;
+                bits += width ;
+                if( bits > 64 ) return false ;
+                mins[k] = min ;
+                widths[k] = width ;
+            }
+
+            encode( left_columns, mins, widths, left ) ;
+            if( join ) encode( right_columns, mins, widths, right ) ;
+            return true ;
+        }
+
+        // widens [min, max] to the range of x, false when x has values that
+        // are not whole numbers that fit an int
+        static bool range( SEXP x, int& min, int& max, bool& na ){
+            int n = Rf_length(x) ;
+            if( TYPEOF(x) == REALSXP ){
+                const double* p = REAL(x) ;
+                for( int i=0; i<n; i++){
+                    double value = p[i] ;
+                    if( R_IsNA(value) ){
+                        na = true ;
+                        continue ;
+                    }
+                    if( !( value > INT_MIN && value <= INT_MAX ) || value != floor(value) ) return false ;
+                    min = std::min( min, (int)value ) ;
+                    max = std::max( max, (int)value ) ;
+                }
+            } else {
+                const int* p = TYPEOF(x) == LGLSXP ? LOGICAL(x) : INTEGER(x) ;
+                for( int i=0; i<n; i++){
+                    if( p[i] == NA_INTEGER ){
+                        na = true ;
+                        continue ;
+                    }
+                    min = std::min( min, p[i] ) ;
+                    max = std::max( max, p[i] ) ;
+                }
+            }
+            return true ;
+        }
+
+        static void encode( const std::vector<SEXP>& columns, const std::vector<int>& mins, const std::vector<int>& widths, std::vector<Key>& keys ){
+            int n = Rf_length( columns[0] ) ;
+            Key zero = { 0u, 0u } ;
+            keys.assign( n, zero ) ;
+            for( size_t k=0; k<columns.size(); k++){
+                int width = widths[k] ;
+                if( width == 0 ) continue ;
+                unsigned int min = (unsigned int)mins[k] ;
+                // NA takes the code after the largest value, or is the only code
+                unsigned int na_code = ( (unsigned int)1 << ( width - 1 ) << 1 ) - 1u ;
+                SEXP x = columns[k] ;
+                if( TYPEOF(x) == REALSXP ){
+                    const double* p = REAL(x) ;
+                    for( int i=0; i<n; i++){
+                        unsigned int code = R_IsNA(p[i]) ? na_code : (unsigned int)(int)p[i] - min ;
+                        append( keys[i], code, width ) ;
+                    }
+                } else {
+                    const int* p = TYPEOF(x) == LGLSXP ? LOGICAL(x) : INTEGER(x) ;
+                    for( int i=0; i<n; i++){
+                        unsigned int code = p[i] == NA_INTEGER ? na_code : (unsigned int)p[i] - min ;
+                        append( keys[i], code, width ) ;
+                    }
+                }
+            }
+        }
+
+        // shifts the key by width bits, 1 to 32, and adds the code
+        static inline void append( Key& key, unsigned int code, int width ){
+            if( width == 32 ){
+                key.hi = key.lo ;
+                key.lo = code ;
+                return ;
+            }
+            key.hi = ( key.hi << width ) | ( key.lo >> ( 32 - width ) ) ;
+            key.lo = ( key.lo << width ) | code ;
+        }
+
+        std::vector<SEXP> left_columns ;
+        std::vector<SEXP> right_columns ;
+        std::vector<Key> left ;
+        std::vector<Key> right ;
+        State state ;
+    } ;
+
+}
+
+#endif
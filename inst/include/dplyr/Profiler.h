@@ -0,0 +1,186 @@
+#ifndef dplyr_Profiler_H
+#define dplyr_Profiler_H
+
+namespace dplyr {
+
+    // opt-in record of what the verbs of the local backend do, see
+    // profile_verbs(). Each record is a phase of a verb (building the group
+    // index, evaluating an expression, subsetting, structuring the result),
+    // with its timing and, for expressions, whether they were evaluated by a
+    // hybrid handler or by calling back to R. When profiling is not enabled,
+    // phases only check a flag.
+    class Profiler {
+    public:
+        Profiler() : enabled(false), ncallbacks(0), records() {}
+
+        inline bool is_enabled() const { return enabled ; }
+
+        void start(){
+            records.clear() ;
+            enabled = true ;
+        }
+
+        void stop(){
+            enabled = false ;
+        }
+
+        // evaluations of R code by the verbs
+        inline void callback(){ ncallbacks++ ; }
+        inline int callbacks() const { return ncallbacks ; }
+
+        void record(
+            const char* verb, const char* phase, const std::string& name, const std::string& fun,
+            const std::string& handler, int rows, int groups, int callbacks, double seconds, double bytes
+        ){
+            Record r = { verb, phase, name, fun, handler, rows, groups, callbacks, seconds, bytes } ;
+            records.push_back(r) ;
+        }
+
+        List get() const {
+            int n = records.size() ;
+            CharacterVector verb(n), phase(n), name(n), fun(n), handler(n) ;
+            IntegerVector rows(n), groups(n), callbacks(n) ;
+            NumericVector seconds(n), bytes(n) ;
+            for( int i=0; i<n; i++){
+                const Record& r = records[i] ;
+                verb[i] = r.verb ;
+                phase[i] = r.phase ;
+                name[i] = string_or_na( r.name ) ;
+                fun[i] = string_or_na( r.fun ) ;
+                handler[i] = string_or_na( r.handler ) ;
+                rows[i] = r.rows ;
+                groups[i] = r.groups ;
+                callbacks[i] = r.callbacks ;
+                seconds[i] = r.seconds ;
+                bytes[i] = r.bytes ;
+            }
+            List out = List::create(
+                _["verb"] = verb, _["phase"] = phase, _["name"] = name, _["fun"] = fun,
+                _["handler"] = handler, _["rows"] = rows, _["groups"] = groups,
+                _["callbacks"] = callbacks, _["seconds"] = seconds, _["bytes"] = bytes
+            ) ;
+            set_rownames( out, n ) ;
+            out.attr( "class" ) = classes_not_grouped() ;
+            return out ;
+        }
+
+    private:
+        static inline SEXP string_or_na( const std::string& s ){
+            return s.empty() ? NA_STRING : Rf_mkCharCE( s.c_str(), CE_UTF8 ) ;
+        }
+
+        struct Record {
+            const char* verb ;
+            const char* phase ;
+            std::string name ;
+            std::string fun ;
+            std::string handler ;
+            int rows ;
+            int groups ;
+            int callbacks ;
+            double seconds ;
+            double bytes ;
+        } ;
+
+        bool enabled ;
+        int ncallbacks ;
+        std::vector<Record> records ;
+    } ;
+
+    // the profiler of the session
+    Profiler& profiler() ;
+
+    // a phase of a verb, recorded when done() is called at its end. A
+    // phase left by an error never gets there, so it is not recorded
+    class ProfiledPhase {
+    public:
+        ProfiledPhase( const char* verb_, const char* phase_, int rows_, int groups_ ) :
+            enabled( profiler().is_enabled() ), verb(verb_), phase(phase_), evaluates(false), name(), fun(), handler(),
+            rows(rows_), groups(groups_), bytes(0.0), start(0.0), start_callbacks(0)
+        {
+            if( !enabled ) return ;
+            start = now() ;
+            start_callbacks = profiler().callbacks() ;
+        }
+
+        // records the phase, once
+        void done(){
+            if( !enabled ) return ;
+            enabled = false ;
+            int callbacks = profiler().callbacks() - start_callbacks ;
+            std::string how = handler ;
+            if( how.empty() && evaluates ) how = callbacks > 0 ? "R" : "hybrid" ;
+            profiler().record( verb, phase, name, fun, how, rows, groups, callbacks, now() - start, bytes ) ;
+        }
+
+        // the expression evaluated in this phase, and its name in the result
+        // if it has one
+        void set_expr( SEXP name_, SEXP expr ){
+            if( !enabled ) return ;
+            evaluates = true ;
+            switch( TYPEOF(name_) ){
+            case CHARSXP: name = CHAR(name_) ; break ;
+            case SYMSXP: name = CHAR(PRINTNAME(name_)) ; break ;
+            case STRSXP: name = CHAR(STRING_ELT(name_, 0)) ; break ;
+            default: break ;
+            }
+            if( TYPEOF(expr) == LANGSXP && TYPEOF(CAR(expr)) == SYMSXP ){
+                fun = CHAR(PRINTNAME(CAR(expr))) ;
+            }
+        }
+
+        // how the expression was evaluated: "hybrid", "R", "elementwise", "column", "constant".
+        // By default, "R" when R code was called back and "hybrid" otherwise
+        void set_handler( const char* handler_ ){
+            if( enabled ) handler = handler_ ;
+        }
+
+        // the number of groups, when only known at the end of the phase
+        void set_groups( int groups_ ){
+            groups = groups_ ;
+        }
+
+        // the vector produced by this phase
+        void set_result( SEXP x ){
+            if( enabled ) bytes += vector_bytes(x) ;
+        }
+
+        inline bool is_enabled() const { return enabled ; }
+
+    private:
+
+        static double now(){
+            return Rcpp::get_nanotime() * 1e-9 ;
+        }
+
+        static double vector_bytes( SEXP x ){
+            double n = Rf_length(x) ;
+            switch( TYPEOF(x) ){
+            case LGLSXP:
+            case INTSXP: return n * sizeof(int) ;
+            case REALSXP: return n * sizeof(double) ;
+            case CPLXSXP: return n * sizeof(Rcomplex) ;
+            case STRSXP:
+            case VECSXP: return n * sizeof(SEXP) ;
+            case RAWSXP: return n ;
+            default: return 0.0 ;
+            }
+        }
+
+        bool enabled ;
+        const char* verb ;
+        const char* phase ;
+        bool evaluates ;
+        std::string name ;
+        std::string fun ;
+        std::string handler ;
+        int rows ;
+        int groups ;
+        double bytes ;
+        double start ;
+        int start_callbacks ;
+    } ;
+
+}
+
+#endif
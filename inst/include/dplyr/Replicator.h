@@ -18,9 +18,21 @@ namespace dplyr {
             data( no_init(n_*ngroups_) ), source(v), n(n_), ngroups(ngroups_) {}
 
         SEXP collect(){
-            for( int i=0, k=0; i<ngroups; i++){
-                for( int j=0; j<n; j++, k++){
-                    data[k] = source[j] ;
+            int total = n * ngroups ;
+            if( RTYPE == STRSXP ){
+                for( int i=0, k=0; i<ngroups; i++){
+                    for( int j=0; j<n; j++, k++){
+                        data[k] = source[j] ;
+                    }
+                }
+            } else if( total > 0 ){
+                // copy the source once, then double the copied block
+                STORAGE* p = Rcpp::internal::r_vector_start<RTYPE>(data) ;
+                memcpy( p, Rcpp::internal::r_vector_start<RTYPE>(source), n * sizeof(STORAGE) ) ;
+                for( int done = n; done < total; ){
+                    int size = std::min( done, total - done ) ;
+                    memcpy( p + done, p, size * sizeof(STORAGE) ) ;
+                    done += size ;
                 }
             }
             copy_most_attributes( data, source ) ;
@@ -0,0 +1,145 @@
+#ifndef dplyr_Result_ConstantColumn_H
+#define dplyr_Result_ConstantColumn_H
+
+namespace dplyr {
+
+    // does x hold a single repeated value, e.g. a tag added by mutate(). Only
+    // a constant column is scanned to the end
+    inline bool is_constant_vector( SEXP x ){
+        int n = Rf_length(x) ;
+        if( n == 0 ) return false ;
+        switch( TYPEOF(x) ){
+        case LGLSXP:
+        case INTSXP:
+            {
+                int* p = INTEGER(x) ;
+                for( int i=1; i<n; i++) if( p[i] != p[0] ) return false ;
+                return true ;
+            }
+        case REALSXP:
+            {
+                // same bits, so that a column of NA is constant
+                double* p = REAL(x) ;
+                for( int i=1; i<n; i++) if( memcmp( p + i, p, sizeof(double) ) ) return false ;
+                return true ;
+            }
+        case STRSXP:
+            {
+                SEXP* p = Rcpp::internal::r_vector_start<STRSXP>(x) ;
+                for( int i=1; i<n; i++) if( p[i] != p[0] ) return false ;
+                return true ;
+            }
+        default: break ;
+        }
+        return false ;
+    }
+
+    // sum() of a constant column: the value times the size of the group
+    template <int RTYPE, bool NA_RM>
+    class ConstantSum : public Processor< RTYPE, ConstantSum<RTYPE,NA_RM> > {
+    public:
+        typedef Processor< RTYPE, ConstantSum<RTYPE,NA_RM> > Base ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        ConstantSum( SEXP x ) :
+            Base(x),
+            value( Rcpp::internal::r_vector_start<RTYPE>(x)[0] ),
+            is_na( Rcpp::traits::is_na<RTYPE>(value) )
+        {}
+
+        inline STORAGE process_chunk( const SlicingIndex& indices ){
+            int n = indices.size() ;
+            if( n == 0 ) return (STORAGE)0 ;
+            if( is_na ) return NA_RM ? (STORAGE)0 : value ;
+            return multiply( n ) ;
+        }
+
+    private:
+        inline STORAGE multiply( int n ) const {
+            long double res = (long double)value * n ;
+            if( RTYPE == INTSXP && ( res > INT_MAX || res <= INT_MIN ) ){
+                warning( "integer overflow - use sum(as.numeric(.))" ) ;
+                return Rcpp::traits::get_na<RTYPE>() ;
+            }
+            return (STORAGE)res ;
+        }
+
+        STORAGE value ;
+        bool is_na ;
+    } ;
+
+    // mean() of a constant column: the value, for all non empty groups
+    template <int RTYPE, bool NA_RM>
+    class ConstantMean : public Processor< REALSXP, ConstantMean<RTYPE,NA_RM> > {
+    public:
+        typedef Processor< REALSXP, ConstantMean<RTYPE,NA_RM> > Base ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        ConstantMean( SEXP x ) :
+            Base(x),
+            value( Rcpp::internal::r_vector_start<RTYPE>(x)[0] ),
+            is_na( Rcpp::traits::is_na<RTYPE>(value) )
+        {}
+
+        inline double process_chunk( const SlicingIndex& indices ){
+            if( indices.size() == 0 ) return R_NaN ;
+            if( is_na ){
+                if( NA_RM ) return R_NaN ;
+                return RTYPE == INTSXP ? NA_REAL : (double)value ;
+            }
+            return (double)value ;
+        }
+
+    private:
+        STORAGE value ;
+        bool is_na ;
+    } ;
+
+    // n_distinct() of a constant column: 1, or 0 for an empty group
+    class ConstantCountDistinct : public Processor< INTSXP, ConstantCountDistinct > {
+    public:
+        ConstantCountDistinct( bool all_na_, bool na_rm_ ) : all_na(all_na_), na_rm(na_rm_) {}
+
+        inline int process_chunk( const SlicingIndex& indices ){
+            if( indices.size() == 0 || ( all_na && na_rm ) ) return 0 ;
+            return 1 ;
+        }
+
+    private:
+        bool all_na ;
+        bool na_rm ;
+    } ;
+
+    // the reduction Fun of a constant column, 0 if there is no shortcut
+    template <template <int,bool> class Fun, bool NA_RM>
+    struct constant_reduction {
+        static Result* get( SEXP ){ return 0 ; }
+    } ;
+
+    template <bool NA_RM>
+    struct constant_reduction<Sum, NA_RM> {
+        static Result* get( SEXP x ){
+            switch( TYPEOF(x) ){
+            case INTSXP: return new ConstantSum<INTSXP, NA_RM>(x) ;
+            case REALSXP: return new ConstantSum<REALSXP, NA_RM>(x) ;
+            default: break ;
+            }
+            return 0 ;
+        }
+    } ;
+
+    template <bool NA_RM>
+    struct constant_reduction<Mean, NA_RM> {
+        static Result* get( SEXP x ){
+            switch( TYPEOF(x) ){
+            case INTSXP: return new ConstantMean<INTSXP, NA_RM>(x) ;
+            case REALSXP: return new ConstantMean<REALSXP, NA_RM>(x) ;
+            default: break ;
+            }
+            return 0 ;
+        }
+    } ;
+
+}
+
+#endif
@@ -56,6 +56,36 @@ namespace dplyr {
         Set set ;
     } ;
 
+    // n_distinct() of a single integer or factor column: the values of a
+    // group are flagged in an array indexed by value when their range is
+    // dense, and hashed otherwise
+    class Count_Distinct_Direct : public Processor<INTSXP, Count_Distinct_Direct> {
+    public:
+        Count_Distinct_Direct( SEXP x_, bool na_rm_ ) :
+            x(x_), na_rm(na_rm_), v(), seen(), hashed(), hashed_narm()
+        {
+            v.push_back( x ) ;
+            if( na_rm ){
+                hashed_narm.reset( new Count_Distinct_Narm<MultipleVectorVisitors>(v) ) ;
+            } else {
+                hashed.reset( new Count_Distinct<MultipleVectorVisitors>(v) ) ;
+            }
+        }
+
+        inline int process_chunk( const SlicingIndex& indices ){
+            int res = count_distinct_direct( INTEGER(x), indices, na_rm, seen ) ;
+            if( res >= 0 ) return res ;
+            return na_rm ? hashed_narm->process_chunk(indices) : hashed->process_chunk(indices) ;
+        }
+
+    private:
+        SEXP x ;
+        bool na_rm ;
+        MultipleVectorVisitors v ;
+        std::vector<bool> seen ;
+        boost::scoped_ptr< Count_Distinct<MultipleVectorVisitors> > hashed ;
+        boost::scoped_ptr< Count_Distinct_Narm<MultipleVectorVisitors> > hashed_narm ;
+    } ;
 
 }
 
@@ -44,6 +44,7 @@ namespace dplyr {
                     proxies[i].set( subsets.get(proxies[i].symbol, indices ) ) ;
                 }
 
+                profiler().callback() ;
                 return call.eval(env) ;
             } else if( TYPEOF(call) == SYMSXP ) {
                 if(subsets.count(call)){
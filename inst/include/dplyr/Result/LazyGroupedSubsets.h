@@ -87,12 +87,14 @@ namespace dplyr {
         bool owner ;
 
         void input_subset(SEXP symbol, GroupedSubset* sub){
+            forget_constant( sub->get_variable() ) ;
             SymbolMapIndex index = symbol_map.insert(symbol) ;
             if( index.origin == NEW ){
                 subsets.push_back(sub) ;
                 resolved.push_back(R_NilValue) ;
             } else {
                 int idx = index.pos ;
+                forget_constant( subsets[idx]->get_variable() ) ;
                 delete subsets[idx] ;
                 subsets[idx] = sub ;
                 resolved[idx] = R_NilValue ;
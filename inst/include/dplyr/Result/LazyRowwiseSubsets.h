@@ -76,11 +76,13 @@ namespace dplyr {
         bool owner ;
 
         void input_subset(SEXP symbol, RowwiseSubset* sub){
+            forget_constant( sub->get_variable() ) ;
             RowwiseSubsetMap::iterator it = subset_map.find(symbol) ;
             if( it == subset_map.end() ){
                 subset_map[symbol] = sub ;
             } else {
                 // found it, replacing the subset
+                forget_constant( it->second->get_variable() ) ;
                 delete it->second ;
                 it->second = sub ;
             }
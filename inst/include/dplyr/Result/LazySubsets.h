@@ -41,8 +41,10 @@ namespace dplyr {
             if( index.origin == NEW ){
                 data.push_back(x) ;
             } else {
+                forget_constant( data[index.pos] ) ;
                 data[index.pos] = x ;
             }
+            forget_constant( x ) ;
         }
 
         virtual int size() const{
@@ -53,9 +55,28 @@ namespace dplyr {
             return nr ;
         }
 
+        // is the column x a single repeated value, checked once per column.
+        // Columns are identified by address, so input() forgets the columns
+        // it replaces, whose address may be reused by later columns
+        bool is_constant( SEXP x ) const {
+            dplyr_hash_map<SEXP,bool>::const_iterator it = constant_columns.find(x) ;
+            if( it != constant_columns.end() ) return it->second ;
+            bool res = is_constant_vector(x) ;
+            constant_columns[x] = res ;
+            return res ;
+        }
+
         inline SEXP& operator[](SEXP symbol){
             return data[symbol_map.get(symbol)] ;
         }
+
+    protected:
+        inline void forget_constant( SEXP x ){
+            constant_columns.erase( x ) ;
+        }
+
+    private:
+        mutable dplyr_hash_map<SEXP,bool> constant_columns ;
     } ;
 
 }
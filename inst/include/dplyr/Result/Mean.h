@@ -102,6 +102,9 @@ namespace internal {
 
         inline double process_chunk( const SlicingIndex& indices ){
             if( is_summary ) return data_ptr[indices.group()] ;
+            if( indices.contiguous() ){
+                return internal::Mean_internal<RTYPE,NA_RM,NaturalSlicingIndex>::process(data_ptr + indices.start(), NaturalSlicingIndex(indices.size())) ;
+            }
             return internal::Mean_internal<RTYPE,NA_RM,SlicingIndex>::process(data_ptr, indices) ;
         }
 
@@ -0,0 +1,77 @@
+#ifndef dplyr_Result_ParallelReduction_H
+#define dplyr_Result_ParallelReduction_H
+
+namespace dplyr {
+
+    // each range of a slice is added to its own partial state by a worker
+    template <typename State>
+    class PartialUpdater {
+    public:
+        typedef typename State::STORAGE STORAGE ;
+
+        PartialUpdater( std::vector<State>& states_, const STORAGE* ptr_, const SlicingIndex& indices_ ) :
+            states(states_), ptr(ptr_), indices(indices_)
+        {}
+
+        inline void operator()( int range, int begin, int end ){
+            State& state = states[range] ;
+            for( int i=begin; i<end; i++) state.add( ptr[ indices[i] ] ) ;
+        }
+
+    private:
+        std::vector<State>& states ;
+        const STORAGE* ptr ;
+        const SlicingIndex& indices ;
+    } ;
+
+    // the hybrid reduction Fun, with slices large enough to be split, e.g. all
+    // the rows of an ungrouped data frame, reduced by the threads of an
+    // ExecutionContext into partial states that are then merged. Other slices
+    // are processed by Fun, as without threads
+    template <template <int,bool> class Fun, int RTYPE, bool NA_RM>
+    class ParallelReduction :
+        public Processor< partial_state<Fun,RTYPE,NA_RM>::type::OUTPUT, ParallelReduction<Fun,RTYPE,NA_RM> >
+    {
+    public:
+        typedef typename partial_state<Fun,RTYPE,NA_RM>::type State ;
+        typedef Processor< State::OUTPUT, ParallelReduction<Fun,RTYPE,NA_RM> > Base ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        ParallelReduction( SEXP x, bool is_summary_, const ExecutionContext& context_ ) :
+            Base(x),
+            reducer(x, is_summary_),
+            data_ptr( Rcpp::internal::r_vector_start<RTYPE>(x) ),
+            is_summary(is_summary_),
+            context(context_)
+        {}
+
+        inline typename Base::STORAGE process_chunk( const SlicingIndex& indices ){
+            int nranges = context.ranges( indices.size() ) ;
+            if( is_summary || nranges == 1 ) return reducer.process_chunk( indices ) ;
+
+            std::vector<State> states( nranges ) ;
+            PartialUpdater<State> updater( states, data_ptr, indices ) ;
+            context.run( indices.size(), updater ) ;
+
+            for( int i=1; i<nranges; i++) states[0].merge( states[i] ) ;
+            return states[0].finalize() ;
+        }
+
+    private:
+        Fun<RTYPE,NA_RM> reducer ;
+        STORAGE* data_ptr ;
+        bool is_summary ;
+        ExecutionContext context ;
+    } ;
+
+    // Fun, reduced in parallel when the session has several threads
+    template <template <int,bool> class Fun, int RTYPE, bool NA_RM>
+    inline Result* reduction( SEXP x, bool is_summary ){
+        ExecutionContext context ;
+        if( context.threads() > 1 ) return new ParallelReduction<Fun,RTYPE,NA_RM>( x, is_summary, context ) ;
+        return new Fun<RTYPE,NA_RM>( x, is_summary ) ;
+    }
+
+}
+
+#endif
@@ -0,0 +1,382 @@
+#ifndef dplyr_Result_Partial_H
+#define dplyr_Result_Partial_H
+
+namespace dplyr {
+
+    // partial states of the hybrid reductions. A state starts empty, is
+    // updated with the values of one or several slices, can be merged with
+    // the state of other slices (chunks of the data, or ranges scanned by
+    // other threads), and is finalized into the result of the reduction of
+    // all these values. States only hold plain data and do not touch the R
+    // API until finalize(), so they can be updated by worker threads.
+    //
+    // add() takes one value, update() the values of a slice of a vector, and
+    // merge() must be called in the order of the slices so that the result
+    // does not depend on how the data was split. OUTPUT is the type of the
+    // result. The state of integers converts to the state of doubles, for
+    // slices of both types.
+    template <typename CLASS, int RTYPE>
+    class PartialState {
+    public:
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        template <typename Index>
+        void update( const STORAGE* ptr, const Index& indices ){
+            CLASS* obj = static_cast<CLASS*>(this) ;
+            int n = indices.size() ;
+            for( int i=0; i<n; i++) obj->add( ptr[ indices[i] ] ) ;
+        }
+    } ;
+
+    // sum(): the total in extended precision. Integer sums that overflow give
+    // NA with a warning, as Sum
+    template <int RTYPE, bool NA_RM>
+    class SumState : public PartialState< SumState<RTYPE,NA_RM>, RTYPE > {
+    public:
+        enum { OUTPUT = RTYPE } ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        SumState() : sum(0.0), na(false) {}
+
+        template <int OTHER>
+        explicit SumState( const SumState<OTHER,NA_RM>& other ) : sum(other.sum), na(other.na) {}
+
+        inline void add( STORAGE value ){
+            if( Rcpp::traits::is_na<RTYPE>(value) ){
+                if( NA_RM ) return ;
+                // missing doubles propagate through the sum
+                if( RTYPE == INTSXP ){
+                    na = true ;
+                    return ;
+                }
+            }
+            sum += value ;
+        }
+
+        inline void merge( const SumState& other ){
+            sum += other.sum ;
+            if( other.na ) na = true ;
+        }
+
+        STORAGE finalize() const {
+            // missing integers of a state converted to doubles
+            if( na ) return Rcpp::traits::get_na<RTYPE>() ;
+            if( RTYPE != INTSXP ) return (STORAGE)sum ;
+            if( sum > INT_MAX || sum <= INT_MIN ){
+                warning( "integer overflow - use sum(as.numeric(.))" ) ;
+                return Rcpp::traits::get_na<RTYPE>() ;
+            }
+            return (STORAGE)sum ;
+        }
+
+    private:
+        template <int, bool> friend class SumState ;
+
+        long double sum ;
+        bool na ;
+    } ;
+
+    // mean(): the count and the total. Unlike Mean, there is no second pass
+    // to refine the result, the total is kept in extended precision instead
+    template <int RTYPE, bool NA_RM>
+    class MeanState : public PartialState< MeanState<RTYPE,NA_RM>, RTYPE > {
+    public:
+        enum { OUTPUT = REALSXP } ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        MeanState() : n(0), sum(0.0), na(false) {}
+
+        template <int OTHER>
+        explicit MeanState( const MeanState<OTHER,NA_RM>& other ) : n(other.n), sum(other.sum), na(other.na) {}
+
+        inline void add( STORAGE value ){
+            if( Rcpp::traits::is_na<RTYPE>(value) ){
+                if( NA_RM ) return ;
+                if( RTYPE == INTSXP ){
+                    na = true ;
+                    return ;
+                }
+            }
+            sum += value ;
+            n++ ;
+        }
+
+        inline void merge( const MeanState& other ){
+            n += other.n ;
+            sum += other.sum ;
+            if( other.na ) na = true ;
+        }
+
+        double finalize() const {
+            if( na ) return NA_REAL ;
+            if( n == 0 ) return R_NaN ;
+            return (double)( sum / n ) ;
+        }
+
+    private:
+        template <int, bool> friend class MeanState ;
+
+        int n ;
+        long double sum ;
+        bool na ;
+    } ;
+
+    // var(): the count, the mean and the sum of squared deviations (M2),
+    // updated with Welford's method and merged with the formula of Chan et al.
+    template <int RTYPE, bool NA_RM>
+    class VarState : public PartialState< VarState<RTYPE,NA_RM>, RTYPE > {
+    public:
+        enum { OUTPUT = REALSXP } ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        VarState() : n(0), mean(0.0), m2(0.0), na(false) {}
+
+        template <int OTHER>
+        explicit VarState( const VarState<OTHER,NA_RM>& other ) : n(other.n), mean(other.mean), m2(other.m2), na(other.na) {}
+
+        inline void add( STORAGE value ){
+            if( Rcpp::traits::is_na<RTYPE>(value) ){
+                if( !NA_RM ) na = true ;
+                return ;
+            }
+            double x = value ;
+            n++ ;
+            double delta = x - mean ;
+            mean += delta / n ;
+            m2 += delta * ( x - mean ) ;
+        }
+
+        inline void merge( const VarState& other ){
+            if( other.na ) na = true ;
+            if( other.n == 0 ) return ;
+            int k = n + other.n ;
+            double delta = other.mean - mean ;
+            mean += delta * other.n / k ;
+            m2 += other.m2 + delta * delta * ( (double)n * other.n / k ) ;
+            n = k ;
+        }
+
+        double finalize() const {
+            if( na || n < 2 ) return NA_REAL ;
+            return m2 / ( n - 1 ) ;
+        }
+
+    private:
+        template <int, bool> friend class VarState ;
+
+        int n ;
+        double mean ;
+        double m2 ;
+        bool na ;
+    } ;
+
+    // sd(): the state of var()
+    template <int RTYPE, bool NA_RM>
+    class SdState : public PartialState< SdState<RTYPE,NA_RM>, RTYPE > {
+    public:
+        enum { OUTPUT = REALSXP } ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        SdState() : var() {}
+
+        template <int OTHER>
+        explicit SdState( const SdState<OTHER,NA_RM>& other ) : var(other.var) {}
+
+        inline void add( STORAGE value ){ var.add(value) ; }
+
+        inline void merge( const SdState& other ){ var.merge( other.var ) ; }
+
+        double finalize() const {
+            return ::sqrt( var.finalize() ) ;
+        }
+
+    private:
+        template <int, bool> friend class SdState ;
+
+        VarState<RTYPE,NA_RM> var ;
+    } ;
+
+    // min() or max(): the extreme value so far, and the first missing value
+    // when they are not removed. As for Min and Max, the result for integers
+    // stays integer, so an empty slice gives NA rather than an infinite bound
+    template <int RTYPE, bool NA_RM, bool MINIMUM>
+    class ExtremumState : public PartialState< ExtremumState<RTYPE,NA_RM,MINIMUM>, RTYPE > {
+    public:
+        enum { OUTPUT = RTYPE } ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        ExtremumState() : best(), seen(false), missing( Rcpp::traits::get_na<RTYPE>() ), na(false) {}
+
+        // a missing integer is NA, as a double
+        template <int OTHER>
+        explicit ExtremumState( const ExtremumState<OTHER,NA_RM,MINIMUM>& other ) :
+            best( other.seen ? (STORAGE)other.best : STORAGE() ), seen(other.seen),
+            missing( Rcpp::traits::get_na<RTYPE>() ), na(other.na)
+        {}
+
+        inline void add( STORAGE value ){
+            if( Rcpp::traits::is_na<RTYPE>(value) ){
+                if( !na ){
+                    missing = value ;
+                    na = true ;
+                }
+                return ;
+            }
+            if( !seen || ( MINIMUM ? internal::is_smaller<RTYPE>( value, best ) : internal::is_smaller<RTYPE>( best, value ) ) ){
+                best = value ;
+                seen = true ;
+            }
+        }
+
+        inline void merge( const ExtremumState& other ){
+            if( other.na && !na ){
+                missing = other.missing ;
+                na = true ;
+            }
+            if( other.seen ) add( other.best ) ;
+        }
+
+        STORAGE finalize() const {
+            if( na && ( !NA_RM || !seen ) ) return missing ;
+            if( seen ) return best ;
+            if( RTYPE == INTSXP ) return Rcpp::traits::get_na<RTYPE>() ;
+            return (STORAGE)( MINIMUM ? R_PosInf : R_NegInf ) ;
+        }
+
+    private:
+        template <int, bool, bool> friend class ExtremumState ;
+
+        STORAGE best ;
+        bool seen ;
+        STORAGE missing ;
+        bool na ;
+    } ;
+
+    template <int RTYPE, bool NA_RM>
+    class MinState : public ExtremumState<RTYPE,NA_RM,true> {
+    public:
+        MinState() {}
+
+        template <int OTHER>
+        explicit MinState( const MinState<OTHER,NA_RM>& other ) : ExtremumState<RTYPE,NA_RM,true>(other) {}
+    } ;
+
+    template <int RTYPE, bool NA_RM>
+    class MaxState : public ExtremumState<RTYPE,NA_RM,false> {
+    public:
+        MaxState() {}
+
+        template <int OTHER>
+        explicit MaxState( const MaxState<OTHER,NA_RM>& other ) : ExtremumState<RTYPE,NA_RM,false>(other) {}
+    } ;
+
+    // n(): the number of rows
+    class CountState {
+    public:
+        enum { OUTPUT = INTSXP } ;
+
+        CountState() : n(0) {}
+
+        inline void add(){ n++ ; }
+
+        inline void update( const SlicingIndex& indices ){ n += indices.size() ; }
+
+        inline void merge( const CountState& other ){ n += other.n ; }
+
+        inline int finalize() const { return n ; }
+
+    private:
+        int n ;
+    } ;
+
+    // n_distinct() of a vector: the set of the values. Values, rather than
+    // indices as in Count_Distinct, so that states of different chunks of the
+    // data can be merged. Missing doubles are either NA or NaN, which are
+    // counted as two distinct values, as by n_distinct()
+    template <int RTYPE, bool NA_RM>
+    class CountDistinctState : public PartialState< CountDistinctState<RTYPE,NA_RM>, RTYPE > {
+    public:
+        enum { OUTPUT = INTSXP } ;
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        CountDistinctState() : values(), na(false), nan(false) {}
+
+        // a missing integer is NA, as a double
+        template <int OTHER>
+        explicit CountDistinctState( const CountDistinctState<OTHER,NA_RM>& other ) :
+            values(), na(other.has_na()), nan(other.has_nan())
+        {
+            typedef typename Rcpp::traits::storage_type<OTHER>::type OTHER_STORAGE ;
+            const dplyr_hash_set<OTHER_STORAGE>& other_values = other.get_values() ;
+            typename dplyr_hash_set<OTHER_STORAGE>::const_iterator it = other_values.begin() ;
+            for( ; it != other_values.end(); ++it){
+                if( Rcpp::traits::is_na<OTHER>(*it) ){
+                    na = true ;
+                } else {
+                    values.insert( normalize( (STORAGE)*it ) ) ;
+                }
+            }
+        }
+
+        inline void add( STORAGE value ){
+            if( Rcpp::traits::is_na<RTYPE>(value) ){
+                if( NA_RM ) return ;
+                if( RTYPE == REALSXP ){
+                    if( R_IsNA( (double)value ) ) na = true ; else nan = true ;
+                    return ;
+                }
+            }
+            values.insert( normalize(value) ) ;
+        }
+
+        inline void merge( const CountDistinctState& other ){
+            values.insert( other.values.begin(), other.values.end() ) ;
+            if( other.na ) na = true ;
+            if( other.nan ) nan = true ;
+        }
+
+        inline int finalize() const {
+            return values.size() + na + nan ;
+        }
+
+        // the values but the missing doubles, and whether these were seen
+        inline const dplyr_hash_set<STORAGE>& get_values() const { return values ; }
+        inline bool has_na() const { return na ; }
+        inline bool has_nan() const { return nan ; }
+
+    private:
+        // 0 and -0 are the same value
+        static inline STORAGE normalize( STORAGE value ){
+            return value == 0 ? (STORAGE)0 : value ;
+        }
+
+        dplyr_hash_set<STORAGE> values ;
+        bool na ;
+        bool nan ;
+    } ;
+
+    // the partial state of the hybrid reduction Fun, if it has one
+    template <template <int,bool> class Fun, int RTYPE, bool NA_RM>
+    struct partial_state ;
+
+    template <int RTYPE, bool NA_RM>
+    struct partial_state<Sum, RTYPE, NA_RM> { typedef SumState<RTYPE,NA_RM> type ; } ;
+
+    template <int RTYPE, bool NA_RM>
+    struct partial_state<Mean, RTYPE, NA_RM> { typedef MeanState<RTYPE,NA_RM> type ; } ;
+
+    template <int RTYPE, bool NA_RM>
+    struct partial_state<Var, RTYPE, NA_RM> { typedef VarState<RTYPE,NA_RM> type ; } ;
+
+    template <int RTYPE, bool NA_RM>
+    struct partial_state<Sd, RTYPE, NA_RM> { typedef SdState<RTYPE,NA_RM> type ; } ;
+
+    template <int RTYPE, bool NA_RM>
+    struct partial_state<Min, RTYPE, NA_RM> { typedef MinState<RTYPE,NA_RM> type ; } ;
+
+    template <int RTYPE, bool NA_RM>
+    struct partial_state<Max, RTYPE, NA_RM> { typedef MaxState<RTYPE,NA_RM> type ; } ;
+
+}
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef dplyr_Result_Roll_H
+#define dplyr_Result_Roll_H
+
+#include <deque>
+
+namespace dplyr {
+namespace internal {
+
+    // running sum with Neumaier compensation, values can be added and removed
+    // in any order. infinite values are counted separately, otherwise removing
+    // them from the running sum would give NaN
+    class RollSumState {
+    public:
+        RollSumState() : sum(0.0), comp(0.0), n(0), n_posinf(0), n_neginf(0) {}
+
+        inline void push( int, double x ){
+            n++ ;
+            if( x == R_PosInf ) n_posinf++ ;
+            else if( x == R_NegInf ) n_neginf++ ;
+            else add(x) ;
+        }
+
+        inline void pop( int, double x ){
+            n-- ;
+            if( x == R_PosInf ) n_posinf-- ;
+            else if( x == R_NegInf ) n_neginf-- ;
+            else add(-x) ;
+        }
+
+        inline double sum_value() const {
+            if( n_posinf && n_neginf ) return R_NaN ;
+            if( n_posinf ) return R_PosInf ;
+            if( n_neginf ) return R_NegInf ;
+            return sum + comp ;
+        }
+
+        inline int size() const { return n ; }
+
+    private:
+        inline void add( double x ){
+            double t = sum + x ;
+            if( fabs(sum) >= fabs(x) ){
+                comp += (sum - t) + x ;
+            } else {
+                comp += (x - t) + sum ;
+            }
+            sum = t ;
+        }
+
+        double sum, comp ;
+        int n, n_posinf, n_neginf ;
+    } ;
+
+    class RollSum : public RollSumState {
+    public:
+        inline double get() const {
+            return sum_value() ;
+        }
+    } ;
+
+    class RollMean : public RollSumState {
+    public:
+        inline double get() const {
+            if( size() == 0 ) return R_NaN ;
+            return sum_value() / size() ;
+        }
+    } ;
+
+    // Welford's algorithm, run forwards when a value enters the window
+    // and backwards when it leaves
+    class RollSd {
+    public:
+        RollSd() : mean(0.0), m2(0.0), n(0), n_inf(0) {}
+
+        inline void push( int, double x ){
+            if( !R_FINITE(x) ){
+                n_inf++ ;
+                return ;
+            }
+            n++ ;
+            double delta = x - mean ;
+            mean += delta / n ;
+            m2 += delta * ( x - mean ) ;
+        }
+
+        inline void pop( int, double x ){
+            if( !R_FINITE(x) ){
+                n_inf-- ;
+                return ;
+            }
+            n-- ;
+            if( n == 0 ){
+                mean = m2 = 0.0 ;
+                return ;
+            }
+            double delta = x - mean ;
+            mean -= delta / n ;
+            m2 -= delta * ( x - mean ) ;
+        }
+
+        inline double get() const {
+            if( n + n_inf < 2 ) return NA_REAL ;
+            if( n_inf ) return R_NaN ;
+            return m2 > 0.0 ? ::sqrt( m2 / (n - 1) ) : 0.0 ;
+        }
+
+    private:
+        double mean, m2 ;
+        int n, n_inf ;
+    } ;
+
+    // monotonic deque of (position, value). the front always holds the
+    // extreme of the current window so each value is pushed and popped once
+    template <bool MIN>
+    class RollExtreme {
+    public:
+        typedef std::pair<int,double> Item ;
+
+        RollExtreme() : items() {}
+
+        inline void push( int pos, double x ){
+            while( !items.empty() && dominated( items.back().second, x ) ) items.pop_back() ;
+            items.push_back( Item(pos, x) ) ;
+        }
+
+        inline void pop( int pos, double ){
+            if( !items.empty() && items.front().first == pos ) items.pop_front() ;
+        }
+
+        inline double get() const {
+            if( items.empty() ) return MIN ? R_PosInf : R_NegInf ;
+            return items.front().second ;
+        }
+
+    private:
+        inline bool dominated( double old, double x ) const {
+            return MIN ? ( old >= x ) : ( old <= x ) ;
+        }
+
+        std::deque<Item> items ;
+    } ;
+
+    typedef RollExtreme<true>  RollMin ;
+    typedef RollExtreme<false> RollMax ;
+
+    inline void check_roll_window( double n, bool along ){
+        if( !R_FINITE(n) || n <= 0 ){
+            stop( "window size must be a single positive number" ) ;
+        }
+        if( !along && n != (int)n ){
+            stop( "window size must be an integer when `along` is not supplied" ) ;
+        }
+    }
+
+} // namespace internal
+
+    // rolling aggregate over a trailing frame within each group. The frame is
+    // either the last n rows, or the rows whose `along` value (Date, POSIXct
+    // or numeric, sorted within each group) lies in ( along[i] - n, along[i] ]
+    template <int RTYPE, typename Window>
+    class Roll : public Mutater<REALSXP, Roll<RTYPE,Window> > {
+    public:
+        typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+        Roll( SEXP data_, double n_, SEXP along_, bool na_rm_, bool partial_ ) :
+            data(data_),
+            data_ptr( Rcpp::internal::r_vector_start<RTYPE>(data_) ),
+            n(n_),
+            along( Rf_isNull(along_) ? R_NilValue : (SEXP)NumericVector(along_) ),
+            na_rm(na_rm_),
+            partial(partial_)
+        {
+            internal::check_roll_window( n, !Rf_isNull(along) ) ;
+        }
+
+        void process_slice( NumericVector& out, const SlicingIndex& index, const SlicingIndex& out_index ){
+            if( Rf_isNull(along) ){
+                process_rows( out, index, out_index ) ;
+            } else {
+                process_along( out, index, out_index ) ;
+            }
+        }
+
+    private:
+
+        void process_rows( NumericVector& out, const SlicingIndex& index, const SlicingIndex& out_index ){
+            int size = index.size() ;
+            int width = (int)n ;
+            Window window ;
+            int n_na = 0 ;
+            for( int i=0; i<size; i++){
+                push( window, n_na, i, index ) ;
+                if( i >= width ) pop( window, n_na, i - width, index ) ;
+
+                if( i < width - 1 && !partial ){
+                    out[out_index[i]] = NA_REAL ;
+                } else {
+                    out[out_index[i]] = result( window, n_na ) ;
+                }
+            }
+        }
+
+        void process_along( NumericVector& out, const SlicingIndex& index, const SlicingIndex& out_index ){
+            int size = index.size() ;
+            double* along_ptr = REAL(along) ;
+            Window window ;
+            int n_na = 0 ;
+            int lo = 0, hi = 0 ;
+            for( int i=0; i<size; i++){
+                double current = along_ptr[index[i]] ;
+                if( ISNAN(current) ){
+                    stop( "`along` must not contain missing values" ) ;
+                }
+                if( i > 0 && current < along_ptr[index[i-1]] ){
+                    stop( "`along` must be sorted in increasing order within each group" ) ;
+                }
+                // rows tied with the current one belong to the frame as well
+                for( ; hi < size && along_ptr[index[hi]] <= current ; hi++ ) push( window, n_na, hi, index ) ;
+                for( ; along_ptr[index[lo]] <= current - n ; lo++ ) pop( window, n_na, lo, index ) ;
+
+                out[out_index[i]] = result( window, n_na ) ;
+            }
+        }
+
+        inline double value( int i, const SlicingIndex& index ) const {
+            STORAGE x = data_ptr[index[i]] ;
+            if( Rcpp::traits::is_na<RTYPE>(x) ) return NA_REAL ;
+            return (double)x ;
+        }
+
+        inline void push( Window& window, int& n_na, int i, const SlicingIndex& index ) const {
+            double x = value(i, index) ;
+            if( ISNAN(x) ) n_na++ ;
+            else window.push(i, x) ;
+        }
+
+        inline void pop( Window& window, int& n_na, int i, const SlicingIndex& index ) const {
+            double x = value(i, index) ;
+            if( ISNAN(x) ) n_na-- ;
+            else window.pop(i, x) ;
+        }
+
+        inline double result( const Window& window, int n_na ) const {
+            if( n_na && !na_rm ) return NA_REAL ;
+            return window.get() ;
+        }
+
+        Vector<RTYPE> data ;
+        STORAGE* data_ptr ;
+        double n ;
+        RObject along ;
+        bool na_rm ;
+        bool partial ;
+    } ;
+
+}
+
+#endif
@@ -91,6 +91,9 @@ namespace internal {
 
         inline STORAGE process_chunk( const SlicingIndex& indices ){
             if( is_summary ) return data_ptr[indices.group()] ;
+            if( indices.contiguous() ){
+                return internal::Sum<RTYPE,NA_RM,NaturalSlicingIndex>::process(data_ptr + indices.start(), NaturalSlicingIndex(indices.size())) ;
+            }
             return internal::Sum<RTYPE,NA_RM,SlicingIndex>::process(data_ptr, indices) ;
         }
 
@@ -22,21 +22,29 @@ namespace internal{
 
         inline double process_chunk( const SlicingIndex& indices ){
             if( is_summary ) return NA_REAL ;
+            if( indices.contiguous() ){
+                return variance( data_ptr + indices.start(), NaturalSlicingIndex(indices.size()) ) ;
+            }
+            return variance( data_ptr, indices ) ;
+        }
 
+    private:
+
+        template <typename Index>
+        inline double variance( STORAGE* ptr, const Index& indices ){
             int n=indices.size() ;
             if( n == 1 ) return NA_REAL ;
-            double m = internal::Mean_internal<RTYPE,NA_RM, SlicingIndex>::process( data_ptr, indices );
+            double m = internal::Mean_internal<RTYPE,NA_RM, Index>::process( ptr, indices );
 
             if( !R_FINITE(m) ) return m ;
 
             double sum = 0.0 ;
             for( int i=0; i<n; i++){
-                sum += internal::square( data_ptr[indices[i]] - m ) ;
+                sum += internal::square( ptr[indices[i]] - m ) ;
             }
             return sum / ( n - 1 );
         }
 
-    private:
         STORAGE* data_ptr ;
         bool is_summary ;
     } ;
@@ -58,17 +66,26 @@ namespace internal{
 
         inline double process_chunk( const SlicingIndex& indices ){
             if( is_summary ) return NA_REAL ;
+            if( indices.contiguous() ){
+                return variance( data_ptr + indices.start(), NaturalSlicingIndex(indices.size()) ) ;
+            }
+            return variance( data_ptr, indices ) ;
+        }
 
+    private:
+
+        template <typename Index>
+        inline double variance( STORAGE* ptr, const Index& indices ){
             int n=indices.size() ;
             if( n == 1 ) return NA_REAL ;
-            double m = internal::Mean_internal<RTYPE,true,SlicingIndex>::process( data_ptr, indices );
+            double m = internal::Mean_internal<RTYPE,true,Index>::process( ptr, indices );
 
             if( !R_FINITE(m) ) return m ;
 
             double sum = 0.0 ;
             int count = 0 ;
             for( int i=0; i<n; i++){
-                STORAGE current = data_ptr[indices[i]] ;
+                STORAGE current = ptr[indices[i]] ;
                 if( Rcpp::Vector<RTYPE>::is_na(current) ) continue ;
                 sum += internal::square( current - m ) ;
                 count++ ;
@@ -77,7 +94,6 @@ namespace internal{
             return sum / ( count - 1 );
         }
 
-    private:
         STORAGE* data_ptr ;
         bool is_summary ;
     } ;
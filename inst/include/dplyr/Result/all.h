@@ -15,6 +15,9 @@
 #include <dplyr/Result/Sd.h>
 #include <dplyr/Result/min.h>
 #include <dplyr/Result/max.h>
+#include <dplyr/Result/ConstantColumn.h>
+#include <dplyr/Result/Partial.h>
+#include <dplyr/Result/ParallelReduction.h>
 #include <dplyr/Result/CallElementProxy.h>
 
 #include <dplyr/Result/DelayedProcessor.h>
@@ -38,6 +41,7 @@
 #include <dplyr/Result/Mutater.h>
 #include <dplyr/Result/Lead.h>
 #include <dplyr/Result/Lag.h>
+#include <dplyr/Result/Roll.h>
 #include <dplyr/Result/CumSum.h>
 #include <dplyr/Result/CumMin.h>
 #include <dplyr/Result/CumMax.h>
@@ -0,0 +1,172 @@
+#ifndef dplyr_RowPartitions_H
+#define dplyr_RowPartitions_H
+
+namespace dplyr {
+
+    // hashes of all the rows of both data frames of a DataFrameJoinVisitors,
+    // computed once and column by column, and the rows of each side split by
+    // hash into partitions. Equal rows always fall in the same partition, so
+    // a set operation can be resolved one partition at a time, each with a
+    // small hash set that never has to recompute a hash.
+    //
+    // As elsewhere, row i of the left data frame is i and row i of the right
+    // data frame is -i-1. Within a partition, rows keep their original order.
+    //
+    // Partitions are independent, so they can be resolved on several
+    // threads with run(). The constructor packs the keys of the visitors,
+    // if they can be packed, so the workers only read the visitors.
+    class RowPartitions {
+    public:
+        RowPartitions( DataFrameJoinVisitors& visitors_, int n_left_, int n_right_ ) :
+            visitors(visitors_), n_left(n_left_), n_right(n_right_),
+            hashes_left(n_left_), hashes_right(n_right_),
+            npartitions( count_partitions(n_left_ + n_right_) ),
+            left_rows(n_left_), right_rows(n_right_),
+            left_offsets(npartitions + 1, 0), right_offsets(npartitions + 1, 0)
+        {
+            hash_rows() ;
+            split( hashes_left, left_rows, left_offsets, 0 ) ;
+            split( hashes_right, right_rows, right_offsets, 1 ) ;
+        }
+
+        inline int size() const { return npartitions ; }
+
+        // the number of ranges of partitions that run() uses
+        inline int ranges( const ExecutionContext& context ) const {
+            return context.ranges( npartitions, n_left + n_right ) ;
+        }
+
+        // calls body( range, begin, end ) for ranges of partitions, on the
+        // threads of context
+        template <typename Body>
+        inline void run( const ExecutionContext& context, Body& body ) const {
+            context.run( npartitions, n_left + n_right, body ) ;
+        }
+
+        inline size_t hash( int i ) const {
+            return i >= 0 ? hashes_left[i] : hashes_right[-i-1] ;
+        }
+
+        // rows of the left data frame in partition p, as indices into it
+        inline const int* left_begin( int p ) const { return left_rows.empty() ? 0 : &left_rows[0] + left_offsets[p] ; }
+        inline int left_size( int p ) const { return left_offsets[p+1] - left_offsets[p] ; }
+
+        // rows of the right data frame in partition p, as -i-1
+        inline const int* right_begin( int p ) const { return right_rows.empty() ? 0 : &right_rows[0] + right_offsets[p] ; }
+        inline int right_size( int p ) const { return right_offsets[p+1] - right_offsets[p] ; }
+
+        class Hasher {
+        public:
+            Hasher( const RowPartitions* partitions_ ) : partitions(partitions_) {}
+            inline size_t operator()( int i ) const {
+                return partitions->hash(i) ;
+            }
+        private:
+            const RowPartitions* partitions ;
+        } ;
+
+        typedef VisitorSetEqualPredicate<DataFrameJoinVisitors> EqualPredicate ;
+
+        inline EqualPredicate equal_predicate() const {
+            return EqualPredicate(&visitors) ;
+        }
+
+        // a set for the rows of partition p
+        class Set : public dplyr_hash_set<int, Hasher, EqualPredicate> {
+        private:
+            typedef dplyr_hash_set<int, Hasher, EqualPredicate> Base ;
+
+        public:
+            Set( const RowPartitions& partitions, int p ) :
+                Base(
+                    std::max( partitions.left_size(p) + partitions.right_size(p), 1 ),
+                    Hasher(&partitions), partitions.equal_predicate()
+                )
+            {}
+        } ;
+
+        // a map from the rows of partition p, e.g. to counts
+        template <typename Value>
+        class Map : public dplyr_hash_map<int, Value, Hasher, EqualPredicate> {
+        private:
+            typedef dplyr_hash_map<int, Value, Hasher, EqualPredicate> Base ;
+
+        public:
+            Map( const RowPartitions& partitions, int p ) :
+                Base(
+                    std::max( partitions.left_size(p) + partitions.right_size(p), 1 ),
+                    Hasher(&partitions), partitions.equal_predicate()
+                )
+            {}
+        } ;
+
+    private:
+
+        // same values as DataFrameJoinVisitors::hash, one column at a time
+        // unless the keys are packed
+        void hash_rows(){
+            int nvisitors = visitors.size() ;
+            if( nvisitors == 0 ){
+                stop("need at least one column for hash()") ;
+            }
+            if( visitors.packed() ){
+                for( int i=0; i<n_left; i++) hashes_left[i] = visitors.hash(i) ;
+                for( int i=0; i<n_right; i++) hashes_right[i] = visitors.hash(-i-1) ;
+                return ;
+            }
+            for( int k=0; k<nvisitors; k++){
+                JoinVisitor* v = visitors.get(k) ;
+                if( k == 0 ){
+                    for( int i=0; i<n_left; i++) hashes_left[i] = v->hash(i) ;
+                    for( int i=0; i<n_right; i++) hashes_right[i] = v->hash(-i-1) ;
+                } else {
+                    for( int i=0; i<n_left; i++) boost::hash_combine( hashes_left[i], v->hash(i) ) ;
+                    for( int i=0; i<n_right; i++) boost::hash_combine( hashes_right[i], v->hash(-i-1) ) ;
+                }
+            }
+        }
+
+        // stable counting sort of the rows by partition
+        void split( const std::vector<size_t>& hashes, std::vector<int>& rows, std::vector<int>& offsets, int right ){
+            int n = hashes.size() ;
+            std::vector<int> partition_of(n) ;
+            for( int i=0; i<n; i++){
+                partition_of[i] = partition( hashes[i] ) ;
+                offsets[ partition_of[i] + 1 ]++ ;
+            }
+            for( int p=0; p<npartitions; p++) offsets[p+1] += offsets[p] ;
+
+            std::vector<int> next( offsets.begin(), offsets.end() - 1 ) ;
+            for( int i=0; i<n; i++){
+                rows[ next[ partition_of[i] ]++ ] = right ? -i-1 : i ;
+            }
+        }
+
+        // the hash sets bucket rows by the low bits of the hash, so the
+        // partition is taken from mixed bits
+        inline int partition( size_t h ) const {
+            if( npartitions == 1 ) return 0 ;
+            unsigned int x = (unsigned int)( h ^ ( h >> 16 ) ) ;
+            x *= 0x45d9f3bU ;
+            x ^= x >> 16 ;
+            return x & ( npartitions - 1 ) ;
+        }
+
+        // a power of two, so that each partition holds about 64k rows
+        static int count_partitions( int n ){
+            int p = 1 ;
+            while( p < 1024 && n / p > 65536 ) p *= 2 ;
+            return p ;
+        }
+
+        DataFrameJoinVisitors& visitors ;
+        int n_left, n_right ;
+        std::vector<size_t> hashes_left, hashes_right ;
+        int npartitions ;
+        std::vector<int> left_rows, right_rows ;
+        std::vector<int> left_offsets, right_offsets ;
+    } ;
+
+}
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef dplyr_SortedKeys_H
+#define dplyr_SortedKeys_H
+
+namespace dplyr {
+
+    // whether the rows of data are in the order arrange() gives them when
+    // sorting by the variables vars
+    inline bool rows_sorted_by( const DataFrame& data, const CharacterVector& vars ){
+        OrderVisitors o( data, vars ) ;
+        int n = data.nrows() ;
+        for( int i=1; i<n; i++){
+            for( int k=0; k<o.n; k++){
+                if( o.visitors[k]->equal( i-1, i ) ) continue ;
+                if( o.visitors[k]->before( i, i-1 ) ) return false ;
+                break ;
+            }
+        }
+        return true ;
+    }
+
+    // the variables data frames are sorted by, in ascending order. arrange()
+    // records the leading variables it sorted by in the "dplyr_sorted"
+    // attribute of its result, and sorted_by() declares them. The attribute
+    // is never set on data tables, whose own "sorted" attribute means
+    // something else, and is ignored on them.
+    //
+    // The attribute alone can not be trusted, as code outside of dplyr
+    // copies it along with the other attributes when it reorders or
+    // modifies rows. The keys are only used for columns known to be sorted:
+    // the columns dplyr sorts are registered when they are made, the
+    // columns of other data are checked once, in one pass, and registered
+    // with the result of the check.
+    //
+    // Unlike the group index cache, the registry does not keep the columns
+    // alive: it remembers their addresses, lengths and fingerprint, and
+    // marks them as shared so that R copies them rather than modifying them
+    // in place. It holds the most recently used tables, up to capacity.
+    class SortedKeys {
+    public:
+        SortedKeys() : entries(), collation() {}
+
+        // the variables of the "dplyr_sorted" attribute of data when its
+        // rows are sorted by them, an empty vector otherwise
+        CharacterVector get( const DataFrame& data ){
+            SEXP keys = attribute( data ) ;
+            if( TYPEOF(keys) != STRSXP || Rf_length(keys) == 0 ) return CharacterVector(0) ;
+            CharacterVector vars( keys ) ;
+            if( !has_columns( data, vars ) ) return CharacterVector(0) ;
+
+            check_collation() ;
+            std::vector<SEXP> columns = GroupIndexCache::get_columns( data, vars ) ;
+            size_t print = GroupIndexCache::fingerprint( columns ) ;
+            int k = find( vars, columns, print ) ;
+            bool sorted = k >= 0 ? entries[k].sorted : rows_sorted_by( data, vars ) ;
+            if( k < 0 ) put( vars, columns, print, sorted ) ;
+            return sorted ? vars : CharacterVector(0) ;
+        }
+
+        // whether data is sorted by vars, and possibly by more variables
+        bool sorted_by( const DataFrame& data, const CharacterVector& vars ){
+            int n = vars.size() ;
+            SEXP keys = attribute( data ) ;
+            if( n == 0 || TYPEOF(keys) != STRSXP || Rf_length(keys) < n ) return false ;
+            for( int j=0; j<n; j++){
+                if( !same_name( STRING_ELT(vars, j), STRING_ELT(keys, j) ) ) return false ;
+            }
+            return get( data ).size() > 0 ;
+        }
+
+        // records that data, made by dplyr, is sorted by vars
+        void set( SEXP data, const CharacterVector& vars ){
+            if( Rf_inherits( data, "data.table" ) ) return ;
+            Rf_setAttrib( data, symbol(), vars ) ;
+            check_collation() ;
+            DataFrame df( data ) ;
+            std::vector<SEXP> columns = GroupIndexCache::get_columns( df, vars ) ;
+            size_t print = GroupIndexCache::fingerprint( columns ) ;
+            int k = find( vars, columns, print ) ;
+            if( k >= 0 ){
+                entries[k].sorted = true ;
+            } else {
+                put( vars, columns, print, true ) ;
+            }
+        }
+
+        // records that res, rows of data in the same order, is sorted like
+        // data. The rows of data are not checked: when data is not known to
+        // be sorted, res only gets its attribute, and is checked when used
+        void keep( const DataFrame& data, SEXP res ){
+            SEXP keys = attribute( data ) ;
+            if( TYPEOF(keys) != STRSXP || Rf_length(keys) == 0 ) return ;
+            CharacterVector vars( keys ) ;
+            if( !has_columns( data, vars ) ) return ;
+
+            check_collation() ;
+            std::vector<SEXP> columns = GroupIndexCache::get_columns( data, vars ) ;
+            int k = find( vars, columns, GroupIndexCache::fingerprint( columns ) ) ;
+            if( k < 0 ){
+                if( !Rf_inherits( res, "data.table" ) ) Rf_setAttrib( res, symbol(), vars ) ;
+            } else if( entries[k].sorted ){
+                set( res, vars ) ;
+            }
+        }
+
+        // the number of tables that were dropped
+        int clear(){
+            int n = entries.size() ;
+            entries.clear() ;
+            return n ;
+        }
+
+        static inline SEXP symbol(){
+            return Rf_install( "dplyr_sorted" ) ;
+        }
+
+    private:
+
+        // the number of tables the registry remembers
+        static const int capacity = 256 ;
+
+        struct Entry {
+            std::vector<std::string> vars ;
+            std::vector<SEXP> columns ;
+            std::vector<int> lengths ;
+            size_t print ;
+            // whether the rows are sorted by the variables
+            bool sorted ;
+        } ;
+
+        // the position of the entry of the columns, moved to the front, or -1
+        int find( const CharacterVector& vars, const std::vector<SEXP>& columns, size_t print ){
+            int n = entries.size() ;
+            for( int k=0; k<n; k++){
+                if( !matches( entries[k], vars, columns, print ) ) continue ;
+                if( k > 0 ){
+                    Entry entry = entries[k] ;
+                    entries.erase( entries.begin() + k ) ;
+                    entries.insert( entries.begin(), entry ) ;
+                }
+                return 0 ;
+            }
+            return -1 ;
+        }
+
+        void put( const CharacterVector& vars, const std::vector<SEXP>& columns, size_t print, bool sorted ){
+            while( (int)entries.size() >= capacity ) entries.pop_back() ;
+
+            Entry entry ;
+            entry.columns = columns ;
+            entry.print = print ;
+            entry.sorted = sorted ;
+            int n = columns.size() ;
+            for( int j=0; j<n; j++){
+                entry.vars.push_back( CHAR(STRING_ELT(vars, j)) ) ;
+                entry.lengths.push_back( Rf_length(columns[j]) ) ;
+                SET_NAMED( columns[j], 2 ) ;
+            }
+            entries.insert( entries.begin(), entry ) ;
+        }
+
+        static inline SEXP attribute( const DataFrame& data ){
+            if( Rf_inherits( data, "data.table" ) ) return R_NilValue ;
+            return Rf_getAttrib( data, symbol() ) ;
+        }
+
+        static bool matches( const Entry& entry, const CharacterVector& vars, const std::vector<SEXP>& columns, size_t print ){
+            if( entry.columns.size() != columns.size() || entry.print != print ) return false ;
+            for( size_t j=0; j<columns.size(); j++){
+                if( entry.columns[j] != columns[j] || entry.lengths[j] != Rf_length(columns[j]) ) return false ;
+                if( entry.vars[j] != CHAR(STRING_ELT(vars, j)) ) return false ;
+            }
+            return true ;
+        }
+
+        static bool has_columns( const DataFrame& data, const CharacterVector& vars ){
+            CharacterVector names = data.names() ;
+            IntegerVector indx = r_match( vars, names ) ;
+            for( int j=0; j<indx.size(); j++){
+                if( indx[j] == NA_INTEGER ) return false ;
+                SEXP x = data[ indx[j] - 1 ] ;
+                if( !white_list(x) || TYPEOF(x) == VECSXP ) return false ;
+            }
+            return true ;
+        }
+
+        static inline bool same_name( SEXP a, SEXP b ){
+            return a == b || !strcmp( CHAR(a), CHAR(b) ) ;
+        }
+
+        // strings are sorted in the collation they were compared in
+        void check_collation(){
+            const char* current = setlocale( LC_COLLATE, NULL ) ;
+            std::string now( current ? current : "" ) ;
+            if( now != collation ){
+                clear() ;
+                collation = now ;
+            }
+        }
+
+        std::vector<Entry> entries ;
+        std::string collation ;
+    } ;
+
+    // the registry of the session
+    SortedKeys& sorted_keys() ;
+
+}
+
+#endif
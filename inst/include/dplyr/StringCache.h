@@ -0,0 +1,170 @@
+#ifndef dplyr_StringCache_H
+#define dplyr_StringCache_H
+
+namespace dplyr {
+
+    // strings seen by the verbs of the session, with their rank in sort()
+    // order, so that ordering, grouping or deduplicating the same string
+    // columns again does not call back to R.
+    //
+    // Ranks are computed for the unique strings of one vector at a time,
+    // a batch. Ranks of strings from the same batch are consistent, so a
+    // vector whose strings all come from one batch (e.g. a column that was
+    // already grouped, or a subset of it) is ranked by lookups only. Other
+    // vectors make a new batch of their strings.
+    //
+    // The cached strings are kept alive in a preserved STRSXP, so that their
+    // CHARSXP can be used as keys. The cache is emptied by clear_string_cache(),
+    // when the collation changes, and before new strings are added when it
+    // holds more than getOption("dplyr.string_cache_size") strings.
+    class StringCache {
+    public:
+        typedef dplyr_hash_map<SEXP,int> SlotMap ;
+
+        StringCache() :
+            strings(R_NilValue), nstrings(0), slots(), batch_of(), rank(), nbatches(0), collation()
+        {}
+
+        // ranks of the strings of data, NA for missing values
+        IntegerVector ranks( const CharacterVector& data ){
+            check_collation() ;
+            if( !same_batch(data) ) add_batch(data) ;
+
+            int n = data.size() ;
+            IntegerVector out = no_init(n) ;
+            SEXP* p_data = Rcpp::internal::r_vector_start<STRSXP>(data) ;
+            SEXP previous = 0 ;
+            int previous_rank = NA_INTEGER ;
+            for( int i=0; i<n; i++){
+                SEXP s = p_data[i] ;
+                if( s != previous ){
+                    previous = s ;
+                    previous_rank = s == NA_STRING ? NA_INTEGER : rank[ slots.find(s)->second ] ;
+                }
+                out[i] = previous_rank ;
+            }
+            return out ;
+        }
+
+        inline int size() const { return nstrings ; }
+
+        // the number of strings that were dropped
+        int clear(){
+            int n = nstrings ;
+            if( strings != R_NilValue ) R_ReleaseObject(strings) ;
+            strings = R_NilValue ;
+            nstrings = 0 ;
+            slots.clear() ;
+            batch_of.clear() ;
+            rank.clear() ;
+            return n ;
+        }
+
+    private:
+
+        // are all the strings of data cached, in the same batch
+        bool same_batch( const CharacterVector& data ) const {
+            int n = data.size() ;
+            SEXP* p_data = Rcpp::internal::r_vector_start<STRSXP>(data) ;
+            SEXP previous = 0 ;
+            int batch = -1 ;
+            for( int i=0; i<n; i++){
+                SEXP s = p_data[i] ;
+                if( s == previous || s == NA_STRING ) continue ;
+                previous = s ;
+
+                SlotMap::const_iterator it = slots.find(s) ;
+                if( it == slots.end() ) return false ;
+                if( batch >= 0 && batch_of[it->second] != batch ) return false ;
+                batch = batch_of[it->second] ;
+            }
+            return true ;
+        }
+
+        void add_batch( const CharacterVector& data ){
+            // unique strings of data
+            dplyr_hash_set<SEXP> set ;
+            int n = data.size() ;
+            SEXP* p_data = Rcpp::internal::r_vector_start<STRSXP>(data) ;
+            SEXP previous = 0 ;
+            int nnew = 0 ;
+            for( int i=0; i<n; i++){
+                SEXP s = p_data[i] ;
+                if( s == previous || s == NA_STRING ) continue ;
+                previous = s ;
+                if( set.insert(s).second && !slots.count(s) ) nnew++ ;
+            }
+            if( nnew > 0 && nstrings + nnew > max_size() ) clear() ;
+
+            // order the uniques with a callback to R
+            CharacterVector uniques( set.begin(), set.end() ) ;
+            CharacterVector s_uniques = Language( "sort", uniques ).fast_eval() ;
+            IntegerVector o = r_match( uniques, s_uniques ) ;
+
+            int batch = nbatches++ ;
+            int n_uniques = uniques.size() ;
+            for( int i=0; i<n_uniques; i++){
+                int slot = find_or_add( uniques[i] ) ;
+                batch_of[slot] = batch ;
+                rank[slot] = o[i] ;
+            }
+        }
+
+        int find_or_add( SEXP s ){
+            SlotMap::const_iterator it = slots.find(s) ;
+            if( it != slots.end() ) return it->second ;
+
+            if( nstrings == Rf_length(strings) ) grow() ;
+            SET_STRING_ELT( strings, nstrings, s ) ;
+            slots.insert( std::make_pair(s, nstrings) ) ;
+            batch_of.push_back(-1) ;
+            rank.push_back(NA_INTEGER) ;
+            return nstrings++ ;
+        }
+
+        void grow(){
+            int capacity = std::max( 1024, 2 * nstrings ) ;
+            SEXP bigger = PROTECT( Rf_allocVector(STRSXP, capacity) ) ;
+            for( int i=0; i<nstrings; i++){
+                SET_STRING_ELT( bigger, i, STRING_ELT(strings, i) ) ;
+            }
+            R_PreserveObject(bigger) ;
+            UNPROTECT(1) ;
+            if( strings != R_NilValue ) R_ReleaseObject(strings) ;
+            strings = bigger ;
+        }
+
+        // ranks are only valid for the collation they were computed in
+        void check_collation(){
+            const char* current = setlocale( LC_COLLATE, NULL ) ;
+            std::string now( current ? current : "" ) ;
+            if( now != collation ){
+                clear() ;
+                collation = now ;
+            }
+        }
+
+        static int max_size(){
+            SEXP opt = Rf_GetOption1( Rf_install("dplyr.string_cache_size") ) ;
+            if( Rf_isNumeric(opt) && Rf_length(opt) == 1 ){
+                int size = Rf_asInteger(opt) ;
+                if( size != NA_INTEGER ) return std::max( size, 0 ) ;
+            }
+            return 1000000 ;
+        }
+
+        SEXP strings ;
+        int nstrings ;
+        SlotMap slots ;
+        std::vector<int> batch_of ;
+        std::vector<int> rank ;
+        int nbatches ;
+        std::string collation ;
+    } ;
+
+    // the cache of the session
+    StringCache& string_cache() ;
+
+}
+
+#endif
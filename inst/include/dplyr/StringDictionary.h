@@ -0,0 +1,105 @@
+#ifndef dplyr_StringDictionary_H
+#define dplyr_StringDictionary_H
+
+namespace dplyr {
+
+    // gives the same integer code (1, 2, ...) to equal strings of one or
+    // several character vectors, so that string keys can be compared as
+    // integers. Strings are looked up by their CHARSXP, which R already
+    // shares between equal strings of the same encoding. Equal non ASCII
+    // strings in different encodings have different CHARSXP, so the first
+    // time such a string is seen it is also looked up by its UTF-8 bytes.
+    class StringDictionary {
+    public:
+        typedef dplyr_hash_map<SEXP,int> CodeMap ;
+        typedef dplyr_hash_map<std::string,int> Utf8Map ;
+
+        StringDictionary() : codes(), utf8_codes(), uniques() {}
+
+        // missing values get NA_INTEGER
+        IntegerVector encode( const CharacterVector& x ){
+            int n = x.size() ;
+            IntegerVector out = no_init(n) ;
+            int* p_out = out.begin() ;
+            SEXP* p_x = Rcpp::internal::r_vector_start<STRSXP>(x) ;
+
+            // consecutive equal strings are common in keys, skip the lookup
+            SEXP previous = 0 ;
+            int previous_code = NA_INTEGER ;
+            for( int i=0; i<n; i++){
+                SEXP s = p_x[i] ;
+                if( s != previous ){
+                    previous = s ;
+                    previous_code = code(s) ;
+                }
+                p_out[i] = previous_code ;
+            }
+            return out ;
+        }
+
+        // codes of the factor's values, through its levels
+        IntegerVector encode_factor( const IntegerVector& x ){
+            CharacterVector levels = x.attr("levels") ;
+            IntegerVector level_codes = encode( levels ) ;
+            int* p_levels = level_codes.begin() ;
+            int n = x.size() ;
+            IntegerVector out = no_init(n) ;
+            for( int i=0; i<n; i++){
+                int level = x[i] ;
+                out[i] = level == NA_INTEGER ? NA_INTEGER : p_levels[level - 1] ;
+            }
+            return out ;
+        }
+
+        // the first string that was given this code
+        inline SEXP get( int code ) const {
+            return code == NA_INTEGER ? NA_STRING : uniques[code - 1] ;
+        }
+
+        inline int size() const {
+            return uniques.size() ;
+        }
+
+    private:
+
+        inline int code( SEXP s ){
+            if( s == NA_STRING ) return NA_INTEGER ;
+
+            CodeMap::const_iterator it = codes.find(s) ;
+            if( it != codes.end() ) return it->second ;
+
+            int res ;
+            if( IS_ASCII(s) || IS_BYTES(s) ){
+                res = add(s) ;
+            } else {
+                const void* vmax = vmaxget() ;
+                std::string utf8( Rf_translateCharUTF8(s) ) ;
+                vmaxset(vmax) ;
+
+                Utf8Map::const_iterator uit = utf8_codes.find(utf8) ;
+                if( uit != utf8_codes.end() ){
+                    res = uit->second ;
+                } else {
+                    res = add(s) ;
+                    utf8_codes.insert( std::make_pair(utf8, res) ) ;
+                }
+            }
+            codes.insert( std::make_pair(s, res) ) ;
+            return res ;
+        }
+
+        inline int add( SEXP s ){
+            uniques.push_back(s) ;
+            return uniques.size() ;
+        }
+
+        CodeMap codes ;
+        Utf8Map utf8_codes ;
+
+        // no need to protect these, they belong to the encoded vectors
+        std::vector<SEXP> uniques ;
+    } ;
+
+}
+
+#endif
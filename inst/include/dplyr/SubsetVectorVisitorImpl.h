@@ -27,6 +27,9 @@ namespace dplyr {
         }
 
         inline SEXP subset( const SlicingIndex& index) const {
+            if( index.contiguous() ){
+                return subset_range( index.start(), index.size() ) ;
+            }
             return subset_int_index( index) ;
         }
 
@@ -87,8 +90,37 @@ namespace dplyr {
             return out ;
         }
 
+        inline SEXP subset_range( int start, int n ) const {
+            VECTOR out = Rcpp::no_init(n) ;
+            STORAGE* p_vec = Rcpp::internal::r_vector_start<RTYPE>(vec) + start ;
+            std::copy( p_vec, p_vec + n, Rcpp::internal::r_vector_start<RTYPE>(out) ) ;
+            copy_most_attributes(out, vec) ;
+            return out ;
+        }
+
     } ;
 
+    // elements of lists and character vectors must go through the write barrier
+    template <>
+    inline SEXP SubsetVectorVisitorImpl<STRSXP>::subset_range( int start, int n ) const {
+        CharacterVector out = Rcpp::no_init(n) ;
+        for( int i=0; i<n; i++){
+            SET_STRING_ELT( out, i, STRING_ELT(vec, start + i) ) ;
+        }
+        copy_most_attributes(out, vec) ;
+        return out ;
+    }
+
+    template <>
+    inline SEXP SubsetVectorVisitorImpl<VECSXP>::subset_range( int start, int n ) const {
+        List out(n) ;
+        for( int i=0; i<n; i++){
+            SET_VECTOR_ELT( out, i, VECTOR_ELT(vec, start + i) ) ;
+        }
+        copy_most_attributes(out, vec) ;
+        return out ;
+    }
+
     template <>
     template <typename Container>
     SEXP SubsetVectorVisitorImpl<VECSXP>::subset_int_index( const Container& index ) const {
@@ -9,6 +9,18 @@
 #define DPLYR_INTERUPT_TIMES 10
 #endif
 
+#ifndef DPLYR_MIN_PARALLEL_SIZE
+#define DPLYR_MIN_PARALLEL_SIZE 100000
+#endif
+
+#ifndef DPLYR_SPILL_PARTITIONS
+#define DPLYR_SPILL_PARTITIONS 64
+#endif
+
+#ifndef DPLYR_DIRECT_INDEX_RATIO
+#define DPLYR_DIRECT_INDEX_RATIO 4
+#endif
+
 #endif
 
 
@@ -11,6 +11,12 @@ inline DataFrame build_index_cpp( DataFrame data ){
     return fun(data) ;
 }
 
+inline DataFrame build_index_adj( DataFrame data, ListOf<Symbol> symbols ){
+    typedef DataFrame (*Fun)(DataFrame, ListOf<Symbol>) ;
+    GRAB_CALLABLE(build_index_adj)
+    return fun(data, symbols) ;
+}
+
 inline void registerHybridHandler( const char* name, HybridHandler proto){
     typedef void (*Fun)(const char*, HybridHandler ) ;
     GRAB_CALLABLE(registerHybridHandler)
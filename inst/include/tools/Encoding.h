@@ -6,6 +6,10 @@
 #define LATIN1_MASK (1<<2)
 #define UTF8_MASK (1<<3)
 
+#ifndef ASCII_MASK
+# define ASCII_MASK (1<<6)
+#endif
+
 // that bit seems unused by R. Just using it to mark
 // objects as Shrinkable Vectors
 // that is useful for things like summarise(list(x)) where x is a
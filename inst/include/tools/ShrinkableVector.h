@@ -29,8 +29,12 @@ namespace Rcpp {
 
         inline void borrow(const SlicingIndex& indices, STORAGE* begin){
             int n = indices.size() ;
-            for( int i=0; i<n ; i++){
-                start[i] = begin[indices[i]] ;
+            if( indices.contiguous() ){
+                std::copy( begin + indices.start(), begin + indices.start() + n, start ) ;
+            } else {
+                for( int i=0; i<n ; i++){
+                    start[i] = begin[indices[i]] ;
+                }
             }
             SETLENGTH(data, n) ;
         }
@@ -1,31 +1,57 @@
 #ifndef dplyr_tools_SlicingIndex_H
 #define dplyr_tools_SlicingIndex_H
 
+// rows of a group. Either an arbitrary set of indices, or a range of
+// consecutive rows that is only described by its start and length so that
+// slicing all the rows of a large data frame does not allocate anything
 class SlicingIndex {
 public:
 
-    SlicingIndex(IntegerVector data_) : data(data_), group_index(-1) {}
-    SlicingIndex(IntegerVector data_, int group_) : data(data_), group_index(group_) {}
+    SlicingIndex(IntegerVector data_) : data(data_), group_index(-1), first(0), n(data.size()), range(false) {}
+    SlicingIndex(IntegerVector data_, int group_) : data(data_), group_index(group_), first(0), n(data.size()), range(false) {}
 
-    SlicingIndex(int start, int n) : data(0), group_index(-1) {
-        if(n>0) {
-            data = seq(start, start + n - 1 ) ;
-        }
-    }
+    SlicingIndex(int start_, int n_) : data(0), group_index(-1), first(start_), n(std::max(n_, 0)), range(true) {}
+
+    SlicingIndex(int start_, int n_, int group_) : data(0), group_index(group_), first(start_), n(std::max(n_, 0)), range(true) {}
 
     inline int size() const {
-        return data.size() ;
+        return n ;
     }
 
     inline int operator[](int i) const {
-        return data[i] ;
+        return range ? first + i : data[i] ;
     }
 
     inline int group() const { return group_index ; }
 
+    // when true, the rows are start(), ..., start() + size() - 1
+    inline bool contiguous() const { return range ; }
+    inline int start() const { return first ; }
+
 // private:
     IntegerVector data ;
     int group_index ;
+    int first ;
+    int n ;
+    bool range ;
+} ;
+
+// indices 0, ..., n-1. Used with a pointer to the first row of a contiguous
+// SlicingIndex so that loops templated on the index type become plain loops
+class NaturalSlicingIndex {
+public:
+    NaturalSlicingIndex( int n_ ) : n(n_) {}
+
+    inline int size() const {
+        return n ;
+    }
+
+    inline int operator[](int i) const {
+        return i ;
+    }
+
+private:
+    int n ;
 } ;
 
 #endif
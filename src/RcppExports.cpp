@@ -50,6 +50,64 @@ BEGIN_RCPP
     return __result;
 END_RCPP
 }
+// clear_string_cache
+int clear_string_cache();
+RcppExport SEXP dplyr_clear_string_cache() {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    __result = Rcpp::wrap(clear_string_cache());
+    return __result;
+END_RCPP
+}
+// clear_group_index_cache
+int clear_group_index_cache();
+RcppExport SEXP dplyr_clear_group_index_cache() {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    __result = Rcpp::wrap(clear_group_index_cache());
+    return __result;
+END_RCPP
+}
+// threads_impl
+int threads_impl();
+RcppExport SEXP dplyr_threads_impl() {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    __result = Rcpp::wrap(threads_impl());
+    return __result;
+END_RCPP
+}
+// profile_start
+void profile_start();
+RcppExport SEXP dplyr_profile_start() {
+BEGIN_RCPP
+    Rcpp::RNGScope __rngScope;
+    profile_start();
+    return R_NilValue;
+END_RCPP
+}
+// profile_stop
+void profile_stop();
+RcppExport SEXP dplyr_profile_stop() {
+BEGIN_RCPP
+    Rcpp::RNGScope __rngScope;
+    profile_stop();
+    return R_NilValue;
+END_RCPP
+}
+// profile_get
+List profile_get();
+RcppExport SEXP dplyr_profile_get() {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    __result = Rcpp::wrap(profile_get());
+    return __result;
+END_RCPP
+}
 // arrange_impl
 List arrange_impl(DataFrame data, LazyDots dots);
 RcppExport SEXP dplyr_arrange_impl(SEXP dataSEXP, SEXP dotsSEXP) {
@@ -62,6 +120,42 @@ BEGIN_RCPP
     return __result;
 END_RCPP
 }
+// sorted_by_impl
+DataFrame sorted_by_impl(DataFrame data, CharacterVector vars);
+RcppExport SEXP dplyr_sorted_by_impl(SEXP dataSEXP, SEXP varsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< DataFrame >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type vars(varsSEXP);
+    __result = Rcpp::wrap(sorted_by_impl(data, vars));
+    return __result;
+END_RCPP
+}
+// sorted_vars_impl
+CharacterVector sorted_vars_impl(DataFrame data);
+RcppExport SEXP dplyr_sorted_vars_impl(SEXP dataSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< DataFrame >::type data(dataSEXP);
+    __result = Rcpp::wrap(sorted_vars_impl(data));
+    return __result;
+END_RCPP
+}
+// arrange_head_impl
+List arrange_head_impl(DataFrame data, LazyDots dots, int n);
+RcppExport SEXP dplyr_arrange_head_impl(SEXP dataSEXP, SEXP dotsSEXP, SEXP nSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< DataFrame >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< LazyDots >::type dots(dotsSEXP);
+    Rcpp::traits::input_parameter< int >::type n(nSEXP);
+    __result = Rcpp::wrap(arrange_head_impl(data, dots, n));
+    return __result;
+END_RCPP
+}
 // between
 LogicalVector between(NumericVector x, double left, double right);
 RcppExport SEXP dplyr_between(SEXP xSEXP, SEXP leftSEXP, SEXP rightSEXP) {
@@ -120,6 +214,122 @@ BEGIN_RCPP
     return __result;
 END_RCPP
 }
+// paged_collecter
+XPtr<DataFrameCollecter> paged_collecter(CharacterVector vars);
+RcppExport SEXP dplyr_paged_collecter(SEXP varsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< CharacterVector >::type vars(varsSEXP);
+    __result = Rcpp::wrap(paged_collecter(vars));
+    return __result;
+END_RCPP
+}
+// paged_collecter_push
+int paged_collecter_push(XPtr<DataFrameCollecter> builder, DataFrame page);
+RcppExport SEXP dplyr_paged_collecter_push(SEXP builderSEXP, SEXP pageSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< XPtr<DataFrameCollecter> >::type builder(builderSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type page(pageSEXP);
+    __result = Rcpp::wrap(paged_collecter_push(builder, page));
+    return __result;
+END_RCPP
+}
+// paged_collecter_get
+SEXP paged_collecter_get(XPtr<DataFrameCollecter> builder);
+RcppExport SEXP dplyr_paged_collecter_get(SEXP builderSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< XPtr<DataFrameCollecter> >::type builder(builderSEXP);
+    __result = Rcpp::wrap(paged_collecter_get(builder));
+    return __result;
+END_RCPP
+}
+// group_splitter
+XPtr<GroupSplitter> group_splitter(CharacterVector vars);
+RcppExport SEXP dplyr_group_splitter(SEXP varsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< CharacterVector >::type vars(varsSEXP);
+    __result = Rcpp::wrap(group_splitter(vars));
+    return __result;
+END_RCPP
+}
+// group_splitter_push
+List group_splitter_push(XPtr<GroupSplitter> splitter, DataFrame page);
+RcppExport SEXP dplyr_group_splitter_push(SEXP splitterSEXP, SEXP pageSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< XPtr<GroupSplitter> >::type splitter(splitterSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type page(pageSEXP);
+    __result = Rcpp::wrap(group_splitter_push(splitter, page));
+    return __result;
+END_RCPP
+}
+// group_splitter_flush
+SEXP group_splitter_flush(XPtr<GroupSplitter> splitter);
+RcppExport SEXP dplyr_group_splitter_flush(SEXP splitterSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< XPtr<GroupSplitter> >::type splitter(splitterSEXP);
+    __result = Rcpp::wrap(group_splitter_flush(splitter));
+    return __result;
+END_RCPP
+}
+// group_splitter_labels
+SEXP group_splitter_labels(XPtr<GroupSplitter> splitter);
+RcppExport SEXP dplyr_group_splitter_labels(SEXP splitterSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< XPtr<GroupSplitter> >::type splitter(splitterSEXP);
+    __result = Rcpp::wrap(group_splitter_labels(splitter));
+    return __result;
+END_RCPP
+}
+// external_summariser
+XPtr<ExternalSummariser> external_summariser(CharacterVector vars, List specs, std::string dir, double budget);
+RcppExport SEXP dplyr_external_summariser(SEXP varsSEXP, SEXP specsSEXP, SEXP dirSEXP, SEXP budgetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< CharacterVector >::type vars(varsSEXP);
+    Rcpp::traits::input_parameter< List >::type specs(specsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< double >::type budget(budgetSEXP);
+    __result = Rcpp::wrap(external_summariser(vars, specs, dir, budget));
+    return __result;
+END_RCPP
+}
+// external_summariser_push
+int external_summariser_push(XPtr<ExternalSummariser> summariser, DataFrame chunk);
+RcppExport SEXP dplyr_external_summariser_push(SEXP summariserSEXP, SEXP chunkSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< XPtr<ExternalSummariser> >::type summariser(summariserSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type chunk(chunkSEXP);
+    __result = Rcpp::wrap(external_summariser_push(summariser, chunk));
+    return __result;
+END_RCPP
+}
+// external_summariser_get
+SEXP external_summariser_get(XPtr<ExternalSummariser> summariser);
+RcppExport SEXP dplyr_external_summariser_get(SEXP summariserSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< XPtr<ExternalSummariser> >::type summariser(summariserSEXP);
+    __result = Rcpp::wrap(external_summariser_get(summariser));
+    return __result;
+END_RCPP
+}
 // combine_vars
 SEXP combine_vars(CharacterVector vars, ListOf<IntegerVector> xs);
 RcppExport SEXP dplyr_combine_vars(SEXP varsSEXP, SEXP xsSEXP) {
@@ -132,6 +342,20 @@ BEGIN_RCPP
     return __result;
 END_RCPP
 }
+// cube_summarise_impl
+SEXP cube_summarise_impl(SEXP x, IntegerVector groups, std::string fun, bool na_rm);
+RcppExport SEXP dplyr_cube_summarise_impl(SEXP xSEXP, SEXP groupsSEXP, SEXP funSEXP, SEXP na_rmSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type groups(groupsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type fun(funSEXP);
+    Rcpp::traits::input_parameter< bool >::type na_rm(na_rmSEXP);
+    __result = Rcpp::wrap(cube_summarise_impl(x, groups, fun, na_rm));
+    return __result;
+END_RCPP
+}
 // distinct_impl
 SEXP distinct_impl(DataFrame df, CharacterVector vars, CharacterVector keep);
 RcppExport SEXP dplyr_distinct_impl(SEXP dfSEXP, SEXP varsSEXP, SEXP keepSEXP) {
@@ -155,6 +379,29 @@ BEGIN_RCPP
     return R_NilValue;
 END_RCPP
 }
+// index_by_impl
+DataFrame index_by_impl(DataFrame data, CharacterVector vars);
+RcppExport SEXP dplyr_index_by_impl(SEXP dataSEXP, SEXP varsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< DataFrame >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type vars(varsSEXP);
+    __result = Rcpp::wrap(index_by_impl(data, vars));
+    return __result;
+END_RCPP
+}
+// indexed_vars_impl
+CharacterVector indexed_vars_impl(DataFrame data);
+RcppExport SEXP dplyr_indexed_vars_impl(SEXP dataSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< DataFrame >::type data(dataSEXP);
+    __result = Rcpp::wrap(indexed_vars_impl(data));
+    return __result;
+END_RCPP
+}
 // semi_join_impl
 DataFrame semi_join_impl(DataFrame x, DataFrame y, CharacterVector by_x, CharacterVector by_y);
 RcppExport SEXP dplyr_semi_join_impl(SEXP xSEXP, SEXP ySEXP, SEXP by_xSEXP, SEXP by_ySEXP) {
@@ -548,6 +795,75 @@ BEGIN_RCPP
     return __result;
 END_RCPP
 }
+// mapped_table
+XPtr<MappedTable> mapped_table(std::string dir, IntegerVector types, int nrows);
+RcppExport SEXP dplyr_mapped_table(SEXP dirSEXP, SEXP typesSEXP, SEXP nrowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type types(typesSEXP);
+    Rcpp::traits::input_parameter< int >::type nrows(nrowsSEXP);
+    __result = Rcpp::wrap(mapped_table(dir, types, nrows));
+    return __result;
+END_RCPP
+}
+// mapped_table_column
+SEXP mapped_table_column(XPtr<MappedTable> table, int j, SEXP rows);
+RcppExport SEXP dplyr_mapped_table_column(SEXP tableSEXP, SEXP jSEXP, SEXP rowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< XPtr<MappedTable> >::type table(tableSEXP);
+    Rcpp::traits::input_parameter< int >::type j(jSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type rows(rowsSEXP);
+    __result = Rcpp::wrap(mapped_table_column(table, j, rows));
+    return __result;
+END_RCPP
+}
+// write_mapped_column_impl
+void write_mapped_column_impl(SEXP x, std::string dir, int j);
+RcppExport SEXP dplyr_write_mapped_column_impl(SEXP xSEXP, SEXP dirSEXP, SEXP jSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< int >::type j(jSEXP);
+    write_mapped_column_impl(x, dir, j);
+    return R_NilValue;
+END_RCPP
+}
+// roll_impl
+NumericVector roll_impl(SEXP x, double n, SEXP along, bool na_rm, bool partial, std::string fun);
+RcppExport SEXP dplyr_roll_impl(SEXP xSEXP, SEXP nSEXP, SEXP alongSEXP, SEXP na_rmSEXP, SEXP partialSEXP, SEXP funSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< double >::type n(nSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type along(alongSEXP);
+    Rcpp::traits::input_parameter< bool >::type na_rm(na_rmSEXP);
+    Rcpp::traits::input_parameter< bool >::type partial(partialSEXP);
+    Rcpp::traits::input_parameter< std::string >::type fun(funSEXP);
+    __result = Rcpp::wrap(roll_impl(x, n, along, na_rm, partial, fun));
+    return __result;
+END_RCPP
+}
+// sample_grouped_impl
+DataFrame sample_grouped_impl(DataFrame df, double size, bool frac, bool replace, SEXP weight);
+RcppExport SEXP dplyr_sample_grouped_impl(SEXP dfSEXP, SEXP sizeSEXP, SEXP fracSEXP, SEXP replaceSEXP, SEXP weightSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< DataFrame >::type df(dfSEXP);
+    Rcpp::traits::input_parameter< double >::type size(sizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type frac(fracSEXP);
+    Rcpp::traits::input_parameter< bool >::type replace(replaceSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type weight(weightSEXP);
+    __result = Rcpp::wrap(sample_grouped_impl(df, size, frac, replace, weight));
+    return __result;
+END_RCPP
+}
 // select_impl
 DataFrame select_impl(DataFrame df, CharacterVector vars);
 RcppExport SEXP dplyr_select_impl(SEXP dfSEXP, SEXP varsSEXP) {
@@ -9,10 +9,13 @@ namespace dplyr{
         nvisitors(visitor_names.size())
     {
 
+        std::vector<SEXP> columns ;
         for( int i=0; i<nvisitors; i++){
             VectorVisitor* v = visitor( data[i] ) ;
             visitors.push_back(v) ;
+            columns.push_back( data[i] ) ;
         }
+        pack_keys( columns ) ;
     }
 
     DataFrameVisitors::DataFrameVisitors( const Rcpp::DataFrame& data_, const Rcpp::CharacterVector& names ) :
@@ -25,6 +28,7 @@ namespace dplyr{
         std::string name ;
         int n = names.size() ;
         IntegerVector indices  = r_match( names,  RCPP_GET_NAMES(data)  ) ;
+        std::vector<SEXP> columns ;
 
         for( int i=0; i<n; i++){
             if( indices[i] == NA_INTEGER){
@@ -33,8 +37,16 @@ namespace dplyr{
             }
             SEXP column = data[indices[i]-1];
             visitors.push_back(visitor( column )) ;
+            columns.push_back( column ) ;
         }
+        pack_keys( columns ) ;
+    }
 
+    void DataFrameVisitors::pack_keys( const std::vector<SEXP>& columns ){
+        for( size_t k=0; k<columns.size(); k++){
+            if( !PackedKeys::packable( columns[k] ) ) return ;
+        }
+        keys.set( columns, std::vector<SEXP>() ) ;
     }
 
     void DataFrameVisitors::structure( List& x, int nrows, CharacterVector classes ) const {
@@ -62,6 +74,8 @@ namespace dplyr{
 
         IntegerVector indices_left  = r_match( names_left,  RCPP_GET_NAMES(left)  ) ;
         IntegerVector indices_right = r_match( names_right, RCPP_GET_NAMES(right) ) ;
+        std::vector<SEXP> columns_left, columns_right ;
+        bool packable = true ;
 
         for( int i=0; i<nvisitors; i++){
             name_left  = names_left[i] ;
@@ -75,7 +89,16 @@ namespace dplyr{
             }
 
             visitors[i] = join_visitor( left[indices_left[i]-1], right[indices_right[i]-1], name_left, name_right, warn ) ;
+
+            SEXP column_left = left[indices_left[i]-1], column_right = right[indices_right[i]-1] ;
+            if( packable && PackedKeys::packable( column_left, column_right ) ){
+                columns_left.push_back( column_left ) ;
+                columns_right.push_back( column_right ) ;
+            } else {
+                packable = false ;
+            }
         }
+        if( packable ) keys.set( columns_left, columns_right ) ;
     }
 
     Symbol extract_column( SEXP arg, const Environment& env ){
@@ -124,6 +147,7 @@ namespace dplyr{
             for( int i=0; i<n; i++){
                 proxies[i].set( subsets[proxies[i].symbol] ) ;
             }
+            profiler().callback() ;
             return call.eval(env) ;
         } else if( TYPEOF(call) == SYMSXP) {
             // SYMSXP
@@ -277,74 +301,89 @@ namespace dplyr{
 
     CharacterVectorOrderer::CharacterVectorOrderer( const CharacterVector& data_ ) :
         data(data_),
-        set(),
-        orders(no_init(data.size()))
-    {
-        int n = data.size() ;
-        if( n == 0 ) return ;
-
-        // 1 - gather unique SEXP pointers from data
-        SEXP* p_data = Rcpp::internal::r_vector_start<STRSXP>(data);
-        SEXP previous = *p_data++ ;
-        set.insert( previous ) ;
-        for( int i=1; i<n; i++, p_data++){
-            SEXP s = *p_data ;
-
-            // we've just seen this string, keep going
-            if( s == previous ) continue ;
-
-            // is this string in the set already
-            set.insert(s) ;
-            previous = s ;
-        }
+        orders( string_cache().ranks(data) )
+    {}
 
-        // retrieve unique strings from the set
-        int n_uniques = set.size() ;
-        CharacterVector uniques( set.begin(), set.end() ) ;
-        CharacterVector s_uniques = Language( "sort", uniques ).fast_eval() ;
+    StringCache& string_cache(){
+        static StringCache cache ;
+        return cache ;
+    }
 
-        // order the uniques with a callback to R
-        IntegerVector o = r_match(uniques, s_uniques ) ;
+    Profiler& profiler(){
+        static Profiler p ;
+        return p ;
+    }
 
-        // combine uniques and o into a hash map for fast retrieval
-        dplyr_hash_map<SEXP,int> map ;
-        for( int i=0; i<n_uniques; i++){
-            map.insert( std::make_pair(uniques[i], o[i] ) ) ;
-        }
+    GroupIndexCache& group_index_cache(){
+        static GroupIndexCache cache ;
+        return cache ;
+    }
 
-        // grab min ranks
-        p_data = Rcpp::internal::r_vector_start<STRSXP>(data);
-        previous = *p_data++ ;
+    SortedKeys& sorted_keys(){
+        static SortedKeys keys ;
+        return keys ;
+    }
 
-        int o_pos ;
-        orders[0] = o_pos = map.find(previous)->second ;
+}
 
-        for( int i=1; i<n; i++, p_data++){
-            SEXP s = *p_data;
-            if( s == previous ) {
-                orders[i] = o_pos ;
-                continue ;
-            }
-            previous = s ;
-            orders[i] = o_pos = map.find(s)->second ;
-        }
+// [[Rcpp::export]]
+IntegerVector rank_strings( CharacterVector s ){
+  return dplyr::CharacterVectorOrderer(s).get() ;
+}
 
-    }
+//' Clear the string cache
+//'
+//' Ordering and grouping by character columns needs the rank of each string
+//' in \code{sort()} order. dplyr remembers the ranks of the strings it has
+//' seen, so that working again with the same columns does not have to sort
+//' their strings again. The cache holds at most
+//' \code{getOption("dplyr.string_cache_size")} strings (one million by
+//' default) before new ones are added, and is emptied when the collation
+//' changes.
+//'
+//' @return The number of strings that were in the cache.
+//' @export
+// [[Rcpp::export]]
+int clear_string_cache(){
+  return dplyr::string_cache().clear() ;
+}
 
-    CharacterVector get_uniques( const CharacterVector& left, const CharacterVector& right){
-        int nleft = left.size(), nright = right.size() ;
-        int n = nleft + nright ;
+//' Clear the group index cache
+//'
+//' \code{group_by()} can remember the group indices it builds for the
+//' columns of a data frame, so that grouping the same columns again, e.g.
+//' after \code{ungroup()}, reuses the index instead of hashing every row.
+//' The cache holds the \code{getOption("dplyr.group_index_cache_size")}
+//' most recently used indices, and is off by default (a size of 0).
+//'
+//' A cached index keeps the index and its grouping columns in memory until
+//' it is evicted or the cache is cleared, even after the data frame they
+//' come from is gone, so each entry can retain as much memory as its
+//' columns.
+//'
+//' @return The number of indices that were in the cache.
+//' @export
+// [[Rcpp::export]]
+int clear_group_index_cache(){
+  return dplyr::group_index_cache().clear() ;
+}
 
-        CharacterVector big = no_init(n) ;
-        CharacterVector::iterator it = big.begin() ;
-        std::copy( left.begin(), left.end(), it ) ;
-        std::copy( right.begin(), right.end(), it + nleft ) ;
-        return Language( "unique", big ).fast_eval() ;
-    }
+// [[Rcpp::export]]
+int threads_impl(){
+  return dplyr::ExecutionContext().threads() ;
+}
 
+// [[Rcpp::export]]
+void profile_start(){
+  dplyr::profiler().start() ;
 }
 
 // [[Rcpp::export]]
-IntegerVector rank_strings( CharacterVector s ){
-  return dplyr::CharacterVectorOrderer(s).get() ;
+void profile_stop(){
+  dplyr::profiler().stop() ;
+}
+
+// [[Rcpp::export]]
+List profile_get(){
+  return dplyr::profiler().get() ;
 }
@@ -3,18 +3,41 @@
 using namespace Rcpp ;
 using namespace dplyr ;
 
-// [[Rcpp::export]]
-List arrange_impl( DataFrame data, LazyDots dots ){
-    if( data.size() == 0 ) return data ;
-    check_valid_colnames(data) ;
-    assert_all_white_list(data) ;
+// groups stay in adjacent rows when the data is first sorted by the
+// grouping variables, in any order and direction
+bool sorted_by_groups( const std::vector<SEXP>& symbols, List vars ){
+    int nvars = vars.size() ;
+    if( nvars > (int)symbols.size() ) return false ;
+    for( int i=0; i<nvars; i++){
+        if( std::find( symbols.begin(), symbols.begin() + nvars, (SEXP)vars[i] ) == symbols.begin() + nvars ){
+            return false ;
+        }
+    }
+    return true ;
+}
 
-    if( dots.size() == 0 || data.nrows() == 0) return data ;
+// the leading variables the data is sorted by in ascending order: the
+// columns of the expressions before the first one that is not a column or
+// is sorted in descending order
+CharacterVector sorted_keys_of( const DataFrame& data, const LogicalVector& ascending, const std::vector<SEXP>& symbols ){
+    CharacterVector names = data.names() ;
+    std::vector<SEXP> keys ;
+    for( size_t i=0; i<symbols.size(); i++){
+        SEXP s = symbols[i] ;
+        if( s == R_NilValue || !ascending[i] ) break ;
+        if( std::find( keys.begin(), keys.end(), s ) != keys.end() ) break ;
+        int pos = as<int>( r_match( CharacterVector::create( PRINTNAME(s) ), names ) ) ;
+        if( pos == NA_INTEGER || TYPEOF(data[pos-1]) == VECSXP ) break ;
+        keys.push_back( s ) ;
+    }
+    CharacterVector out( keys.size() ) ;
+    for( size_t i=0; i<keys.size(); i++) out[i] = PRINTNAME( keys[i] ) ;
+    return out ;
+}
 
+// evaluates the expressions of arrange() into the variables to order by
+void order_variables( const DataFrame& data, const LazyDots& dots, List& variables, LogicalVector& ascending, std::vector<SEXP>& symbols ){
     int nargs = dots.size() ;
-    List variables(nargs) ;
-    LogicalVector ascending(nargs) ;
-
     for(int i=0; i<nargs; i++){
         const Lazy& lazy = dots[i] ;
 
@@ -22,9 +45,15 @@ List arrange_impl( DataFrame data, LazyDots dots ){
         SEXP call = call_ ;
         bool is_desc = TYPEOF(call) == LANGSXP && Rf_install("desc") == CAR(call) ;
 
-        CallProxy call_proxy(is_desc ? CADR(call) : call, data, lazy.env()) ;
+        SEXP what = is_desc ? CADR(call) : call ;
+        if( TYPEOF(what) == SYMSXP ) symbols[i] = what ;
+        CallProxy call_proxy(what, data, lazy.env()) ;
 
+        ProfiledPhase phase( "arrange", "evaluate", data.nrows(), 1 ) ;
+        phase.set_expr( lazy.name(), what ) ;
+        if( TYPEOF(what) == SYMSXP ) phase.set_handler( "column" ) ;
         Shield<SEXP> v(call_proxy.eval()) ;
+        phase.set_result( v ) ;
         if( !white_list(v) ){
             stop( "cannot arrange column of class '%s'", get_single_class(v) ) ;
         }
@@ -44,12 +73,37 @@ List arrange_impl( DataFrame data, LazyDots dots ){
         }
         variables[i] = v ;
         ascending[i] = !is_desc ;
+        phase.done() ;
+    }
+}
+
+// [[Rcpp::export]]
+List arrange_impl( DataFrame data, LazyDots dots ){
+    if( data.size() == 0 ) return data ;
+    check_valid_colnames(data) ;
+    assert_all_white_list(data) ;
+
+    if( dots.size() == 0 || data.nrows() == 0) return data ;
+
+    int nargs = dots.size() ;
+    List variables(nargs) ;
+    LogicalVector ascending(nargs) ;
+    std::vector<SEXP> symbols(nargs, R_NilValue) ;
+    order_variables( data, dots, variables, ascending, symbols ) ;
+
+    IntegerVector index ;
+    {
+        ProfiledPhase phase( "arrange", "order", data.nrows(), 1 ) ;
+        OrderVisitors o(variables, ascending, nargs) ;
+        index = o.apply() ;
+        phase.done() ;
     }
-    OrderVisitors o(variables, ascending, nargs) ;
-    IntegerVector index = o.apply() ;
 
+    ProfiledPhase subset_phase( "arrange", "subset", data.nrows(), 1 ) ;
     DataFrameSubsetVisitors visitors( data, data.names() ) ;
     List res = visitors.subset(index, data.attr("class") ) ;
+    CharacterVector keys = sorted_keys_of( data, ascending, symbols ) ;
+    if( keys.size() ) sorted_keys().set( res, keys ) ;
 
     if( is<GroupedDataFrame>(data) ){
         // so that all attributes are recalculated (indices ... )
@@ -58,8 +112,86 @@ List arrange_impl( DataFrame data, LazyDots dots ){
         // set for free from subset (#1064)
         res.attr("labels") = R_NilValue ;
         res.attr( "vars" )  = data.attr("vars" ) ;
-        return GroupedDataFrame(res).data() ;
+        if( Rf_inherits(data, "adj_grouped_df") && !sorted_by_groups(symbols, data.attr("vars")) ){
+            res.attr( "class" ) = classes_grouped<GroupedDataFrame>() ;
+        }
+        DataFrame grouped = GroupedDataFrame(res).data() ;
+        subset_phase.done() ;
+        return grouped ;
     }
     SET_ATTRIB(res, strip_group_attributes(res));
+    subset_phase.done() ;
+    return res ;
+}
+
+// declares the variables data is sorted by, after checking in one pass that
+// its rows are in the order arrange() gives them
+// [[Rcpp::export]]
+DataFrame sorted_by_impl( DataFrame data, CharacterVector vars ){
+    check_valid_colnames(data) ;
+    DataFrame copy( shallow_copy(data) ) ;
+    if( vars.size() == 0 ){
+        Rf_setAttrib( copy, SortedKeys::symbol(), R_NilValue ) ;
+        return copy ;
+    }
+
+    CharacterVector names = data.names() ;
+    IntegerVector indx = r_match( vars, names ) ;
+    for( int i=0; i<vars.size(); i++){
+        if( indx[i] == NA_INTEGER ){
+            stop( "unknown variable '%s'", CHAR(STRING_ELT(vars, i)) ) ;
+        }
+        SEXP v = data[ indx[i] - 1 ] ;
+        if( !white_list(v) || TYPEOF(v) == VECSXP ){
+            stop( "cannot sort column '%s', of class '%s'", CHAR(STRING_ELT(vars, i)), get_single_class(v) ) ;
+        }
+    }
+    if( !rows_sorted_by( data, vars ) ){
+        stop( "rows are not sorted by the variables" ) ;
+    }
+    sorted_keys().set( copy, vars ) ;
+    return copy ;
+}
+
+// [[Rcpp::export]]
+CharacterVector sorted_vars_impl( DataFrame data ){
+    return sorted_keys().get( data ) ;
+}
+
+// the first n rows of arrange(data, ...), for an ungrouped data frame,
+// without sorting the other rows
+// [[Rcpp::export]]
+List arrange_head_impl( DataFrame data, LazyDots dots, int n ){
+    if( data.size() == 0 ) return data ;
+    check_valid_colnames(data) ;
+    assert_all_white_list(data) ;
+
+    int nargs = dots.size() ;
+    List variables(nargs) ;
+    LogicalVector ascending(nargs) ;
+    std::vector<SEXP> symbols(nargs, R_NilValue) ;
+    if( nargs > 0 && data.nrows() > 0 ){
+        order_variables( data, dots, variables, ascending, symbols ) ;
+    }
+
+    IntegerVector index ;
+    {
+        ProfiledPhase phase( "arrange", "order", data.nrows(), 1 ) ;
+        if( nargs == 0 || data.nrows() == 0 ){
+            int k = std::max( 0, std::min( n, data.nrows() ) ) ;
+            index = IntegerVector( k ) ;
+            for( int i=0; i<k; i++) index[i] = i ;
+        } else {
+            OrderVisitors o(variables, ascending, nargs) ;
+            index = o.head(n) ;
+        }
+        phase.done() ;
+    }
+
+    ProfiledPhase subset_phase( "arrange", "subset", data.nrows(), 1 ) ;
+    DataFrameSubsetVisitors visitors( data, data.names() ) ;
+    List res = visitors.subset(index, data.attr("class") ) ;
+    SET_ATTRIB(res, strip_group_attributes(res));
+    subset_phase.done() ;
     return res ;
 }
@@ -151,6 +151,8 @@ List rbind__impl( Dots dots, SEXP id = R_NilValue ){
         out.attr("class") = df.attr("class") ;
         if( df.inherits("grouped_df") ){
           out.attr("vars") = df.attr("vars") ;
+          // binding does not keep groups in adjacent rows
+          if( df.inherits("adj_grouped_df") ) out.attr("class") = classes_grouped<GroupedDataFrame>() ;
           out = GroupedDataFrame(out).data() ;
         }
       } else {
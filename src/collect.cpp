@@ -0,0 +1,57 @@
+#include <dplyr.h>
+
+using namespace Rcpp ;
+using namespace dplyr ;
+
+// [[Rcpp::export]]
+XPtr<DataFrameCollecter> paged_collecter( CharacterVector vars ){
+    return XPtr<DataFrameCollecter>( new DataFrameCollecter(vars), true ) ;
+}
+
+// [[Rcpp::export]]
+int paged_collecter_push( XPtr<DataFrameCollecter> builder, DataFrame page ){
+    builder->push(page) ;
+    return builder->size() ;
+}
+
+// [[Rcpp::export]]
+SEXP paged_collecter_get( XPtr<DataFrameCollecter> builder ){
+    if( !builder->pages() ) return R_NilValue ;
+    return builder->get() ;
+}
+
+// [[Rcpp::export]]
+XPtr<GroupSplitter> group_splitter( CharacterVector vars ){
+    return XPtr<GroupSplitter>( new GroupSplitter(vars), true ) ;
+}
+
+// [[Rcpp::export]]
+List group_splitter_push( XPtr<GroupSplitter> splitter, DataFrame page ){
+    return splitter->push(page) ;
+}
+
+// [[Rcpp::export]]
+SEXP group_splitter_flush( XPtr<GroupSplitter> splitter ){
+    return splitter->flush() ;
+}
+
+// [[Rcpp::export]]
+SEXP group_splitter_labels( XPtr<GroupSplitter> splitter ){
+    return splitter->get_labels() ;
+}
+
+// [[Rcpp::export]]
+XPtr<ExternalSummariser> external_summariser( CharacterVector vars, List specs, std::string dir, double budget ){
+    return XPtr<ExternalSummariser>( new ExternalSummariser(vars, specs, dir, budget), true ) ;
+}
+
+// [[Rcpp::export]]
+int external_summariser_push( XPtr<ExternalSummariser> summariser, DataFrame chunk ){
+    summariser->push(chunk) ;
+    return summariser->nspills() ;
+}
+
+// [[Rcpp::export]]
+SEXP external_summariser_get( XPtr<ExternalSummariser> summariser ){
+    return summariser->get() ;
+}
@@ -0,0 +1,385 @@
+#include <dplyr.h>
+
+using namespace Rcpp ;
+using namespace dplyr ;
+
+// reductions of the measures of a tbl_cube along the dimensions that are not
+// grouped. The array is scanned once in storage order, each element being
+// added to the state of the output cell it belongs to. Large arrays are split
+// in ranges scanned by different threads, whose states are then merged
+
+// offsets of the output cells: element (i1, ..., ik) of the array goes to
+// cell sum(i_j * strides[j]), where strides[j] is 0 for dimensions that are
+// reduced and the usual column major stride of the output otherwise
+class CubeCells {
+public:
+    CubeCells( IntegerVector dims_, IntegerVector groups ) :
+        dims( dims_.begin(), dims_.end() ), strides( dims_.size(), 0 ), ncells(1), n(1)
+    {
+        int ndims = dims.size() ;
+        for( int k=0; k<ndims; k++) n *= dims[k] ;
+        for( int i=0; i<groups.size(); i++){
+            int g = groups[i] - 1 ;
+            if( g < 0 || g >= ndims ) stop( "invalid dimension %d", groups[i] ) ;
+            strides[g] = ncells ;
+            ncells *= dims[g] ;
+        }
+    }
+
+    inline int size() const { return ncells ; }
+
+    inline int length() const { return n ; }
+
+    // elements begin, ..., end - 1 of the array
+    template <typename State>
+    void visit( State& state, int begin, int end ) const {
+        int ndims = dims.size() ;
+        if( begin >= end ) return ;
+
+        // position of begin, and offset of its cell along the dimensions but
+        // the first one
+        std::vector<int> position( ndims, 0 ) ;
+        int rest = begin, base = 0 ;
+        for( int k=0; k<ndims; k++){
+            position[k] = rest % dims[k] ;
+            rest /= dims[k] ;
+            if( k > 0 ) base += position[k] * strides[k] ;
+        }
+
+        int d0 = dims[0], s0 = strides[0] ;
+        int i = position[0] ;
+        for( int pos=begin; pos<end; ){
+            int c = base + i * s0 ;
+            int last = std::min( d0, i + end - pos ) ;
+            for( ; i<last; i++, pos++, c += s0 ){
+                state.add( c, pos ) ;
+            }
+            if( pos == end ) break ;
+
+            // next position along the other dimensions
+            i = 0 ;
+            for( int k=1; k<ndims; k++){
+                base += strides[k] ;
+                if( ++position[k] < dims[k] ) break ;
+                base -= strides[k] * dims[k] ;
+                position[k] = 0 ;
+            }
+        }
+    }
+
+private:
+    std::vector<int> dims ;
+    std::vector<int> strides ;
+    int ncells ;
+    int n ;
+} ;
+
+template <int RTYPE>
+class CubeSum {
+public:
+    typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+    CubeSum( SEXP x, int ncells, bool na_rm_ ) :
+        ptr( Rcpp::internal::r_vector_start<RTYPE>(x) ), na_rm(na_rm_), sums(ncells, 0.0), na(ncells, false)
+    {}
+
+    inline void add( int cell, int pos ){
+        STORAGE value = ptr[pos] ;
+        if( Rcpp::traits::is_na<RTYPE>(value) ){
+            if( na_rm ) return ;
+            // missing doubles propagate through the sum
+            if( RTYPE == INTSXP ){
+                na[cell] = true ;
+                return ;
+            }
+        }
+        sums[cell] += value ;
+    }
+
+    void merge( const CubeSum& other ){
+        int n = sums.size() ;
+        for( int i=0; i<n; i++){
+            sums[i] += other.sums[i] ;
+            if( other.na[i] ) na[i] = true ;
+        }
+    }
+
+    SEXP result() ;
+
+private:
+    STORAGE* ptr ;
+    bool na_rm ;
+    std::vector<long double> sums ;
+    std::vector<bool> na ;
+} ;
+
+template <>
+SEXP CubeSum<INTSXP>::result(){
+    int n = sums.size() ;
+    IntegerVector out = no_init(n) ;
+    bool overflow = false ;
+    for( int i=0; i<n; i++){
+        if( na[i] ){
+            out[i] = NA_INTEGER ;
+        } else if( sums[i] > INT_MAX || sums[i] < -INT_MAX ){
+            overflow = true ;
+            out[i] = NA_INTEGER ;
+        } else {
+            out[i] = (int)sums[i] ;
+        }
+    }
+    if( overflow ) Rf_warning( "integer overflow - use sum(as.numeric(.))" ) ;
+    return out ;
+}
+
+template <>
+SEXP CubeSum<REALSXP>::result(){
+    int n = sums.size() ;
+    NumericVector out = no_init(n) ;
+    for( int i=0; i<n; i++) out[i] = (double)sums[i] ;
+    return out ;
+}
+
+template <int RTYPE>
+class CubeMean {
+public:
+    typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+    CubeMean( SEXP x, int ncells, bool na_rm_ ) :
+        ptr( Rcpp::internal::r_vector_start<RTYPE>(x) ), na_rm(na_rm_), sums(ncells, 0.0), counts(ncells, 0), na(ncells, false)
+    {}
+
+    inline void add( int cell, int pos ){
+        STORAGE value = ptr[pos] ;
+        if( Rcpp::traits::is_na<RTYPE>(value) ){
+            if( na_rm ) return ;
+            if( RTYPE == INTSXP ){
+                na[cell] = true ;
+                return ;
+            }
+        }
+        sums[cell] += value ;
+        counts[cell]++ ;
+    }
+
+    void merge( const CubeMean& other ){
+        int n = sums.size() ;
+        for( int i=0; i<n; i++){
+            sums[i] += other.sums[i] ;
+            counts[i] += other.counts[i] ;
+            if( other.na[i] ) na[i] = true ;
+        }
+    }
+
+    SEXP result(){
+        int n = sums.size() ;
+        NumericVector out = no_init(n) ;
+        for( int i=0; i<n; i++){
+            if( na[i] ){
+                out[i] = NA_REAL ;
+            } else {
+                out[i] = counts[i] ? (double)( sums[i] / counts[i] ) : R_NaN ;
+            }
+        }
+        return out ;
+    }
+
+private:
+    STORAGE* ptr ;
+    bool na_rm ;
+    std::vector<long double> sums ;
+    std::vector<int> counts ;
+    std::vector<bool> na ;
+} ;
+
+// min or max. Integer results stay integer, unless a cell has no value
+// and gets an infinite bound, as in R
+template <int RTYPE, bool MINIMUM>
+class CubeExtremum {
+public:
+    typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+    CubeExtremum( SEXP x, int ncells, bool na_rm_ ) :
+        ptr( Rcpp::internal::r_vector_start<RTYPE>(x) ), na_rm(na_rm_),
+        best( ncells, MINIMUM ? R_PosInf : R_NegInf ), seen(ncells, false), missing(ncells, NONE)
+    {}
+
+    inline void add( int cell, int pos ){
+        STORAGE value = ptr[pos] ;
+        if( Rcpp::traits::is_na<RTYPE>(value) ){
+            if( na_rm ) return ;
+            // NA wins over NaN
+            int what = ( RTYPE == INTSXP || R_IsNA((double)value) ) ? IS_NA : IS_NAN ;
+            if( what > missing[cell] ) missing[cell] = what ;
+            return ;
+        }
+        double x = value ;
+        if( MINIMUM ? x < best[cell] : x > best[cell] ) best[cell] = x ;
+        seen[cell] = true ;
+    }
+
+    void merge( const CubeExtremum& other ){
+        int n = best.size() ;
+        for( int i=0; i<n; i++){
+            double x = other.best[i] ;
+            if( MINIMUM ? x < best[i] : x > best[i] ) best[i] = x ;
+            if( other.seen[i] ) seen[i] = true ;
+            if( other.missing[i] > missing[i] ) missing[i] = other.missing[i] ;
+        }
+    }
+
+    SEXP result(){
+        int n = best.size() ;
+        bool all_seen = true ;
+        for( int i=0; i<n; i++){
+            if( !seen[i] && missing[i] == NONE ) all_seen = false ;
+        }
+
+        if( RTYPE == INTSXP && all_seen ){
+            IntegerVector out = no_init(n) ;
+            for( int i=0; i<n; i++){
+                out[i] = missing[i] != NONE ? NA_INTEGER : (int)best[i] ;
+            }
+            return out ;
+        }
+
+        NumericVector out = no_init(n) ;
+        for( int i=0; i<n; i++){
+            switch( missing[i] ){
+            case IS_NA:  out[i] = NA_REAL ; break ;
+            case IS_NAN: out[i] = R_NaN ; break ;
+            default:     out[i] = best[i] ; break ;
+            }
+        }
+        return out ;
+    }
+
+private:
+    enum { NONE = 0, IS_NAN = 1, IS_NA = 2 } ;
+
+    STORAGE* ptr ;
+    bool na_rm ;
+    std::vector<double> best ;
+    std::vector<bool> seen ;
+    std::vector<int> missing ;
+} ;
+
+// variance (Welford), or standard deviation
+template <int RTYPE, bool SD>
+class CubeVar {
+public:
+    typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+
+    CubeVar( SEXP x, int ncells, bool na_rm_ ) :
+        ptr( Rcpp::internal::r_vector_start<RTYPE>(x) ), na_rm(na_rm_),
+        counts(ncells, 0), means(ncells, 0.0), m2(ncells, 0.0), na(ncells, false)
+    {}
+
+    inline void add( int cell, int pos ){
+        STORAGE value = ptr[pos] ;
+        if( Rcpp::traits::is_na<RTYPE>(value) ){
+            if( !na_rm ) na[cell] = true ;
+            return ;
+        }
+        double x = value ;
+        int k = ++counts[cell] ;
+        double delta = x - means[cell] ;
+        means[cell] += delta / k ;
+        m2[cell] += delta * ( x - means[cell] ) ;
+    }
+
+    // combines the moments of both parts (Chan et al.)
+    void merge( const CubeVar& other ){
+        int n = counts.size() ;
+        for( int i=0; i<n; i++){
+            if( other.na[i] ) na[i] = true ;
+            int nb = other.counts[i] ;
+            if( nb == 0 ) continue ;
+            int na_ = counts[i], k = na_ + nb ;
+            double delta = other.means[i] - means[i] ;
+            means[i] += delta * nb / k ;
+            m2[i] += other.m2[i] + delta * delta * ( (double)na_ * nb / k ) ;
+            counts[i] = k ;
+        }
+    }
+
+    SEXP result(){
+        int n = counts.size() ;
+        NumericVector out = no_init(n) ;
+        for( int i=0; i<n; i++){
+            if( na[i] || counts[i] < 2 ){
+                out[i] = NA_REAL ;
+            } else {
+                double var = m2[i] / ( counts[i] - 1 ) ;
+                out[i] = SD ? ::sqrt(var) : var ;
+            }
+        }
+        return out ;
+    }
+
+private:
+    STORAGE* ptr ;
+    bool na_rm ;
+    std::vector<int> counts ;
+    std::vector<double> means ;
+    std::vector<double> m2 ;
+    std::vector<bool> na ;
+} ;
+
+// each range of the array is reduced into its own state by a worker
+template <typename State>
+class CubeReducer {
+public:
+    CubeReducer( const CubeCells& cells_, std::vector<State>& states_ ) :
+        cells(cells_), states(states_)
+    {}
+
+    inline void operator()( int range, int begin, int end ){
+        cells.visit( states[range], begin, end ) ;
+    }
+
+private:
+    const CubeCells& cells ;
+    std::vector<State>& states ;
+} ;
+
+template <typename State>
+SEXP cube_reduce( SEXP x, const CubeCells& cells, bool na_rm ){
+    ExecutionContext context ;
+    int nranges = context.ranges( cells.length() ) ;
+
+    // the states are made here, the workers only add values to them
+    std::vector<State> states( nranges, State( x, cells.size(), na_rm ) ) ;
+    CubeReducer<State> reducer( cells, states ) ;
+    context.run( cells.length(), reducer ) ;
+
+    for( int i=1; i<nranges; i++) states[0].merge( states[i] ) ;
+    return states[0].result() ;
+}
+
+template <int RTYPE>
+SEXP cube_summarise_typed( SEXP x, const CubeCells& cells, const std::string& fun, bool na_rm ){
+    if( fun == "sum" )  return cube_reduce< CubeSum<RTYPE> >( x, cells, na_rm ) ;
+    if( fun == "mean" ) return cube_reduce< CubeMean<RTYPE> >( x, cells, na_rm ) ;
+    if( fun == "min" )  return cube_reduce< CubeExtremum<RTYPE,true> >( x, cells, na_rm ) ;
+    if( fun == "max" )  return cube_reduce< CubeExtremum<RTYPE,false> >( x, cells, na_rm ) ;
+    if( fun == "var" )  return cube_reduce< CubeVar<RTYPE,false> >( x, cells, na_rm ) ;
+    if( fun == "sd" )   return cube_reduce< CubeVar<RTYPE,true> >( x, cells, na_rm ) ;
+    stop( "unknown cube reduction '%s'", fun ) ;
+    return R_NilValue ;
+}
+
+// [[Rcpp::export]]
+SEXP cube_summarise_impl( SEXP x, IntegerVector groups, std::string fun, bool na_rm ){
+    SEXP dim = Rf_getAttrib( x, R_DimSymbol ) ;
+    IntegerVector dims = Rf_isNull(dim) ? IntegerVector::create( Rf_length(x) ) : IntegerVector(dim) ;
+    CubeCells cells( dims, groups ) ;
+
+    switch( TYPEOF(x) ){
+    case INTSXP:  return cube_summarise_typed<INTSXP>( x, cells, fun, na_rm ) ;
+    case REALSXP: return cube_summarise_typed<REALSXP>( x, cells, fun, na_rm ) ;
+    default: break ;
+    }
+    stop( "cannot summarise measure of type %s", Rf_type2char(TYPEOF(x)) ) ;
+    return R_NilValue ;
+}
@@ -4,6 +4,37 @@ using namespace Rcpp ;
 using namespace dplyr ;
 
 SEXP select_not_grouped( const DataFrame& df, const CharacterVector& keep, CharacterVector new_names );
+
+// the first row of each value of a single integer or factor variable whose
+// values are dense, flagging the values seen in an array indexed by value
+bool distinct_direct( const DataFrame& df, const CharacterVector& vars, std::vector<int>& indices ){
+    if( vars.size() != 1 ) return false ;
+    CharacterVector names = df.names() ;
+    IntegerVector indx = r_match( vars, names ) ;
+    if( indx[0] == NA_INTEGER ) return false ;
+    SEXP x = df[ indx[0] - 1 ] ;
+    if( !direct_key( x, true ) ) return false ;
+
+    const int* p = INTEGER(x) ;
+    int n = Rf_length(x) ;
+    int min, max ;
+    if( !dense_range( p, n, min, max ) ) return false ;
+
+    std::vector<bool> seen( max - min + 1, false ) ;
+    bool na = false ;
+    for( int i=0; i<n; i++){
+        if( p[i] == NA_INTEGER ){
+            if( na ) continue ;
+            na = true ;
+        } else {
+            if( seen[ p[i] - min ] ) continue ;
+            seen[ p[i] - min ] = true ;
+        }
+        indices.push_back(i) ;
+    }
+    return true ;
+}
+
 // [[Rcpp::export]]
 SEXP distinct_impl( DataFrame df, CharacterVector vars, CharacterVector keep){
     if( df.size() == 0 )
@@ -17,15 +48,16 @@ SEXP distinct_impl( DataFrame df, CharacterVector vars, CharacterVector keep){
     if( !vars.size() ){
         vars = df.names() ;
     }
-    DataFrameVisitors visitors(df, vars) ;
-
     std::vector<int> indices ;
-    VisitorSetIndexSet<DataFrameVisitors> set(visitors) ;
+    if( !distinct_direct( df, vars, indices ) ){
+        DataFrameVisitors visitors(df, vars) ;
+        VisitorSetIndexSet<DataFrameVisitors> set(visitors) ;
 
-    int n = df.nrows() ;
-    for( int i=0; i<n; i++){
-        if( set.insert(i).second ){
-            indices.push_back(i) ;
+        int n = df.nrows() ;
+        for( int i=0; i<n; i++){
+            if( set.insert(i).second ){
+                indices.push_back(i) ;
+            }
         }
     }
 
@@ -28,15 +28,22 @@ bool hybridable( RObject arg ){
 }
 
 template <template <int,bool> class Fun, bool narm>
-Result* simple_prototype_impl( SEXP arg, bool is_summary ){
+Result* simple_prototype_impl( SEXP arg, bool is_summary, bool is_constant ){
     // if not hybridable, just let R handle it
     if( !hybridable(arg) ) return 0 ;
 
+    // a constant column, e.g. a tag added by mutate(), is reduced without
+    // looking at the rows of the groups
+    if( is_constant ){
+        Result* res = constant_reduction<Fun, narm>::get( arg ) ;
+        if( res ) return res ;
+    }
+
     switch( TYPEOF(arg) ){
         case INTSXP:
-            return new Fun<INTSXP,narm>( arg, is_summary ) ;
+            return reduction<Fun,INTSXP,narm>( arg, is_summary ) ;
         case REALSXP:
-            return new Fun<REALSXP,narm>( arg, is_summary ) ;
+            return reduction<Fun,REALSXP,narm>( arg, is_summary ) ;
         default: break ;
     }
     return 0 ;
@@ -47,11 +54,13 @@ Result* simple_prototype(  SEXP call, const LazySubsets& subsets, int nargs ){
     if( nargs == 0 ) return 0 ;
     SEXP arg = CADR(call) ;
     bool is_summary = false ;
+    bool is_constant = false ;
     if( TYPEOF(arg) == SYMSXP ){
       if( subsets.count(arg) ) {
           // we have a symbol from the data - great
           is_summary = subsets.is_summary(arg) ;
           arg = subsets.get_variable(arg) ;
+          is_constant = !is_summary && hybridable(arg) && subsets.is_constant(arg) ;
       } else {
           // we have a symbol but we don't know about it, so we give up and let R evaluation handle it
           return 0 ;
@@ -64,7 +73,7 @@ Result* simple_prototype(  SEXP call, const LazySubsets& subsets, int nargs ){
     }
 
     if( nargs == 1 ){
-        return simple_prototype_impl<Fun, false>( arg, is_summary ) ;
+        return simple_prototype_impl<Fun, false>( arg, is_summary, is_constant ) ;
     } else if(nargs == 2 ){
         SEXP arg2 = CDDR(call) ;
         // we know how to handle fun( ., na.rm = TRUE/FALSE )
@@ -72,9 +81,9 @@ Result* simple_prototype(  SEXP call, const LazySubsets& subsets, int nargs ){
             SEXP narm = CAR(arg2) ;
             if( TYPEOF(narm) == LGLSXP && LENGTH(narm) == 1 ){
                 if( LOGICAL(narm)[0] == TRUE ){
-                    return simple_prototype_impl<Fun, true>( arg, is_summary ) ;
+                    return simple_prototype_impl<Fun, true>( arg, is_summary, is_constant ) ;
                 } else {
-                    return simple_prototype_impl<Fun, false>( arg, is_summary ) ;
+                    return simple_prototype_impl<Fun, false>( arg, is_summary, is_constant ) ;
                 }
             }
         }
@@ -88,9 +97,9 @@ Result* minmax_prototype_impl(SEXP arg, bool is_summary){
 
     switch( TYPEOF(arg) ){
         case INTSXP:
-            return new Tmpl<INTSXP,narm>( arg, is_summary ) ;
+            return reduction<Tmpl,INTSXP,narm>( arg, is_summary ) ;
         case REALSXP:
-            return new Tmpl<REALSXP,narm>( arg, is_summary ) ;
+            return reduction<Tmpl,REALSXP,narm>( arg, is_summary ) ;
         default: break ;
     }
     return 0 ;
@@ -164,6 +173,16 @@ Result* count_distinct_prototype(SEXP call, const LazySubsets& subsets, int narg
       stop("need at least one column for n_distinct()");
     }
 
+    if( visitors.size() == 1 && TYPEOF(CADR(call)) == SYMSXP ){
+      SEXP x = subsets.get_variable( CADR(call) ) ;
+      if( !subsets.is_summary( CADR(call) ) && subsets.is_constant(x) ){
+        return new ConstantCountDistinct( visitors.is_na(0), na_rm ) ;
+      }
+      if( direct_key( x, true ) ){
+        return new Count_Distinct_Direct( x, na_rm ) ;
+      }
+    }
+
     if( na_rm ){
       return new Count_Distinct_Narm<MultipleVectorVisitors>(visitors) ;
     } else {
@@ -436,6 +455,12 @@ HybridHandlerMap& get_handlers(){
         handlers[ Rf_install( "last" )           ] = last_prototype ;
         handlers[ Rf_install( "nth" )            ] = nth_prototype ;
 
+        handlers[ Rf_install( "roll_sum" )       ] = roll_sum_prototype ;
+        handlers[ Rf_install( "roll_mean" )      ] = roll_mean_prototype ;
+        handlers[ Rf_install( "roll_min" )       ] = roll_min_prototype ;
+        handlers[ Rf_install( "roll_max" )       ] = roll_max_prototype ;
+        handlers[ Rf_install( "roll_sd" )        ] = roll_sd_prototype ;
+
         // handlers[ Rf_install( "%in%" ) ] = in_prototype ;
 
     }
@@ -507,6 +532,105 @@ bool can_simplify( SEXP call ){
     return false ;
 }
 
+// base functions whose result at a position only depends on their
+// arguments at that position
+static dplyr_hash_set<SEXP>& elementwise_functions(){
+    static dplyr_hash_set<SEXP> funs ;
+    if( !funs.size() ){
+        const char* names[] = {
+            "(", "+", "-", "*", "/", "^", "%%", "%/%",
+            "==", "!=", "<", ">", "<=", ">=", "!", "&", "|", "xor",
+            "is.na", "is.finite", "is.infinite", "is.nan",
+            "abs", "sign", "sqrt", "exp", "log", "log2", "log10", "log1p", "expm1",
+            "floor", "ceiling", "round", "signif", "trunc",
+            "as.numeric", "as.double", "as.integer", "as.character", "as.logical",
+            "nchar", "tolower", "toupper", "substr", "substring", "startsWith", "endsWith",
+            "pmin", "pmax"
+        } ;
+        int n = sizeof(names) / sizeof(const char*) ;
+        for( int i=0; i<n; i++) funs.insert( Rf_install(names[i]) ) ;
+    }
+    return funs ;
+}
+
+// the value of a symbol of the environment, if it is already known
+static SEXP find_value( SEXP symbol, SEXP env ){
+    SEXP value = Rf_findVar( symbol, env ) ;
+    if( TYPEOF(value) == PROMSXP ) value = PRVALUE(value) ;
+    return value ;
+}
+
+// is fun the function of base, not masked by a function of the same name
+static bool is_base_function( SEXP fun, SEXP env ){
+    if( Rf_findVarInFrame( R_BaseEnv, fun ) == R_UnboundValue ) return false ;
+    return Rf_findFun( fun, env ) == Rf_findFun( fun, R_BaseEnv ) ;
+}
+
+// the rhs of %in%: constants, or c() of constants
+static bool is_invariant_set( SEXP x, const LazySubsets& subsets, SEXP env ){
+    switch( TYPEOF(x) ){
+    case SYMSXP:
+        {
+            if( subsets.count(x) ) return false ;
+            SEXP value = find_value( x, env ) ;
+            return value != R_UnboundValue && Rf_isVectorAtomic(value) ;
+        }
+    case LANGSXP:
+        {
+            if( CAR(x) != Rf_install("c") || !is_base_function( CAR(x), env ) ) return false ;
+            for( SEXP p = CDR(x); !Rf_isNull(p); p = CDR(p) ){
+                if( !is_invariant_set( CAR(p), subsets, env ) ) return false ;
+            }
+            return true ;
+        }
+    case LGLSXP:
+    case INTSXP:
+    case REALSXP:
+    case STRSXP:
+        return true ;
+    default: break ;
+    }
+    return false ;
+}
+
+bool is_elementwise( SEXP call, const LazySubsets& subsets, SEXP env ){
+    switch( TYPEOF(call) ){
+    case SYMSXP:
+        {
+            if( subsets.count(call) ){
+                SEXP column = subsets.get_variable(call) ;
+                return Rf_isVectorAtomic(column) && !Rf_isMatrix(column) ;
+            }
+            SEXP value = find_value( call, env ) ;
+            return value != R_UnboundValue && Rf_isVectorAtomic(value) && Rf_length(value) == 1 ;
+        }
+    case LANGSXP:
+        {
+            SEXP fun = CAR(call) ;
+            if( TYPEOF(fun) != SYMSXP ) return false ;
+            if( fun == Rf_install("%in%") ){
+                if( Rf_length(call) != 3 ) return false ;
+                if( !is_base_function( fun, env ) ) return false ;
+                return is_elementwise( CADR(call), subsets, env ) && is_invariant_set( CADDR(call), subsets, env ) ;
+            }
+            if( !elementwise_functions().count(fun) || get_handlers().count(fun) ) return false ;
+            if( !is_base_function( fun, env ) ) return false ;
+
+            for( SEXP p = CDR(call); !Rf_isNull(p); p = CDR(p) ){
+                if( !is_elementwise( CAR(p), subsets, env ) ) return false ;
+            }
+            return true ;
+        }
+    case LGLSXP:
+    case INTSXP:
+    case REALSXP:
+    case STRSXP:
+        return Rf_length(call) == 1 ;
+    default: break ;
+    }
+    return false ;
+}
+
 template <typename Index>
 DataFrame subset( DataFrame df, const Index& indices, CharacterVector columns, CharacterVector classes){
     return DataFrameSubsetVisitors(df, columns).subset(indices, classes) ;
@@ -654,9 +778,236 @@ void assert_all_white_list(const DataFrame& data){
     }
 }
 
+// the rows of an inner join, or a left join, of x and y by the keys kx and
+// ky, both sorted: the rows of y that match a row of x are the next run of
+// equal keys of y, so both keys are walked once. The rows come in the order
+// of the hash join: the rows of x in order, each with its matches in y in
+// order
+template <int RTYPE>
+void merge_join_rows( SEXP kx, SEXP ky, bool left, std::vector<int>& indices_x, std::vector<int>& indices_y ){
+    typedef typename Rcpp::traits::storage_type<RTYPE>::type STORAGE ;
+    comparisons<RTYPE> compare ;
+    STORAGE* px = Rcpp::internal::r_vector_start<RTYPE>(kx) ;
+    STORAGE* py = Rcpp::internal::r_vector_start<RTYPE>(ky) ;
+    int n_x = Rf_length(kx), n_y = Rf_length(ky) ;
+
+    int j = 0 ;
+    int i = 0 ;
+    while( i<n_x ){
+        STORAGE key = px[i] ;
+        for( ; j<n_y && compare.is_less( py[j], key ) ; j++) ;
+        int end = j ;
+        for( ; end<n_y && compare.equal_or_both_na( py[end], key ) ; end++) ;
+
+        for( ; i<n_x && compare.equal_or_both_na( px[i], key ) ; i++){
+            if( end > j ){
+                for( int k=j; k<end; k++){
+                    indices_x.push_back(i) ;
+                    indices_y.push_back(k) ;
+                }
+            } else if( left ){
+                indices_x.push_back(i) ;
+                indices_y.push_back(-1) ;
+            }
+        }
+        j = end ;
+    }
+}
+
+// merge join when x and y are sorted by their only key, two bare integer or
+// double vectors, or two dates. Returns false otherwise
+bool merge_join( const DataFrame& x, const DataFrame& y, const CharacterVector& by_x, const CharacterVector& by_y,
+                 bool left, std::vector<int>& indices_x, std::vector<int>& indices_y ){
+    if( by_x.size() != 1 || by_y.size() != 1 ) return false ;
+
+    SEXP kx = x[ std::string( CHAR(STRING_ELT(by_x, 0)) ) ] ;
+    SEXP ky = y[ std::string( CHAR(STRING_ELT(by_y, 0)) ) ] ;
+    if( TYPEOF(kx) != TYPEOF(ky) ) return false ;
+    bool bare = Rf_isNull( Rf_getAttrib(kx, R_ClassSymbol) ) && Rf_isNull( Rf_getAttrib(ky, R_ClassSymbol) ) ;
+    bool dates = TYPEOF(kx) == REALSXP && Rf_inherits(kx, "Date") && Rf_inherits(ky, "Date") ;
+    if( !dates && !( bare && ( TYPEOF(kx) == INTSXP || TYPEOF(kx) == REALSXP ) ) ) return false ;
+
+    if( !sorted_keys().sorted_by( x, by_x ) || !sorted_keys().sorted_by( y, by_y ) ) return false ;
+
+    if( TYPEOF(kx) == INTSXP ){
+        merge_join_rows<INTSXP>( kx, ky, left, indices_x, indices_y ) ;
+    } else {
+        merge_join_rows<REALSXP>( kx, ky, left, indices_x, indices_y ) ;
+    }
+    return true ;
+}
+
+// semi join of x and y when one of them has a hash index on the keys. The
+// rows of x come in the order of the hash join: grouped by key, the keys in
+// the order of their first row in y
+bool indexed_semi_join( const DataFrame& x, const DataFrame& y, const CharacterVector& by_x, const CharacterVector& by_y, std::vector<int>& indices ){
+    HashIndex* index = hash_index( y ) ;
+    if( index && index->probe( x, by_x, by_y ) ){
+        std::vector< std::pair<int,int> > rows ;
+        int n_x = x.nrows() ;
+        for( int i=0; i<n_x; i++){
+            const std::vector<int>* match = index->find(i) ;
+            if( match ) rows.push_back( std::make_pair( match->front(), i ) ) ;
+        }
+        std::sort( rows.begin(), rows.end() ) ;
+        for( size_t k=0; k<rows.size(); k++) indices.push_back( rows[k].second ) ;
+        return true ;
+    }
+
+    index = hash_index( x ) ;
+    if( index && index->probe( y, by_y, by_x ) ){
+        std::vector<bool> found( x.nrows(), false ) ;
+        int n_y = y.nrows() ;
+        for( int i=0; i<n_y; i++){
+            const std::vector<int>* match = index->find(i) ;
+            if( !match || found[ match->front() ] ) continue ;
+            found[ match->front() ] = true ;
+            push_back( indices, *match ) ;
+        }
+        return true ;
+    }
+    return false ;
+}
+
+// rows of an inner join, or a left join, when y has a hash index on the keys
+bool indexed_join( const DataFrame& x, const DataFrame& y, const CharacterVector& by_x, const CharacterVector& by_y,
+                   bool left, std::vector<int>& indices_x, std::vector<int>& indices_y ){
+    HashIndex* index = hash_index( y ) ;
+    if( !index || !index->probe( x, by_x, by_y ) ) return false ;
+
+    int n_x = x.nrows() ;
+    for( int i=0; i<n_x; i++){
+        const std::vector<int>* match = index->find(i) ;
+        if( match ){
+            push_back( indices_y, *match ) ;
+            push_back( indices_x, i, match->size() ) ;
+        } else if( left ){
+            indices_y.push_back(-1) ;
+            indices_x.push_back(i) ;
+        }
+    }
+    return true ;
+}
+
+// the keys of a join by a single pair of bare integer columns, whose rows
+// can be looked up in a DirectIndex
+bool direct_join_keys( const DataFrame& x, const DataFrame& y, const CharacterVector& by_x, const CharacterVector& by_y,
+                       SEXP& kx, SEXP& ky ){
+    if( by_x.size() != 1 || by_y.size() != 1 ) return false ;
+    kx = x[ std::string( CHAR(STRING_ELT(by_x, 0)) ) ] ;
+    ky = y[ std::string( CHAR(STRING_ELT(by_y, 0)) ) ] ;
+    return direct_key( kx, false ) && direct_key( ky, false ) ;
+}
+
+// rows of the join of the keys probe with the rows of index, in the order of
+// the hash joins: the rows of the probe in order, each with its matches in
+// order. With left, rows without matches come with -1. The slots that were
+// found are flagged in matched, when given
+void direct_probe( SEXP probe, const DirectIndex& index, bool left,
+                   std::vector<int>& indices_probe, std::vector<int>& indices_index, std::vector<bool>* matched = 0 ){
+    const int* p = INTEGER(probe) ;
+    int n = Rf_length(probe) ;
+    for( int i=0; i<n; i++){
+        int s = index.slot( p[i] ) ;
+        int size = s < 0 ? 0 : index.size(s) ;
+        if( size ){
+            indices_index.insert( indices_index.end(), index.begin(s), index.end(s) ) ;
+            push_back( indices_probe, i, size ) ;
+            if( matched ) (*matched)[s] = true ;
+        } else if( left ){
+            indices_index.push_back(-1) ;
+            indices_probe.push_back(i) ;
+        }
+    }
+}
+
+// rows of an inner join, or a left join, by a single pair of bare integer
+// keys, when the keys of y are dense
+bool direct_join( const DataFrame& x, const DataFrame& y, const CharacterVector& by_x, const CharacterVector& by_y,
+                  bool left, std::vector<int>& indices_x, std::vector<int>& indices_y ){
+    SEXP kx, ky ;
+    if( !direct_join_keys( x, y, by_x, by_y, kx, ky ) ) return false ;
+    boost::scoped_ptr<DirectIndex> index( DirectIndex::make(ky) ) ;
+    if( !index ) return false ;
+    direct_probe( kx, *index, left, indices_x, indices_y ) ;
+    return true ;
+}
+
+// the index of the keys of x when x and y are joined by a single pair of
+// bare integer keys and the keys of x are dense, or 0. The slots found by y
+// are flagged in found, and listed in slots in the order they are found.
+// The index is owned by the caller
+DirectIndex* direct_semi_join( const DataFrame& x, const DataFrame& y, const CharacterVector& by_x, const CharacterVector& by_y,
+                               std::vector<bool>& found, std::vector<int>& slots ){
+    SEXP kx, ky ;
+    if( !direct_join_keys( x, y, by_x, by_y, kx, ky ) ) return 0 ;
+    DirectIndex* index = DirectIndex::make(kx) ;
+    if( !index ) return 0 ;
+
+    found.assign( index->slots(), false ) ;
+    const int* py = INTEGER(ky) ;
+    int n_y = Rf_length(ky) ;
+    for( int i=0; i<n_y; i++){
+        int s = index->slot( py[i] ) ;
+        if( s < 0 || found[s] || !index->size(s) ) continue ;
+        found[s] = true ;
+        slots.push_back(s) ;
+    }
+    return index ;
+}
+
+// [[Rcpp::export]]
+DataFrame index_by_impl( DataFrame data, CharacterVector vars ){
+    check_valid_colnames(data) ;
+    DataFrame copy( shallow_copy(data) ) ;
+    if( vars.size() == 0 ){
+        copy.attr( "hash_index" ) = R_NilValue ;
+        return copy ;
+    }
+
+    CharacterVector names = data.names() ;
+    IntegerVector indx = r_match( vars, names ) ;
+    for( int i=0; i<vars.size(); i++){
+        if( indx[i] == NA_INTEGER ){
+            stop( "unknown variable '%s'", CHAR(STRING_ELT(vars, i)) ) ;
+        }
+        SEXP v = data[ indx[i] - 1 ] ;
+        if( !HashIndexVisitors::compatible( v, v ) ){
+            stop( "cannot index column '%s', of class '%s'", CHAR(STRING_ELT(vars, i)), get_single_class(v) ) ;
+        }
+    }
+
+    HashIndex* index = new HashIndex( copy, vars ) ;
+    Shield<SEXP> columns( index->protect() ) ;
+    copy.attr( "hash_index" ) = XPtr<HashIndex>( index, true, R_NilValue, columns ) ;
+    return copy ;
+}
+
+// [[Rcpp::export]]
+CharacterVector indexed_vars_impl( DataFrame data ){
+    HashIndex* index = hash_index( data ) ;
+    return index ? index->keys() : CharacterVector(0) ;
+}
+
 // [[Rcpp::export]]
 DataFrame semi_join_impl( DataFrame x, DataFrame y, CharacterVector by_x, CharacterVector by_y ){
     if( by_x.size() == 0) stop("no variable to join by") ;
+    std::vector<int> indexed ;
+    if( indexed_semi_join( x, y, by_x, by_y, indexed ) ){
+        return subset(x, indexed, x.names(), x.attr("class") ) ;
+    }
+
+    std::vector<bool> found ;
+    std::vector<int> slots ;
+    boost::scoped_ptr<DirectIndex> index( direct_semi_join( x, y, by_x, by_y, found, slots ) ) ;
+    if( index ){
+        // the rows of x by slot, the slots in the order they are found in y
+        for( size_t k=0; k<slots.size(); k++){
+            indexed.insert( indexed.end(), index->begin(slots[k]), index->end(slots[k]) ) ;
+        }
+        return subset(x, indexed, x.names(), x.attr("class") ) ;
+    }
+
     typedef VisitorSetIndexMap<DataFrameJoinVisitors, std::vector<int> > Map ;
     DataFrameJoinVisitors visitors(x, y, by_x, by_y, false) ;
     Map map(visitors);
@@ -687,6 +1038,21 @@ DataFrame semi_join_impl( DataFrame x, DataFrame y, CharacterVector by_x, Charac
 // [[Rcpp::export]]
 DataFrame anti_join_impl( DataFrame x, DataFrame y, CharacterVector by_x, CharacterVector by_y){
     if( by_x.size() == 0) stop("no variable to join by") ;
+    std::vector<bool> found ;
+    std::vector<int> slots ;
+    boost::scoped_ptr<DirectIndex> index( direct_semi_join( x, y, by_x, by_y, found, slots ) ) ;
+    if( index ){
+        // the rows of x whose slot is not found, in order
+        SEXP kx = x[ std::string( CHAR(STRING_ELT(by_x, 0)) ) ] ;
+        const int* px = INTEGER(kx) ;
+        std::vector<int> indices ;
+        int n_x = x.nrows() ;
+        for( int i=0; i<n_x; i++){
+            if( !found[ index->slot( px[i] ) ] ) indices.push_back(i) ;
+        }
+        return subset(x, indices, x.names(), x.attr( "class" ) ) ;
+    }
+
     typedef VisitorSetIndexMap<DataFrameJoinVisitors, std::vector<int> > Map ;
     DataFrameJoinVisitors visitors(x, y, by_x, by_y, false) ;
     Map map(visitors);
@@ -715,15 +1081,20 @@ DataFrame inner_join_impl(DataFrame x, DataFrame y,
                           CharacterVector by_x, CharacterVector by_y,
                           std::string& suffix_x, std::string& suffix_y){
     if( by_x.size() == 0) stop("no variable to join by") ;
+    std::vector<int> indices_x ;
+    std::vector<int> indices_y ;
+    if( indexed_join( x, y, by_x, by_y, false, indices_x, indices_y ) ||
+        merge_join( x, y, by_x, by_y, false, indices_x, indices_y ) ||
+        direct_join( x, y, by_x, by_y, false, indices_x, indices_y ) ){
+        return subset_join( x, y, indices_x, indices_y, by_x, by_y, suffix_x, suffix_y, x.attr( "class") ) ;
+    }
+
     typedef VisitorSetIndexMap<DataFrameJoinVisitors, std::vector<int> > Map ;
     DataFrameJoinVisitors visitors(x, y, by_x, by_y, true) ;
     Map map(visitors);
 
     int n_x = x.nrows(), n_y = y.nrows() ;
 
-    std::vector<int> indices_x ;
-    std::vector<int> indices_y ;
-
     train_push_back_right( map, n_y ) ;
 
     for( int i=0; i<n_x; i++){
@@ -748,6 +1119,14 @@ DataFrame left_join_impl(DataFrame x, DataFrame y,
                          CharacterVector by_x, CharacterVector by_y,
                          std::string& suffix_x, std::string& suffix_y){
     if( by_x.size() == 0) stop("no variable to join by") ;
+    std::vector<int> indices_x ;
+    std::vector<int> indices_y ;
+    if( indexed_join( x, y, by_x, by_y, true, indices_x, indices_y ) ||
+        merge_join( x, y, by_x, by_y, true, indices_x, indices_y ) ||
+        direct_join( x, y, by_x, by_y, true, indices_x, indices_y ) ){
+        return subset_join( x, y, indices_x, indices_y, by_x, by_y, suffix_x, suffix_y, x.attr( "class" ) ) ;
+    }
+
     typedef VisitorSetIndexMap<DataFrameJoinVisitors, std::vector<int> > Map ;
     DataFrameJoinVisitors visitors(y, x, by_y, by_x, true) ;
 
@@ -756,9 +1135,6 @@ DataFrame left_join_impl(DataFrame x, DataFrame y,
     // train the map in terms of y
     train_push_back( map, y.nrows() ) ;
 
-    std::vector<int> indices_x ;
-    std::vector<int> indices_y ;
-
     int n_x = x.nrows() ;
     for( int i=0; i<n_x; i++){
         // find a row in y that matches row i in x
@@ -786,6 +1162,30 @@ DataFrame right_join_impl(DataFrame x, DataFrame y,
                           CharacterVector by_x, CharacterVector by_y,
                           std::string& suffix_x, std::string& suffix_y){
     if( by_x.size() == 0) stop("no variable to join by") ;
+    std::vector<int> indices_x ;
+    std::vector<int> indices_y ;
+
+    SEXP kx, ky ;
+    if( direct_join_keys( x, y, by_x, by_y, kx, ky ) ){
+        boost::scoped_ptr<DirectIndex> index( DirectIndex::make(kx) ) ;
+        if( index ){
+            const int* py = INTEGER(ky) ;
+            int n_y = y.nrows() ;
+            for( int i=0; i<n_y; i++){
+                int s = index->slot( py[i] ) ;
+                int size = s < 0 ? 0 : index->size(s) ;
+                if( size ){
+                    indices_x.insert( indices_x.end(), index->begin(s), index->end(s) ) ;
+                    push_back( indices_y, i, size ) ;
+                } else {
+                    indices_x.push_back(-i-1) ; // point to the i-th row in the right table
+                    indices_y.push_back(i) ;
+                }
+            }
+            return subset_join( x, y, indices_x, indices_y, by_x, by_y, suffix_x, suffix_y, x.attr( "class" ) ) ;
+        }
+    }
+
     typedef VisitorSetIndexMap<DataFrameJoinVisitors, std::vector<int> > Map ;
     DataFrameJoinVisitors visitors(x, y, by_x, by_y, true) ;
     Map map(visitors);
@@ -793,9 +1193,6 @@ DataFrame right_join_impl(DataFrame x, DataFrame y,
     // train the map in terms of x
     train_push_back( map, x.nrows() ) ;
 
-    std::vector<int> indices_x ;
-    std::vector<int> indices_y ;
-
     int n_y = y.nrows() ;
     for( int i=0; i<n_y; i++){
         // find a row in y that matches row i in x
@@ -822,6 +1219,27 @@ DataFrame full_join_impl(DataFrame x, DataFrame y,
                           CharacterVector by_x, CharacterVector by_y,
                           std::string& suffix_x, std::string& suffix_y){
     if( by_x.size() == 0) stop("no variable to join by") ;
+    std::vector<int> indices_x ;
+    std::vector<int> indices_y ;
+
+    SEXP kx, ky ;
+    if( direct_join_keys( x, y, by_x, by_y, kx, ky ) ){
+        boost::scoped_ptr<DirectIndex> index( DirectIndex::make(ky) ) ;
+        if( index ){
+            std::vector<bool> matched( index->slots(), false ) ;
+            direct_probe( kx, *index, true, indices_x, indices_y, &matched ) ;
+            // the rows of y whose slot no row of x found
+            const int* py = INTEGER(ky) ;
+            int n_y = y.nrows() ;
+            for( int i=0; i<n_y; i++){
+                if( matched[ index->slot( py[i] ) ] ) continue ;
+                indices_x.push_back(-i-1) ;
+                indices_y.push_back(i) ;
+            }
+            return subset_join( x, y, indices_x, indices_y, by_x, by_y, suffix_x, suffix_y, x.attr( "class" ) ) ;
+        }
+    }
+
     typedef VisitorSetIndexMap<DataFrameJoinVisitors, std::vector<int> > Map ;
     DataFrameJoinVisitors visitors(y, x, by_y, by_x, true) ;
     Map map(visitors);
@@ -829,9 +1247,6 @@ DataFrame full_join_impl(DataFrame x, DataFrame y,
     // train the map in terms of y
     train_push_back( map, y.nrows() ) ;
 
-    std::vector<int> indices_x ;
-    std::vector<int> indices_y ;
-
     int n_x = x.nrows(), n_y = y.nrows() ;
 
     // get both the matches and the rows from left but not right
@@ -1024,16 +1439,145 @@ private:
     int max_count ;
 } ;
 
+// row i of the left data frame against row i of the right one, one column
+// at a time, stopping at the first difference
+bool same_rows_in_order( DataFrameJoinVisitors& visitors, int n ){
+    int nvisitors = visitors.size() ;
+    for( int k=0; k<nvisitors; k++){
+        JoinVisitor* v = visitors.get(k) ;
+        for( int i=0; i<n; i++){
+            if( !v->equal(i, -i-1) ) return false ;
+        }
+    }
+    return true ;
+}
+
+// resolves the partitions of a set operation on the threads of an
+// ExecutionContext. Op::visit( partitions, p, buffer ) handles partition p
+// and records what it finds in the buffer of its range, so that workers
+// share nothing and never touch the R API. The buffers hold the results of
+// the partitions in order, and the main thread merges them by row.
+template <typename Op>
+class PartitionRunner {
+public:
+    typedef typename Op::Buffer Buffer ;
+
+    PartitionRunner( const RowPartitions& partitions_ ) :
+        partitions(partitions_), context(), buffers( partitions_.ranges(context) )
+    {
+        partitions.run( context, *this ) ;
+    }
+
+    inline void operator()( int range, int begin, int end ){
+        for( int p=begin; p<end; p++) Op::visit( partitions, p, buffers[range] ) ;
+    }
+
+    inline int size() const { return buffers.size() ; }
+    inline const Buffer& operator[]( int range ) const { return buffers[range] ; }
+
+private:
+    const RowPartitions& partitions ;
+    ExecutionContext context ;
+    std::vector<Buffer> buffers ;
+} ;
+
+// distinct rows of x only, of y only, and with different counts
+struct EqualRows {
+    struct Buffer {
+        std::vector<int> x, y, mismatch ;
+    } ;
+
+    static void visit( const RowPartitions& partitions, int p, Buffer& out ){
+        // count the occurences of each distinct row in x and y. A map is
+        // keyed by the first row with these values ( -ves for y, +ves for x )
+        typedef RowPartitions::Map< std::pair<int,int> > Counts ;
+        Counts counts( partitions, p ) ;
+
+        const int* rows_x = partitions.left_begin(p) ;
+        for( int i=0; i<partitions.left_size(p); i++) counts[ rows_x[i] ].first++ ;
+        const int* rows_y = partitions.right_begin(p) ;
+        for( int i=0; i<partitions.right_size(p); i++) counts[ rows_y[i] ].second++ ;
+
+        Counts::const_iterator it = counts.begin() ;
+        for( ; it != counts.end(); ++it){
+            int count_left = it->second.first, count_right = it->second.second ;
+            if( count_right == 0 ){
+                out.x.push_back( it->first ) ;
+            } else if( count_left == 0){
+                out.y.push_back( it->first ) ;
+            } else if( count_left != count_right ){
+                out.mismatch.push_back( it->first ) ;
+            }
+        }
+    }
+} ;
+
+// first occurrence of each distinct row, left before right
+struct UnionRows {
+    typedef std::vector<int> Buffer ;
+
+    static void visit( const RowPartitions& partitions, int p, Buffer& out ){
+        RowPartitions::Set set( partitions, p ) ;
+
+        const int* rows_x = partitions.left_begin(p) ;
+        for( int i=0; i<partitions.left_size(p); i++){
+            if( set.insert( rows_x[i] ).second ) out.push_back( rows_x[i] ) ;
+        }
+        const int* rows_y = partitions.right_begin(p) ;
+        for( int i=0; i<partitions.right_size(p); i++){
+            if( set.insert( rows_y[i] ).second ) out.push_back( rows_y[i] ) ;
+        }
+    }
+} ;
+
+// for the first row of the right data frame equal to a row of the left
+// one, the pair of that row and the first such row of the left one. Rows
+// of the left data frame are only matched once unless Repeat
+template <bool Repeat>
+struct MatchRows {
+    typedef std::vector< std::pair<int,int> > Buffer ;
+
+    static void visit( const RowPartitions& partitions, int p, Buffer& out ){
+        RowPartitions::Set set( partitions, p ) ;
+
+        const int* rows_x = partitions.left_begin(p) ;
+        for( int i=0; i<partitions.left_size(p); i++) set.insert( rows_x[i] ) ;
+
+        const int* rows_y = partitions.right_begin(p) ;
+        for( int i=0; i<partitions.right_size(p); i++){
+            RowPartitions::Set::iterator it = set.find( rows_y[i] ) ;
+            if( it == set.end() ) continue ;
+            out.push_back( std::make_pair( rows_y[i], *it ) ) ;
+            if( !Repeat ) set.erase(it) ;
+        }
+    }
+} ;
+
+// first occurrence of each distinct row of the right data frame that is
+// not in the left one
+struct DiffRows {
+    typedef std::vector<int> Buffer ;
+
+    static void visit( const RowPartitions& partitions, int p, Buffer& out ){
+        RowPartitions::Set set( partitions, p ) ;
+
+        const int* rows_y = partitions.left_begin(p) ;
+        for( int i=0; i<partitions.left_size(p); i++) set.insert( rows_y[i] ) ;
+
+        const int* rows_x = partitions.right_begin(p) ;
+        for( int i=0; i<partitions.right_size(p); i++){
+            if( set.insert( rows_x[i] ).second ) out.push_back( rows_x[i] ) ;
+        }
+    }
+} ;
+
 // [[Rcpp::export]]
 dplyr::BoolResult equal_data_frame(DataFrame x, DataFrame y, bool ignore_col_order = true, bool ignore_row_order = true, bool convert = false ){
     BoolResult compat = compatible_data_frame(x, y, ignore_col_order, convert);
     if( !compat ) return compat ;
 
-    typedef VisitorSetIndexMap<DataFrameJoinVisitors, std::vector<int> > Map ;
     DataFrameJoinVisitors visitors(x, y, x.names(), x.names(), true ) ;
-    Map map(visitors);
 
-    // train the map in both x and y
     int nrows_x = x.nrows() ;
     int nrows_y = y.nrows() ;
 
@@ -1042,39 +1586,24 @@ dplyr::BoolResult equal_data_frame(DataFrame x, DataFrame y, bool ignore_col_ord
     if( x.size() == 0 )
         return yes() ;
 
-    for( int i=0; i<nrows_x; i++) map[i].push_back(i) ;
-    for( int i=0; i<nrows_y; i++) map[-i-1].push_back(-i-1) ;
+    // the common case, whether or not the row order matters
+    if( same_rows_in_order( visitors, nrows_x ) )
+        return yes() ;
+
+    RowPartitions partitions( visitors, nrows_x, nrows_y ) ;
+    PartitionRunner<EqualRows> runner( partitions ) ;
 
     RowTrack track_x( "Rows in x but not y: " ) ;
     RowTrack track_y( "Rows in y but not x: " ) ;
     RowTrack track_mismatch( "Rows with difference occurences in x and y: " ) ;
 
     bool ok = true ;
-    Map::const_iterator it = map.begin() ;
-
-    for( ; it != map.end(); ++it){
-        // retrieve the indices ( -ves for y, +ves for x )
-        const std::vector<int>& chunk = it->second ;
-        int n = chunk.size() ;
-
-        int count_left = 0, count_right = 0 ;
-        for( int i=0; i<n; i++){
-            if( chunk[i] < 0 )
-                count_right++ ;
-            else
-                count_left++ ;
-        }
-        if( count_right == 0 ){
-            track_x.record( chunk[0] ) ;
-            ok = false ;
-        } else if( count_left == 0){
-            track_y.record( chunk[0] ) ;
-            ok = false ;
-        } else if( count_left != count_right ){
-            track_mismatch.record( chunk[0] ) ;
-            ok = false ;
-        }
-
+    for( int r=0; r<runner.size(); r++){
+        const EqualRows::Buffer& rows = runner[r] ;
+        for( size_t i=0; i<rows.x.size(); i++) track_x.record( rows.x[i] ) ;
+        for( size_t i=0; i<rows.y.size(); i++) track_y.record( rows.y[i] ) ;
+        for( size_t i=0; i<rows.mismatch.size(); i++) track_mismatch.record( rows.mismatch[i] ) ;
+        if( rows.x.size() || rows.y.size() || rows.mismatch.size() ) ok = false ;
     }
 
     if(!ok){
@@ -1086,17 +1615,9 @@ dplyr::BoolResult equal_data_frame(DataFrame x, DataFrame y, bool ignore_col_ord
         return no_because( ss.str() ) ;
     }
 
-    if(ok && ignore_row_order) return yes();
-
-    if( !ignore_row_order ){
-        for( int i=0; i<nrows_x; i++){
-            if( !visitors.equal( i, -i-1) ){
-                    return no_because( "Same row values, but different order" ) ;
-            }
-        }
-    }
+    if( ignore_row_order ) return yes();
 
-    return yes() ;
+    return no_because( "Same row values, but different order" ) ;
 }
 
 // [[Rcpp::export]]
@@ -1117,14 +1638,27 @@ DataFrame union_data_frame( DataFrame x, DataFrame y){
         stop( "not compatible: %s", compat.why_not() );
     }
 
-    typedef VisitorSetIndexSet<DataFrameJoinVisitors> Set ;
     DataFrameJoinVisitors visitors(x, y, x.names(), x.names(), true) ;
-    Set set(visitors);
+    int n_x = x.nrows(), n_y = y.nrows() ;
+    RowPartitions partitions( visitors, n_x, n_y ) ;
+    PartitionRunner<UnionRows> runner( partitions ) ;
+
+    // first occurrence of each distinct row, x before y
+    std::vector<bool> keep_x(n_x, false), keep_y(n_y, false) ;
+    for( int r=0; r<runner.size(); r++){
+        const UnionRows::Buffer& rows = runner[r] ;
+        for( size_t i=0; i<rows.size(); i++){
+            int row = rows[i] ;
+            if( row >= 0 ) keep_x[row] = true ;
+            else keep_y[-row-1] = true ;
+        }
+    }
 
-    train_insert( set, x.nrows() ) ;
-    train_insert_right( set, y.nrows() ) ;
+    std::vector<int> indices ;
+    for( int i=0; i<n_x; i++) if( keep_x[i] ) indices.push_back(i) ;
+    for( int i=0; i<n_y; i++) if( keep_y[i] ) indices.push_back(-i-1) ;
 
-    return visitors.subset( set, x.attr("class") ) ;
+    return visitors.subset( indices, x.attr("class") ) ;
 }
 
 // [[Rcpp::export]]
@@ -1133,22 +1667,21 @@ DataFrame intersect_data_frame( DataFrame x, DataFrame y){
     if( !compat ){
         stop( "not compatible: %s", compat.why_not() );
     }
-    typedef VisitorSetIndexSet<DataFrameJoinVisitors> Set ;
 
     DataFrameJoinVisitors visitors(x, y, x.names(), x.names(), true ) ;
-    Set set(visitors);
+    int n_x = x.nrows(), n_y = y.nrows() ;
+    RowPartitions partitions( visitors, n_x, n_y ) ;
+    PartitionRunner< MatchRows<false> > runner( partitions ) ;
 
-    train_insert( set, x.nrows() ) ;
+    // for the first row of y equal to a row of x, the first such row of x
+    std::vector<int> found(n_y, -1) ;
+    for( int r=0; r<runner.size(); r++){
+        const MatchRows<false>::Buffer& rows = runner[r] ;
+        for( size_t i=0; i<rows.size(); i++) found[ -rows[i].first-1 ] = rows[i].second ;
+    }
 
     std::vector<int> indices ;
-    int n_y = y.nrows() ;
-    for( int i=0; i<n_y; i++) {
-        Set::iterator it = set.find( -i-1 ) ;
-        if( it != set.end() ){
-            indices.push_back(*it) ;
-            set.erase(it) ;
-        }
-    }
+    for( int i=0; i<n_y; i++) if( found[i] >= 0 ) indices.push_back( found[i] ) ;
 
     return visitors.subset( indices, x.attr("class") ) ;
 }
@@ -1160,21 +1693,20 @@ DataFrame setdiff_data_frame( DataFrame x, DataFrame y){
         stop( "not compatible: %s", compat.why_not() );
     }
 
-    typedef VisitorSetIndexSet<DataFrameJoinVisitors> Set ;
     DataFrameJoinVisitors visitors(y, x, y.names(), y.names(), true ) ;
-    Set set(visitors);
+    int n_y = y.nrows(), n_x = x.nrows() ;
+    RowPartitions partitions( visitors, n_y, n_x ) ;
+    PartitionRunner<DiffRows> runner( partitions ) ;
 
-    train_insert( set, y.nrows() ) ;
+    // first occurrence of each distinct row of x that is not in y
+    std::vector<bool> keep(n_x, false) ;
+    for( int r=0; r<runner.size(); r++){
+        const DiffRows::Buffer& rows = runner[r] ;
+        for( size_t i=0; i<rows.size(); i++) keep[ -rows[i]-1 ] = true ;
+    }
 
     std::vector<int> indices ;
-
-    int n_x = x.nrows() ;
-    for( int i=0; i<n_x; i++) {
-        if( !set.count(-i-1) ){
-            set.insert(-i-1) ;
-            indices.push_back(-i-1) ;
-        }
-    }
+    for( int i=0; i<n_x; i++) if( keep[i] ) indices.push_back(-i-1) ;
 
     return visitors.subset( indices, x.attr("class") ) ;
 }
@@ -1184,17 +1716,15 @@ IntegerVector match_data_frame( DataFrame x, DataFrame y){
     if( !compatible_data_frame(x,y,true,true) )
         stop( "not compatible" );
 
-    typedef VisitorSetIndexSet<DataFrameJoinVisitors> Set ;
     DataFrameJoinVisitors visitors(y, x, x.names(), x.names(), true ) ;
-    Set set(visitors);
+    int n_y = y.nrows(), n_x = x.nrows() ;
+    RowPartitions partitions( visitors, n_y, n_x ) ;
+    PartitionRunner< MatchRows<true> > runner( partitions ) ;
 
-    train_insert( set, y.nrows() ) ;
-
-    int n_x = x.nrows() ;
-    IntegerVector res = no_init( n_x );
-    for( int i=0; i<n_x; i++) {
-        Set::iterator it = set.find( -i-1 );
-        res[i] = ( it == set.end() ) ? NA_INTEGER : (*it+1) ;
+    IntegerVector res( n_x, NA_INTEGER ) ;
+    for( int r=0; r<runner.size(); r++){
+        const MatchRows<true>::Buffer& rows = runner[r] ;
+        for( size_t i=0; i<rows.size(); i++) res[ -rows[i].first-1 ] = rows[i].second + 1 ;
     }
 
     return res ;
@@ -1236,7 +1766,19 @@ DataFrame grouped_df_impl( DataFrame data, ListOf<Symbol> symbols, bool drop ){
     copy.attr("drop") = drop ;
     if( !symbols.size() )
         stop("no variables to group by") ;
-    return build_index_cpp(copy) ;
+    ProfiledPhase phase( "group_by", "index", data.nrows(), 0 ) ;
+    int hits = group_index_cache().hits() ;
+    DataFrame res = build_index_cpp(copy) ;
+    if( group_index_cache().hits() > hits ){
+        phase.set_handler( "cache" ) ;
+    } else {
+        CharacterVector vars( symbols.size() ) ;
+        for( int i=0; i<symbols.size(); i++) vars[i] = PRINTNAME(symbols[i]) ;
+        if( sorted_keys().sorted_by( res, vars ) ) phase.set_handler( "sorted" ) ;
+    }
+    phase.set_groups( Rf_length(res.attr("group_sizes")) ) ;
+    phase.done() ;
+    return res ;
 }
 
 DataFrame build_index_cpp( DataFrame data ){
@@ -1264,6 +1806,17 @@ DataFrame build_index_cpp( DataFrame data ){
         }
     }
 
+    if( group_index_cache().get( data, vars ) ){
+        data.attr( "class" ) = CharacterVector::create("grouped_df", "tbl_df", "tbl", "data.frame") ;
+        return data ;
+    }
+    if( sorted_keys().sorted_by( data, vars ) ){
+        return build_index_sorted( data, vars ) ;
+    }
+    if( build_index_direct( data, vars ) ){
+        return data ;
+    }
+
     DataFrameVisitors visitors(data, vars) ;
     ChunkIndexMap map( visitors ) ;
 
@@ -1298,9 +1851,84 @@ DataFrame build_index_cpp( DataFrame data ){
     data.attr( "biggest_group_size" ) = biggest_group ;
     data.attr( "labels" ) = labels ;
     data.attr( "class" ) = CharacterVector::create("grouped_df", "tbl_df", "tbl", "data.frame") ;
+    group_index_cache().put( data, vars ) ;
     return data ;
 }
 
+// data sorted by the grouping variables: the groups are runs of equal values
+// in adjacent rows, already in the order of the labels
+DataFrame build_index_sorted( DataFrame data, const CharacterVector& vars ){
+    DataFrameVisitors visitors(data, vars) ;
+    std::vector<int> sizes ;
+    std::vector<int> first ;
+    int n = data.nrows() ;
+
+    int i=0 ;
+    while( i<n ){
+        int start = i++ ;
+        for( ; i<n && visitors.equal(i, start) ; i++) ;
+        sizes.push_back(i-start) ;
+        first.push_back(start) ;
+    }
+
+    int ngroups = sizes.size() ;
+    List indices(ngroups) ;
+    int biggest_group = 0 ;
+    for( int g=0; g<ngroups; g++){
+        IntegerVector chunk = no_init( sizes[g] ) ;
+        for( int k=0; k<sizes[g]; k++) chunk[k] = first[g] + k ;
+        indices[g] = chunk ;
+        biggest_group = std::max( biggest_group, sizes[g] ) ;
+    }
+
+    data.attr( "indices" ) = indices ;
+    data.attr( "group_sizes") = sizes ;
+    data.attr( "biggest_group_size" ) = biggest_group ;
+    data.attr( "labels" ) = DataFrameSubsetVisitors(data, vars).subset(first, "data.frame") ;
+    data.attr( "class" ) = CharacterVector::create("grouped_df", "tbl_df", "tbl", "data.frame") ;
+    group_index_cache().put( data, vars ) ;
+    return data ;
+}
+
+// a single integer or factor grouping variable with dense values: the rows
+// are gathered by value in an array indexed by value, whose slots are in the
+// order of the labels. Returns false otherwise
+bool build_index_direct( DataFrame& data, const CharacterVector& vars ){
+    if( vars.size() != 1 ) return false ;
+    SEXP x = data[ std::string( CHAR(STRING_ELT(vars, 0)) ) ] ;
+    if( !direct_key( x, true ) ) return false ;
+    boost::scoped_ptr<DirectIndex> index( DirectIndex::make(x) ) ;
+    if( !index ) return false ;
+
+    int nslots = index->slots() ;
+    int ngroups = 0 ;
+    for( int s=0; s<nslots; s++) if( index->size(s) ) ngroups++ ;
+
+    List indices(ngroups) ;
+    IntegerVector group_sizes = no_init( ngroups ) ;
+    std::vector<int> first( ngroups ) ;
+    int biggest_group = 0 ;
+    for( int s=0, g=0; s<nslots; s++){
+        int size = index->size(s) ;
+        if( !size ) continue ;
+        indices[g] = IntegerVector( index->begin(s), index->end(s) ) ;
+        group_sizes[g] = size ;
+        first[g] = *index->begin(s) ;
+        biggest_group = std::max( biggest_group, size ) ;
+        g++ ;
+    }
+
+    data.attr( "indices" ) = indices ;
+    data.attr( "group_sizes") = group_sizes ;
+    data.attr( "biggest_group_size" ) = biggest_group ;
+    data.attr( "labels" ) = DataFrameSubsetVisitors(data, vars).subset(first, "data.frame") ;
+    data.attr( "class" ) = CharacterVector::create("grouped_df", "tbl_df", "tbl", "data.frame") ;
+    group_index_cache().put( data, vars ) ;
+    return true ;
+}
+
+// groups are runs of equal values in adjacent rows. Only the sizes of the
+// runs are stored, the rows of group i start at the sum of the previous sizes
 DataFrame build_index_adj(DataFrame df, ListOf<Symbol> symbols ){
     int nsymbols = symbols.size() ;
     CharacterVector vars(nsymbols) ;
@@ -1310,6 +1938,7 @@ DataFrame build_index_adj(DataFrame df, ListOf<Symbol> symbols ){
 
     DataFrameVisitors visitors(df, vars) ;
     std::vector<int> sizes ;
+    std::vector<int> first ;
     int n = df.nrows() ;
 
     int i=0 ;
@@ -1317,37 +1946,36 @@ DataFrame build_index_adj(DataFrame df, ListOf<Symbol> symbols ){
         int start = i++ ;
         for( ; i<n && visitors.equal(i, start) ; i++) ;
         sizes.push_back(i-start) ;
+        first.push_back(start) ;
     }
 
-    n = sizes.size() ;
-    List indices(n);
-    IntegerVector first = no_init(n) ;
-    int start = 0 ;
-    int biggest_group = 0 ;
-    for( int i=0; i<n; i++){
-        first[i] = start ;
-        int end = start + sizes[i] - 1 ;
-        indices[i] = seq(start, end) ;
-        start = end + 1 ;
-        biggest_group = std::max( biggest_group, sizes[i]) ;
-    }
-
-    df.attr( "indices") = indices ;
-    df.attr( "labels")  = DataFrameSubsetVisitors(df, vars).subset(first, "data.frame") ;
-    df.attr( "group_sizes") = sizes ;
-    df.attr( "biggest_group_size") = biggest_group ;
-    df.attr( "class" ) = CharacterVector::create("adj_grouped_df", "grouped_df", "tbl_df", "tbl", "data.frame") ;
     df.attr( "vars" ) = symbols ;
-
+    set_adjacent_index( df, sizes, DataFrameSubsetVisitors(df, vars).subset(first, "data.frame") ) ;
     return df ;
 }
 
+void set_adjacent_index( DataFrame& data, const std::vector<int>& sizes, DataFrame labels ){
+    int biggest_group = 0 ;
+    for( size_t i=0; i<sizes.size(); i++){
+        biggest_group = std::max( biggest_group, sizes[i] ) ;
+    }
+
+    data.attr( "indices") = R_NilValue ;
+    data.attr( "labels")  = labels ;
+    data.attr( "group_sizes") = sizes ;
+    data.attr( "biggest_group_size") = biggest_group ;
+    data.attr( "class" ) = CharacterVector::create("adj_grouped_df", "grouped_df", "tbl_df", "tbl", "data.frame") ;
+}
+
 // [[Rcpp::export]]
 DataFrame grouped_df_adj_impl( DataFrame data, ListOf<Symbol> symbols, bool drop ){
+    assert_all_white_list(data);
     DataFrame copy( shallow_copy(data));
     copy.attr("vars") = symbols ;
     copy.attr("drop") = drop ;
-    return build_index_adj(data, symbols) ;
+    if( !symbols.size() )
+        stop("no variables to group by") ;
+    return build_index_adj(copy, symbols) ;
 }
 
 typedef dplyr_hash_set<SEXP> SymbolSet ;
@@ -1599,7 +2227,11 @@ SEXP mutate_not_grouped(DataFrame df, const LazyDots& dots){
         Environment env = lazy.env() ;
         call_proxy.set_env(env) ;
 
+        ProfiledPhase phase( "mutate", "evaluate", nrows, 1 ) ;
+        phase.set_expr( name, call ) ;
+
         if( TYPEOF(call) == SYMSXP ){
+            phase.set_handler( "column" ) ;
             if(call_proxy.has_variable(call)){
                 results[i] = call_proxy.get_variable(PRINTNAME(call)) ;
             } else {
@@ -1609,10 +2241,13 @@ SEXP mutate_not_grouped(DataFrame df, const LazyDots& dots){
             call_proxy.set_call( call );
             results[i] = call_proxy.eval() ;
         } else if( Rf_length(call) == 1 ){
+            phase.set_handler( "constant" ) ;
             boost::scoped_ptr<Gatherer> gather( constant_gatherer( call, nrows ) );
             results[i] = gather->collect() ;
         } else if( Rf_isNull(call)) {
+            phase.set_handler( "constant" ) ;
             accumulator.rm(name) ;
+            phase.done() ;
             continue ;
         } else {
             stop( "cannot handle" ) ;
@@ -1634,14 +2269,37 @@ SEXP mutate_not_grouped(DataFrame df, const LazyDots& dots){
             stop( "wrong result size (%d), expected %d or 1", n_res, nrows ) ;
         }
 
+        phase.set_result( results[i] ) ;
         call_proxy.input( name, results[i] ) ;
         accumulator.set( name, results[i] );
+        phase.done() ;
     }
+    ProfiledPhase structure( "mutate", "structure", nrows, 1 ) ;
     List res = structure_mutate(accumulator, df, classes_not_grouped() ) ;
+    structure.done() ;
 
     return res ;
 }
 
+// evaluates an elementwise call on the whole columns, see is_elementwise()
+SEXP eval_elementwise( SEXP call, LazySubsets& columns, const Environment& env, SEXP name ){
+    CallProxy call_proxy( call, columns, env ) ;
+    RObject res( call_proxy.eval() ) ;
+    check_supported_type(res, name) ;
+    if( Rf_inherits(res, "POSIXlt") ){
+        stop("`mutate` does not support `POSIXlt` results");
+    }
+
+    int nrows = columns.nrows() ;
+    int n = Rf_length(res) ;
+    if( n == nrows ) return res ;
+    if( n != 1 ){
+        stop( "wrong result size (%d), expected %d or 1", n, nrows ) ;
+    }
+    boost::scoped_ptr<Gatherer> gather( constant_gatherer( res, nrows ) );
+    return gather->collect() ;
+}
+
 template <typename Data, typename Subsets>
 SEXP mutate_grouped(const DataFrame& df, const LazyDots& dots){
     // special 0 rows case
@@ -1658,6 +2316,7 @@ SEXP mutate_grouped(const DataFrame& df, const LazyDots& dots){
     check_not_groups(dots, gdf);
 
     Proxy proxy(gdf) ;
+    LazySubsets columns(df) ;
 
     NamedListAccumulator<Data> accumulator ;
     int ncolumns = df.size() ;
@@ -1677,7 +2336,11 @@ SEXP mutate_grouped(const DataFrame& df, const LazyDots& dots){
         SEXP name = lazy.name() ;
         proxy.set_env( env ) ;
 
+        ProfiledPhase phase( "mutate", "evaluate", gdf.nrows(), gdf.ngroups() ) ;
+        phase.set_expr( name, call ) ;
+
         if( TYPEOF(call) == SYMSXP ){
+            phase.set_handler( "column" ) ;
             if(proxy.has_variable(call)){
                 SEXP variable = variables[i] = proxy.get_variable( PRINTNAME(call) ) ;
                 proxy.input( name, variable ) ;
@@ -1707,25 +2370,41 @@ SEXP mutate_grouped(const DataFrame& df, const LazyDots& dots){
             }
 
         } else if(TYPEOF(call) == LANGSXP){
-            proxy.set_call( call );
-            boost::scoped_ptr<Gatherer> gather( gatherer<Data, Subsets>( proxy, gdf, name ) );
-            SEXP variable = variables[i] = gather->collect() ;
+            SEXP variable ;
+            if( is_elementwise( call, columns, env ) ){
+                // the same for all groups, so evaluated once on whole columns
+                phase.set_handler( "elementwise" ) ;
+                variable = variables[i] = eval_elementwise( call, columns, env, name ) ;
+            } else {
+                proxy.set_call( call );
+                boost::scoped_ptr<Gatherer> gather( gatherer<Data, Subsets>( proxy, gdf, name ) );
+                variable = variables[i] = gather->collect() ;
+            }
             proxy.input( name, variable ) ;
             accumulator.set( name, variable) ;
         } else if(Rf_length(call) == 1) {
+            phase.set_handler( "constant" ) ;
             boost::scoped_ptr<Gatherer> gather( constant_gatherer( call, gdf.nrows() ) );
             SEXP variable = variables[i] = gather->collect() ;
             proxy.input( name, variable ) ;
             accumulator.set( name, variable) ;
         } else if( Rf_isNull(call) ){
+            phase.set_handler( "constant" ) ;
             accumulator.rm(name) ;
+            phase.done() ;
             continue ;
         } else {
             stop( "cannot handle" ) ;
         }
+        columns.input( name, variables[i] ) ;
+        phase.set_result( variables[i] ) ;
+        phase.done() ;
     }
 
-    return structure_mutate(accumulator, df, df.attr("class") );
+    ProfiledPhase structure( "mutate", "structure", gdf.nrows(), gdf.ngroups() ) ;
+    Shield<SEXP> res( structure_mutate(accumulator, df, df.attr("class") ) ) ;
+    structure.done() ;
+    return res ;
 }
 
 
@@ -1781,6 +2460,12 @@ SEXP n_distinct_multi( List variables, bool na_rm = false){
       stop("need at least one column for n_distinct()");
     }
 
+    if( variables.length() == 1 && direct_key( variables[0], true ) ){
+      SEXP x = variables[0] ;
+      Count_Distinct_Direct counter( x, na_rm ) ;
+      return counter.process( SlicingIndex(0, Rf_length(x)) ) ;
+    }
+
     MultipleVectorVisitors visitors(variables) ;
     SlicingIndex everything(0, visitors.nrows()) ;
     if( na_rm ){
@@ -88,6 +88,65 @@ inline DataFrame grouped_subset( const Data& gdf, const LogicalVector& test, con
   return Data(res).data() ;
 }
 
+// adjacent groups stay adjacent after filtering, so the new group sizes are
+// counted directly instead of hashing the grouping variables again
+template <>
+inline DataFrame grouped_subset<GroupedDataFrame>( const GroupedDataFrame& gdf, const LogicalVector& test, const CharacterVector& names, CharacterVector classes){
+  DataFrame data = gdf.data() ;
+  DataFrame res = subset( data, test, names, classes) ;
+  res.attr("vars")   = data.attr("vars") ;
+  strip_index(res);
+  if( !gdf.is_adjacent() ){
+      return GroupedDataFrame(res).data() ;
+  }
+  res.attr("drop")   = data.attr("drop") ;
+
+  DataFrame labels = data.attr("labels") ;
+  DataFrameVisitors label_visitors(labels) ;
+  const IntegerVector& group_sizes = gdf.get_group_sizes() ;
+  int ngroups = gdf.ngroups() ;
+
+  std::vector<int> sizes ;
+  std::vector<int> kept ;
+  for( int i=0, start=0; i<ngroups; start += group_sizes[i], i++){
+      int end = start + group_sizes[i] ;
+      int count = 0 ;
+      for( int j=start; j<end; j++){
+          if( test[j] == TRUE ) count++ ;
+      }
+      if( !count ) continue ;
+
+      // runs of the same group separated by rows that were all removed
+      if( !kept.empty() && label_visitors.equal( kept.back(), i ) ){
+          sizes.back() += count ;
+      } else {
+          kept.push_back(i) ;
+          sizes.push_back(count) ;
+      }
+  }
+  if( (int)kept.size() < ngroups ){
+      labels = DataFrameSubsetVisitors(labels).subset( kept, "data.frame" ) ;
+  }
+  set_adjacent_index( res, sizes, labels ) ;
+  return res ;
+}
+
+// an elementwise condition is the same for all groups, so it is evaluated
+// once on the whole columns, see is_elementwise()
+void filter_elementwise( LogicalVector& test, SEXP call, LazySubsets& columns, const Environment& env ){
+    CallProxy call_proxy( call, columns, env ) ;
+    LogicalVector g_test = check_filter_logical_result( call_proxy.eval() ) ;
+    int n = test.size() ;
+    if( g_test.size() == 1 ){
+        if( g_test[0] != TRUE ) std::fill( test.begin(), test.end(), FALSE ) ;
+    } else {
+        check_filter_result( g_test, n ) ;
+        for( int i=0; i<n; i++){
+            if( g_test[i] != TRUE ) test[i] = FALSE ;
+        }
+    }
+}
+
 template <typename Data, typename Subsets>
 DataFrame filter_grouped_single_env( const Data& gdf, const LazyDots& dots){
     typedef GroupedCallProxy<Data, Subsets> Proxy ;
@@ -107,28 +166,44 @@ DataFrame filter_grouped_single_env( const Data& gdf, const LazyDots& dots){
     LogicalVector test(nrows, TRUE);
 
     LogicalVector g_test ;
-    Proxy call_proxy( call, gdf, env ) ;
+    LazySubsets columns(data) ;
 
     int ngroups = gdf.ngroups() ;
-    typename Data::group_iterator git = gdf.group_begin() ;
-    for( int i=0; i<ngroups; i++, ++git){
-        SlicingIndex indices = *git ;
-        int chunk_size = indices.size() ;
-
-        g_test = check_filter_logical_result( call_proxy.get( indices ) ) ;
-        if( g_test.size() == 1 ){
-            int val = g_test[0] == TRUE ;
-            for( int j=0; j<chunk_size; j++){
-                test[ indices[j] ] = val ;
-            }
+    {
+        ProfiledPhase phase( "filter", "evaluate", nrows, ngroups ) ;
+        phase.set_expr( R_NilValue, call ) ;
+        if( is_elementwise( call, columns, env ) ){
+            phase.set_handler( "elementwise" ) ;
+            filter_elementwise( test, call, columns, env ) ;
         } else {
-            check_filter_result(g_test, chunk_size ) ;
-            for( int j=0; j<chunk_size; j++){
-                if( g_test[j] != TRUE ) test[ indices[j] ] = FALSE ;
+            Proxy call_proxy( call, gdf, env ) ;
+            typename Data::group_iterator git = gdf.group_begin() ;
+            for( int i=0; i<ngroups; i++, ++git){
+                SlicingIndex indices = *git ;
+                int chunk_size = indices.size() ;
+
+                g_test = check_filter_logical_result( call_proxy.get( indices ) ) ;
+                if( g_test.size() == 1 ){
+                    int val = g_test[0] == TRUE ;
+                    for( int j=0; j<chunk_size; j++){
+                        test[ indices[j] ] = val ;
+                    }
+                } else {
+                    check_filter_result(g_test, chunk_size ) ;
+                    for( int j=0; j<chunk_size; j++){
+                        if( g_test[j] != TRUE ) test[ indices[j] ] = FALSE ;
+                    }
+                }
             }
         }
+        phase.set_result( test ) ;
+        phase.done() ;
     }
-    return grouped_subset<Data>( gdf, test, names, classes_grouped<Data>() ) ;
+
+    ProfiledPhase subset_phase( "filter", "subset", nrows, ngroups ) ;
+    DataFrame res = grouped_subset<Data>( gdf, test, names, classes_grouped<Data>() ) ;
+    subset_phase.done() ;
+    return res ;
 }
 
 // version of grouped filter when contributions to ... come from several environment
@@ -145,14 +220,24 @@ DataFrame filter_grouped_multiple_env( const Data& gdf, const LazyDots& dots){
     LogicalVector test(nrows, TRUE);
 
     LogicalVector g_test ;
+    LazySubsets columns(data) ;
 
     for( int k=0; k<dots.size(); k++){
         Rcpp::checkUserInterrupt() ;
         const Lazy& lazy = dots[k] ;
 
         Call call( lazy.expr() ) ;
-        GroupedCallProxy<Data, Subsets> call_proxy( call, gdf, lazy.env() ) ;
         int ngroups = gdf.ngroups() ;
+        ProfiledPhase phase( "filter", "evaluate", nrows, ngroups ) ;
+        phase.set_expr( R_NilValue, call ) ;
+        if( is_elementwise( call, columns, lazy.env() ) ){
+            phase.set_handler( "elementwise" ) ;
+            filter_elementwise( test, call, columns, lazy.env() ) ;
+            phase.done() ;
+            continue ;
+        }
+
+        GroupedCallProxy<Data, Subsets> call_proxy( call, gdf, lazy.env() ) ;
         typename Data::group_iterator git = gdf.group_begin() ;
         for( int i=0; i<ngroups; i++, ++git){
             SlicingIndex indices = *git ;
@@ -174,8 +259,13 @@ DataFrame filter_grouped_multiple_env( const Data& gdf, const LazyDots& dots){
                 }
             }
         }
+        phase.done() ;
     }
-    return grouped_subset<Data>( gdf, test, names, classes_grouped<Data>() ) ;
+
+    ProfiledPhase subset_phase( "filter", "subset", nrows, gdf.ngroups() ) ;
+    DataFrame res = grouped_subset<Data>( gdf, test, names, classes_grouped<Data>() ) ;
+    subset_phase.done() ;
+    return res ;
 }
 
 template <typename Data, typename Subsets>
@@ -208,21 +298,206 @@ bool combine_and(LogicalVector& test, const LogicalVector& test2){
     return false;
 }
 
+// whether x uses a variable of the data, or n(), which is only defined in the data
+bool uses_data( SEXP x, const SymbolSet& set ){
+    switch( TYPEOF(x) ){
+    case SYMSXP: return set.count(x) > 0 ;
+    case LANGSXP:
+        if( CAR(x) == Rf_install("n") ) return true ;
+        for( ; !Rf_isNull(x); x = CDR(x) ){
+            if( uses_data( CAR(x), set ) ) return true ;
+        }
+        return false ;
+    default: break ;
+    }
+    return false ;
+}
+
+// the values of a bare logical, integer or double vector, as the doubles
+// they are compared as
+class NumericValues {
+public:
+    NumericValues( SEXP x ) :
+        ints( TYPEOF(x) == REALSXP ? 0 : INTEGER(x) ),
+        reals( TYPEOF(x) == REALSXP ? REAL(x) : 0 )
+    {}
+
+    inline double operator[]( int i ) const {
+        if( reals ) return reals[i] ;
+        return ints[i] == NA_INTEGER ? NA_REAL : ints[i] ;
+    }
+
+    static bool accepts( SEXP x ){
+        int type = TYPEOF(x) ;
+        return ( type == LGLSXP || type == INTSXP || type == REALSXP ) &&
+            Rf_isNull( Rf_getAttrib( x, R_ClassSymbol ) ) ;
+    }
+
+private:
+    const int* ints ;
+    const double* reals ;
+} ;
+
+// the rows of the sorted column key whose values are values, found by
+// binary search. Only for bare numeric or logical vectors
+std::vector<int> sorted_lookup( SEXP column, SEXP values, bool in ){
+    NumericValues key( column ), value( values ) ;
+    comparisons<REALSXP> compare ;
+    int n = Rf_length(column), nvalues = Rf_length(values) ;
+    std::vector< std::pair<int,int> > runs ;
+    for( int k=0; k<nvalues; k++){
+        double v = value[k] ;
+        // key == NA is never TRUE, but NA %in% NA is
+        if( !in && ISNAN(v) ) continue ;
+
+        int lo = 0, hi = n ;
+        while( lo < hi ){
+            int mid = lo + ( hi - lo ) / 2 ;
+            if( compare.is_less( key[mid], v ) ) lo = mid + 1 ; else hi = mid ;
+        }
+        int start = lo ;
+        hi = n ;
+        while( lo < hi ){
+            int mid = lo + ( hi - lo ) / 2 ;
+            if( compare.is_less( v, key[mid] ) ) hi = mid ; else lo = mid + 1 ;
+        }
+        if( lo > start ) runs.push_back( std::make_pair( start, lo ) ) ;
+    }
+
+    // the rows in their order, each run once
+    std::sort( runs.begin(), runs.end() ) ;
+    std::vector<int> indices ;
+    for( size_t r=0; r<runs.size(); r++){
+        if( r > 0 && runs[r].first == runs[r-1].first ) continue ;
+        for( int i=runs[r].first; i<runs[r].second; i++) indices.push_back(i) ;
+    }
+    return indices ;
+}
+
+// whether x[i] is NA, or NaN
+inline bool is_na_value( SEXP x, int i ){
+    switch( TYPEOF(x) ){
+    case LGLSXP:
+    case INTSXP: return INTEGER(x)[i] == NA_INTEGER ;
+    case REALSXP: return ISNAN( REAL(x)[i] ) ;
+    case STRSXP: return STRING_ELT(x, i) == NA_STRING ;
+    default: break ;
+    }
+    return false ;
+}
+
+// the rows of the hash index on a single column whose values are values
+std::vector<int> indexed_lookup( HashIndex& index, SEXP values, bool in ){
+    int nvalues = Rf_length(values) ;
+    std::vector<int> indices ;
+    dplyr_hash_set<int> found ;
+    for( int k=0; k<nvalues; k++){
+        // key == NA is never TRUE, but NA %in% NA is
+        if( !in && is_na_value( values, k ) ) continue ;
+        const std::vector<int>* match = index.find(k) ;
+        if( !match || !found.insert( match->front() ).second ) continue ;
+        indices.insert( indices.end(), match->begin(), match->end() ) ;
+    }
+    std::sort( indices.begin(), indices.end() ) ;
+    return indices ;
+}
+
+// values of the other numeric type than the key column, converted to its
+// type when that does not change them, e.g. 2 for an integer key, so that
+// they can probe its index. values otherwise
+SEXP as_key_type( SEXP key, SEXP values ){
+    if( TYPEOF(key) == TYPEOF(values) || !NumericValues::accepts(key) || !NumericValues::accepts(values) ) return values ;
+    if( TYPEOF(key) == REALSXP && TYPEOF(values) == INTSXP ) return Rf_coerceVector( values, REALSXP ) ;
+    if( TYPEOF(key) != INTSXP || TYPEOF(values) != REALSXP ) return values ;
+
+    const double* x = REAL(values) ;
+    int n = Rf_length(values) ;
+    for( int i=0; i<n; i++){
+        if( R_IsNA(x[i]) ) continue ;
+        // NaN is not NA, and has no integer
+        if( ISNAN(x[i]) || x[i] != floor(x[i]) || x[i] > INT_MAX || x[i] <= INT_MIN ) return values ;
+    }
+    return Rf_coerceVector( values, INTSXP ) ;
+}
+
+// filter(data, key == value) and filter(data, key %in% values) when data has
+// a hash index on key, or is sorted by key: the rows of each value are looked
+// up instead of comparing every row. R_NilValue otherwise, and when the
+// values were evaluated, evaluated is the condition with the values in place
+// of their expression, so that the filter does not evaluate them again
+SEXP filter_lookup( const DataFrame& df, const Lazy& lazy, const SymbolSet& set, RObject& evaluated ){
+    SEXP expr = lazy.expr() ;
+    if( TYPEOF(expr) != LANGSXP || Rf_length(expr) != 3 ) return R_NilValue ;
+    bool in = CAR(expr) == Rf_install("%in%") ;
+    if( !in && CAR(expr) != Rf_install("==") ) return R_NilValue ;
+    SEXP lhs = CADR(expr), rhs = CADDR(expr) ;
+    if( TYPEOF(lhs) != SYMSXP || !set.count(lhs) || uses_data( rhs, set ) ) return R_NilValue ;
+
+    const char* name = CHAR(PRINTNAME(lhs)) ;
+    SEXP column = df[ std::string(name) ] ;
+    HashIndex* index = hash_index( df ) ;
+    if( index && ( index->keys().size() != 1 || strcmp( CHAR(STRING_ELT(index->keys(), 0)), name ) ) ){
+        index = 0 ;
+    }
+    bool sorted = false ;
+    if( NumericValues::accepts(column) ){
+        CharacterVector keys = sorted_keys().get( df ) ;
+        sorted = keys.size() && !strcmp( CHAR(STRING_ELT(keys, 0)), name ) ;
+    }
+    if( !index && !sorted ) return R_NilValue ;
+
+    Shield<SEXP> values( Rf_eval( rhs, lazy.env() ) ) ;
+    evaluated = Rcpp_lang3( CAR(expr), lhs, values ) ;
+    if( !in && Rf_length(values) != 1 ) return R_NilValue ;
+    Shield<SEXP> keys( index ? as_key_type( column, values ) : (SEXP)values ) ;
+    if( index && !index->probe( std::vector<SEXP>( 1, (SEXP)keys ) ) ) index = 0 ;
+    if( !index && !( sorted && NumericValues::accepts(values) ) ) return R_NilValue ;
+    evaluated = R_NilValue ;
+
+    ProfiledPhase phase( "filter", "evaluate", df.nrows(), 1 ) ;
+    phase.set_expr( R_NilValue, expr ) ;
+    std::vector<int> indices ;
+    if( index ){
+        phase.set_handler( "index" ) ;
+        indices = indexed_lookup( *index, keys, in ) ;
+    } else {
+        phase.set_handler( "sorted" ) ;
+        indices = sorted_lookup( column, values, in ) ;
+    }
+
+    DataFrame res = DataFrameSubsetVisitors(df, df.names()).subset( indices, classes_not_grouped() ) ;
+    sorted_keys().keep( df, res ) ;
+    phase.done() ;
+    return res ;
+}
+
 DataFrame filter_not_grouped( DataFrame df, const LazyDots& dots){
     CharacterVector names = df.names() ;
     SymbolSet set ;
     for( int i=0; i<names.size(); i++){
         set.insert( Rf_installChar( names[i] ) ) ;
     }
+    RObject evaluated ;
+    if( dots.size() == 1 ){
+        SEXP res = filter_lookup( df, dots[0], set, evaluated ) ;
+        if( !Rf_isNull(res) ) return res ;
+    }
     if( dots.single_env() ){
         Environment env = dots[0].env() ;
         // a, b, c ->  a & b & c
-        Shield<SEXP> call( and_calls( dots, set, env ) ) ;
+        Shield<SEXP> call( Rf_isNull(evaluated) ? and_calls( dots, set, env ) : (SEXP)evaluated ) ;
 
         // replace the symbols that are in the data frame by vectors from the data frame
         // and evaluate the expression
         CallProxy proxy( (SEXP)call, df, env ) ;
-        LogicalVector test = check_filter_logical_result(proxy.eval()) ;
+        LogicalVector test ;
+        {
+            ProfiledPhase phase( "filter", "evaluate", df.nrows(), 1 ) ;
+            phase.set_expr( R_NilValue, call ) ;
+            test = check_filter_logical_result(proxy.eval()) ;
+            phase.set_result( test ) ;
+            phase.done() ;
+        }
 
         if( test.size() == 1){
             if( test[0] == TRUE ){
@@ -232,14 +507,24 @@ DataFrame filter_not_grouped( DataFrame df, const LazyDots& dots){
             }
         } else {
             check_filter_result(test, df.nrows());
-            return subset(df, test, classes_not_grouped() ) ;
+            ProfiledPhase subset_phase( "filter", "subset", df.nrows(), 1 ) ;
+            DataFrame res = subset(df, test, classes_not_grouped() ) ;
+            sorted_keys().keep( df, res ) ;
+            subset_phase.done() ;
+            return res ;
         }
     } else {
         int nargs = dots.size() ;
 
         Call call(dots[0].expr());
         CallProxy first_proxy(call, df, dots[0].env() ) ;
-        LogicalVector test = check_filter_logical_result(first_proxy.eval()) ;
+        LogicalVector test ;
+        {
+            ProfiledPhase phase( "filter", "evaluate", df.nrows(), 1 ) ;
+            phase.set_expr( R_NilValue, call ) ;
+            test = check_filter_logical_result(first_proxy.eval()) ;
+            phase.done() ;
+        }
         if( test.size() == 1 ) {
             if( !test[0] ){
                 return empty_subset(df, df.names(), classes_not_grouped() ) ;
@@ -253,13 +538,20 @@ DataFrame filter_not_grouped( DataFrame df, const LazyDots& dots){
 
             Call call( dots[i].expr() ) ;
             CallProxy proxy(call, df, dots[i].env() ) ;
+            ProfiledPhase phase( "filter", "evaluate", df.nrows(), 1 ) ;
+            phase.set_expr( R_NilValue, call ) ;
             LogicalVector test2 = check_filter_logical_result(proxy.eval()) ;
-            if( combine_and(test, test2) ){
+            bool empty = combine_and(test, test2) ;
+            phase.done() ;
+            if( empty ){
                 return empty_subset(df, df.names(), classes_not_grouped() ) ;
             }
         }
 
+        ProfiledPhase subset_phase( "filter", "subset", df.nrows(), 1 ) ;
         DataFrame res = subset( df, test, classes_not_grouped() ) ;
+        sorted_keys().keep( df, res ) ;
+        subset_phase.done() ;
         return res ;
     }
 }
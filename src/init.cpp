@@ -30,6 +30,7 @@ SEXP get_time_classes(){
 
 extern "C" void R_init_dplyr( DllInfo* info ){
     DPLYR_REGISTER(build_index_cpp)
+    DPLYR_REGISTER(build_index_adj)
     DPLYR_REGISTER(registerHybridHandler)
 
     DPLYR_REGISTER(get_time_classes)
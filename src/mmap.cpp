@@ -0,0 +1,19 @@
+#include <dplyr.h>
+
+using namespace Rcpp ;
+using namespace dplyr ;
+
+// [[Rcpp::export]]
+XPtr<MappedTable> mapped_table( std::string dir, IntegerVector types, int nrows ){
+    return XPtr<MappedTable>( new MappedTable(dir, types, nrows), true ) ;
+}
+
+// [[Rcpp::export]]
+SEXP mapped_table_column( XPtr<MappedTable> table, int j, SEXP rows ){
+    return table->get( j - 1, rows ) ;
+}
+
+// [[Rcpp::export]]
+void write_mapped_column_impl( SEXP x, std::string dir, int j ){
+    write_mapped_column( x, MappedTable::column_path( dir, j - 1 ) ) ;
+}
@@ -0,0 +1,131 @@
+#include <dplyr.h>
+
+using namespace Rcpp ;
+using namespace dplyr ;
+
+template <typename Window>
+Result* roll_result( SEXP data, double n, SEXP along, bool na_rm, bool partial ){
+    switch( TYPEOF(data) ){
+        case INTSXP:  return new Roll<INTSXP, Window>( data, n, along, na_rm, partial ) ;
+        case REALSXP: return new Roll<REALSXP, Window>( data, n, along, na_rm, partial ) ;
+        default: break ;
+    }
+    return 0 ;
+}
+
+inline bool is_roll_numeric( SEXP x ){
+    return ( TYPEOF(x) == INTSXP || TYPEOF(x) == REALSXP ) && !Rf_inherits( x, "factor" ) ;
+}
+
+inline bool roll_logical_constant( SEXP x, bool& out ){
+    if( TYPEOF(x) != LGLSXP || LENGTH(x) != 1 || LOGICAL(x)[0] == NA_LOGICAL ) return false ;
+    out = LOGICAL(x)[0] ;
+    return true ;
+}
+
+// roll_*( x, n, along = NULL, na.rm = FALSE, partial = FALSE )
+// only handles the case where x and along are variables of the data and
+// n, na.rm and partial are constants, anything else is left to R
+template <typename Window>
+Result* roll_prototype( SEXP call, const LazySubsets& subsets, int nargs ){
+    if( nargs < 2 ) return 0 ;
+
+    SEXP data = R_NilValue, n = R_NilValue, along = R_NilValue ;
+    bool na_rm = false, partial = false ;
+
+    int position = 0 ;
+    for( SEXP p = CDR(call); p != R_NilValue; p = CDR(p) ){
+        SEXP tag = TAG(p) ;
+        SEXP arg = CAR(p) ;
+        if( tag == R_NilValue ){
+            switch( position++ ){
+                case 0: data = arg ; break ;
+                case 1: n = arg ; break ;
+                default: return 0 ;
+            }
+            continue ;
+        }
+        std::string argname = CHAR(PRINTNAME(tag)) ;
+        if( argname == "x" ){
+            data = arg ;
+        } else if( argname == "n" ){
+            n = arg ;
+        } else if( argmatch( "along", argname ) ){
+            along = arg ;
+        } else if( argmatch( "na.rm", argname ) ){
+            if( !roll_logical_constant( arg, na_rm ) ) return 0 ;
+        } else if( argmatch( "partial", argname ) ){
+            if( !roll_logical_constant( arg, partial ) ) return 0 ;
+        } else {
+            return 0 ;
+        }
+    }
+
+    if( TYPEOF(data) != SYMSXP || !subsets.count(data) || subsets.is_summary(data) ) return 0 ;
+    data = subsets.get_variable(data) ;
+    if( !is_roll_numeric(data) || OBJECT(data) ) return 0 ;
+
+    if( ( TYPEOF(n) != INTSXP && TYPEOF(n) != REALSXP ) || LENGTH(n) != 1 ) return 0 ;
+
+    if( !Rf_isNull(along) ){
+        if( TYPEOF(along) != SYMSXP || !subsets.count(along) || subsets.is_summary(along) ) return 0 ;
+        along = subsets.get_variable(along) ;
+        if( !is_roll_numeric(along) ) return 0 ;
+    }
+
+    return roll_result<Window>( data, as<double>(n), along, na_rm, partial ) ;
+}
+
+Result* roll_sum_prototype( SEXP call, const LazySubsets& subsets, int nargs ){
+    return roll_prototype<internal::RollSum>( call, subsets, nargs ) ;
+}
+
+Result* roll_mean_prototype( SEXP call, const LazySubsets& subsets, int nargs ){
+    return roll_prototype<internal::RollMean>( call, subsets, nargs ) ;
+}
+
+Result* roll_min_prototype( SEXP call, const LazySubsets& subsets, int nargs ){
+    return roll_prototype<internal::RollMin>( call, subsets, nargs ) ;
+}
+
+Result* roll_max_prototype( SEXP call, const LazySubsets& subsets, int nargs ){
+    return roll_prototype<internal::RollMax>( call, subsets, nargs ) ;
+}
+
+Result* roll_sd_prototype( SEXP call, const LazySubsets& subsets, int nargs ){
+    return roll_prototype<internal::RollSd>( call, subsets, nargs ) ;
+}
+
+// [[Rcpp::export]]
+NumericVector roll_impl( SEXP x, double n, SEXP along, bool na_rm, bool partial, std::string fun ){
+    if( !is_roll_numeric(x) ){
+        stop( "x must be an integer or numeric vector, not %s", Rf_type2char(TYPEOF(x)) ) ;
+    }
+    int nx = Rf_length(x) ;
+    if( !Rf_isNull(along) ){
+        if( !is_roll_numeric(along) ){
+            stop( "`along` must be a numeric, Date or POSIXct vector" ) ;
+        }
+        if( Rf_length(along) != nx ){
+            stop( "`along` must have the same length as x (%d), not %d", nx, Rf_length(along) ) ;
+        }
+    }
+
+    Result* res = 0 ;
+    if( fun == "sum" ){
+        res = roll_result<internal::RollSum>( x, n, along, na_rm, partial ) ;
+    } else if( fun == "mean" ){
+        res = roll_result<internal::RollMean>( x, n, along, na_rm, partial ) ;
+    } else if( fun == "min" ){
+        res = roll_result<internal::RollMin>( x, n, along, na_rm, partial ) ;
+    } else if( fun == "max" ){
+        res = roll_result<internal::RollMax>( x, n, along, na_rm, partial ) ;
+    } else if( fun == "sd" ){
+        res = roll_result<internal::RollSd>( x, n, along, na_rm, partial ) ;
+    } else {
+        stop( "unknown rolling function '%s'", fun ) ;
+    }
+
+    boost::scoped_ptr<Result> ptr(res) ;
+    return ptr->process( SlicingIndex(0, nx) ) ;
+}
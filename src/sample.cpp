@@ -0,0 +1,229 @@
+#include <dplyr.h>
+
+using namespace Rcpp ;
+using namespace dplyr ;
+
+// all draws come from R's RNG stream (the RNGScope is set up by the
+// generated wrapper) so that set.seed() gives reproducible samples
+
+// uniform integer in [0, n)
+inline int unif_index( int n ){
+    int i = (int)( unif_rand() * n ) ;
+    return i < n ? i : n - 1 ;
+}
+
+// random order for the k first values of x (Fisher-Yates)
+inline void shuffle( int* x, int k ){
+    for( int i=k-1; i>0; i--){
+        std::swap( x[i], x[ unif_index(i+1) ] ) ;
+    }
+}
+
+// k distinct positions out of n with Floyd's algorithm. Only k draws and
+// a set of size k, so this is the method of choice when k is small
+void sample_floyd( int n, int k, int* out ){
+    dplyr_hash_set<int> chosen ;
+    for( int j=n-k, m=0; j<n; j++, m++){
+        int t = unif_index(j+1) ;
+        if( !chosen.insert(t).second ){
+            chosen.insert(j) ;
+            t = j ;
+        }
+        out[m] = t ;
+    }
+    shuffle( out, k ) ;
+}
+
+// k distinct positions out of n with reservoir sampling, one pass and no
+// extra memory, used when k is a large fraction of n
+void sample_reservoir( int n, int k, int* out ){
+    for( int i=0; i<k; i++) out[i] = i ;
+    for( int i=k; i<n; i++){
+        int j = unif_index(i+1) ;
+        if( j < k ) out[j] = i ;
+    }
+    shuffle( out, k ) ;
+}
+
+void sample_replace( int n, int k, int* out ){
+    for( int i=0; i<k; i++) out[i] = unif_index(n) ;
+}
+
+// Walker's alias method (Vose's variant). O(n) setup and O(1) per weighted
+// draw with replacement. Only positive weights make it to the table
+class AliasTable {
+public:
+    AliasTable( const std::vector<int>& pos_, const std::vector<double>& w ) :
+        pos(pos_), n(pos_.size()), prob(n), alias(n)
+    {
+        double total = 0.0 ;
+        for( int i=0; i<n; i++) total += w[i] ;
+
+        std::vector<double> p(n) ;
+        std::vector<int> small, large ;
+        for( int i=0; i<n; i++){
+            p[i] = w[i] * n / total ;
+            if( p[i] < 1.0 ) small.push_back(i) ;
+            else large.push_back(i) ;
+        }
+        while( !small.empty() && !large.empty() ){
+            int s = small.back() ; small.pop_back() ;
+            int l = large.back() ;
+            prob[s] = p[s] ;
+            alias[s] = l ;
+            p[l] = ( p[l] + p[s] ) - 1.0 ;
+            if( p[l] < 1.0 ){
+                large.pop_back() ;
+                small.push_back(l) ;
+            }
+        }
+        // what remains only differs from 1 because of rounding
+        for( size_t i=0; i<large.size(); i++) prob[large[i]] = 1.0 ;
+        for( size_t i=0; i<small.size(); i++) prob[small[i]] = 1.0 ;
+    }
+
+    inline int draw() const {
+        int i = unif_index(n) ;
+        return pos[ unif_rand() < prob[i] ? i : alias[i] ] ;
+    }
+
+private:
+    const std::vector<int>& pos ;
+    int n ;
+    std::vector<double> prob ;
+    std::vector<int> alias ;
+} ;
+
+inline bool greater_key( const std::pair<double,int>& a, const std::pair<double,int>& b ){
+    return a.first > b.first ;
+}
+
+// weighted sampling without replacement (Efraimidis-Spirakis): the k
+// largest keys log(u)/w are a sample with the same distribution as k
+// successive weighted draws, in draw order once sorted
+void sample_weighted( const std::vector<int>& pos, const std::vector<double>& w, int k, int* out ){
+    int n = pos.size() ;
+    std::vector< std::pair<double,int> > keys(n) ;
+    for( int i=0; i<n; i++){
+        keys[i] = std::make_pair( ::log( unif_rand() ) / w[i], pos[i] ) ;
+    }
+    std::partial_sort( keys.begin(), keys.begin() + k, keys.end(), greater_key ) ;
+    for( int i=0; i<k; i++) out[i] = keys[i].second ;
+}
+
+class GroupSampler {
+public:
+    GroupSampler( bool replace_, SEXP weight_ ) :
+        replace(replace_),
+        weight( Rf_isNull(weight_) ? (double*)0 : REAL(weight_) )
+    {}
+
+    // writes k positions (relative to the group) in out
+    void sample( const SlicingIndex& index, int k, int* out ){
+        int n = index.size() ;
+        if( k > n && !replace ){
+            stop( "Sample size (%d) greater than population size (%d). Do you want replace = TRUE?", k, n ) ;
+        }
+        if( k == 0 ) return ;
+
+        if( weight ){
+            sample_weighted_group( index, k, out ) ;
+        } else if( replace ){
+            sample_replace( n, k, out ) ;
+        } else if( 4 * k < n ){
+            sample_floyd( n, k, out ) ;
+        } else {
+            sample_reservoir( n, k, out ) ;
+        }
+    }
+
+private:
+
+    void sample_weighted_group( const SlicingIndex& index, int k, int* out ){
+        int n = index.size() ;
+        pos.clear() ;
+        w.clear() ;
+        for( int i=0; i<n; i++){
+            double wi = weight[index[i]] ;
+            if( !R_FINITE(wi) ) stop( "Weights must not be missing or infinite" ) ;
+            if( wi < 0 ) stop( "Weights must all be greater than 0" ) ;
+            if( wi > 0 ){
+                pos.push_back(i) ;
+                w.push_back(wi) ;
+            }
+        }
+        int npos = pos.size() ;
+        if( npos == 0 || ( !replace && k > npos ) ){
+            stop( "too few positive probabilities" ) ;
+        }
+
+        if( replace ){
+            AliasTable table( pos, w ) ;
+            for( int i=0; i<k; i++) out[i] = table.draw() ;
+        } else {
+            sample_weighted( pos, w, k, out ) ;
+        }
+    }
+
+    bool replace ;
+    double* weight ;
+    std::vector<int> pos ;
+    std::vector<double> w ;
+} ;
+
+// [[Rcpp::export]]
+DataFrame sample_grouped_impl( DataFrame df, double size, bool frac, bool replace, SEXP weight ){
+    if( !Rf_isNull(weight) && TYPEOF(weight) != REALSXP ){
+        stop( "Weights must be numeric" ) ;
+    }
+
+    GroupedDataFrame gdf(df) ;
+    const DataFrame& data = gdf.data() ;
+    int ngroups = gdf.ngroups() ;
+
+    GroupSampler sampler( replace, weight ) ;
+
+    // the result index is built while sampling: group i gets a contiguous
+    // block of rows, so there is no need to hash the grouping variables again
+    std::vector<int> rows ;
+    rows.reserve( frac ? (int)( size * data.nrows() ) : (int)size * ngroups ) ;
+    std::vector<int> kept ; kept.reserve(ngroups) ;
+    std::vector<IntegerVector> indices ; indices.reserve(ngroups) ;
+    std::vector<int> group_sizes ; group_sizes.reserve(ngroups) ;
+    int biggest_group = 0 ;
+    std::vector<int> chunk ;
+
+    GroupedDataFrame::group_iterator git = gdf.group_begin() ;
+    for( int i=0; i<ngroups; i++, ++git){
+        const SlicingIndex& index = *git ;
+        int n = index.size() ;
+        int k = frac ? (int)Rf_fround( size * n, 0.0 ) : (int)size ;
+
+        chunk.resize(k) ;
+        sampler.sample( index, k, chunk.empty() ? 0 : &chunk[0] ) ;
+        if( k == 0 ) continue ;
+
+        int start = rows.size() ;
+        for( int j=0; j<k; j++) rows.push_back( index[chunk[j]] ) ;
+
+        kept.push_back(i) ;
+        indices.push_back( IntegerVector( seq( start, start + k - 1 ) ) ) ;
+        group_sizes.push_back(k) ;
+        biggest_group = std::max( biggest_group, k ) ;
+    }
+
+    DataFrame res = DataFrameSubsetVisitors(data, data.names()).subset( rows, classes_grouped<GroupedDataFrame>() ) ;
+
+    DataFrame labels = data.attr("labels") ;
+    if( (int)kept.size() < ngroups ){
+        labels = DataFrameSubsetVisitors(labels).subset( kept, "data.frame" ) ;
+    }
+
+    res.attr( "vars" ) = data.attr("vars") ;
+    res.attr( "drop" ) = data.attr("drop") ;
+    res.attr( "indices" ) = wrap(indices) ;
+    res.attr( "group_sizes" ) = wrap(group_sizes) ;
+    res.attr( "biggest_group_size" ) = biggest_group ;
+    res.attr( "labels" ) = labels ;
+    return res ;
+}
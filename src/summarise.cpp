@@ -26,6 +26,8 @@ SEXP summarise_grouped(const DataFrame& df, const LazyDots& dots){
         const Environment& env = lazy.env() ;
 
         Shield<SEXP> expr_(lazy.expr()) ; SEXP expr = expr_ ;
+        ProfiledPhase phase( "summarise", "evaluate", gdf.nrows(), gdf.ngroups() ) ;
+        phase.set_expr( lazy.name(), expr ) ;
         boost::scoped_ptr<Result> res( get_handler( expr, subsets, env ) );
 
         // if we could not find a direct Result
@@ -34,12 +36,15 @@ SEXP summarise_grouped(const DataFrame& df, const LazyDots& dots){
             res.reset( new GroupedCallReducer<Data, Subsets>( lazy.expr(), subsets, env) );
         }
         RObject result = res->process(gdf)  ;
+        phase.set_result( result ) ;
         results[i] = result ;
         accumulator.set( lazy.name(), result );
         subsets.input( lazy.name(), SummarisedVariable(result) ) ;
+        phase.done() ;
 
     }
 
+    ProfiledPhase structure( "summarise", "structure", gdf.nrows(), gdf.ngroups() ) ;
     List out = accumulator ;
     copy_most_attributes( out, df) ;
     out.names() = accumulator.names() ;
@@ -58,11 +63,20 @@ SEXP summarise_grouped(const DataFrame& df, const LazyDots& dots){
         out.attr( "biggest_group_size") = R_NilValue ;
 
         out.attr( "drop" ) = true ;
+
+        // one row per group, in the order of the groups: the remaining
+        // variables are still stored in runs of adjacent rows
+        if( Rf_inherits( df, "adj_grouped_df" ) ){
+            DataFrame res = build_index_adj( out, vars ) ;
+            structure.done() ;
+            return res ;
+        }
     } else {
         out.attr( "class" ) = classes_not_grouped()  ;
         SET_ATTRIB( out, strip_group_attributes(out) ) ;
     }
 
+    structure.done() ;
     return out ;
 }
 
@@ -81,6 +95,8 @@ SEXP summarise_not_grouped(DataFrame df, const LazyDots& dots){
         const Lazy& lazy = dots[i] ;
         Environment env = lazy.env() ;
         Shield<SEXP> expr_(lazy.expr()) ; SEXP expr = expr_ ;
+        ProfiledPhase phase( "summarise", "evaluate", df.nrows(), 1 ) ;
+        phase.set_expr( lazy.name(), expr ) ;
         boost::scoped_ptr<Result> res( get_handler( expr, subsets, env ) ) ;
         SEXP result ;
         if(res) {
@@ -91,8 +107,10 @@ SEXP summarise_not_grouped(DataFrame df, const LazyDots& dots){
         if( Rf_length(result) != 1 ){
             stop( "expecting result of length one, got : %d", Rf_length(result) ) ;
         }
+        phase.set_result( result ) ;
         accumulator.set(lazy.name(), result );
         subsets.input( lazy.name(), result ) ;
+        phase.done() ;
     }
     List data = accumulator ;
     copy_most_attributes(data, df) ;
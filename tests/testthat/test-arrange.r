@@ -160,3 +160,93 @@ test_that("arrange fails gracefully on matrix input (#1870)", {
   df <- data_frame(a = 1:3, b = 4:6)
   expect_error( arrange(df, is.na(df)), "matrix" )
 })
+
+test_that("string ranks are consistent when the string cache is reused", {
+  clear_string_cache()
+  df <- data_frame(x = c("b", "c", "a", NA, "c"), y = 1:5)
+  expect_equal(arrange(df, x)$y, c(3L, 1L, 2L, 5L, 4L))
+
+  # all strings cached, subset of the same strings, and new strings
+  expect_equal(arrange(df, desc(x))$y, c(2L, 5L, 1L, 3L, 4L))
+  expect_equal(arrange(df[c(1, 3), ], x)$y, c(3L, 1L))
+  df2 <- data_frame(x = c("c", "ab", "a"), y = 1:3)
+  expect_equal(arrange(df2, x)$y, c(3L, 2L, 1L))
+  expect_equal(arrange(df, x)$y, c(3L, 1L, 2L, 5L, 4L))
+
+  expect_true(clear_string_cache() > 0)
+  expect_equal(clear_string_cache(), 0L)
+})
+
+test_that("arrange records the leading ascending variables it sorts by", {
+  df <- data_frame(x = c(2, 1, 2, 1), y = 4:1, z = letters[1:4])
+  expect_equal(sorted_vars(arrange(df, x, y)), c("x", "y"))
+  expect_equal(sorted_vars(arrange(df, x, desc(y), z)), "x")
+  expect_equal(sorted_vars(arrange(df, x + 1, y)), character())
+  expect_equal(sorted_vars(df), character())
+
+  # the attribute alone is not trusted
+  res <- arrange(df, x, y)
+  expect_equal(sorted_vars(res[4:1, ]), character())
+
+  expect_error(sorted_by(df, y), "not sorted")
+  expect_equal(sorted_vars(sorted_by(df[4:1, ], y)), "y")
+  expect_equal(sorted_vars(sorted_by(res)), character())
+})
+
+test_that("sorted variables are not recorded on data tables", {
+  df <- data_frame(x = c(2, 1, 3), y = 1:3)
+  expect_equal(attr(arrange(df, x), "dplyr_sorted"), "x")
+  expect_null(attr(arrange(df, x), "sorted"))
+
+  dt <- structure(df[c(2, 1, 3), ], class = c("data.table", "data.frame"))
+  res <- sorted_by(dt, x)
+  expect_null(attr(res, "dplyr_sorted"))
+  expect_null(attr(res, "sorted"))
+  attr(dt, "dplyr_sorted") <- "x"
+  expect_equal(sorted_vars(dt), character())
+})
+
+test_that("verbs on sorted data give the results of unsorted data", {
+  df <- data_frame(
+    k = c(3L, NA, 1L, 2L, 2L, 5L, 1L),
+    v = c(NaN, 2, NA, 1, 1, 3, NA),
+    i = 1:7
+  )
+  by_k <- arrange(df, k)
+  by_v <- arrange(df, v)
+  plain <- sorted_by(by_k)
+
+  expect_equal(filter(by_k, k == 2L)$i, filter(plain, k == 2L)$i)
+  expect_equal(filter(by_k, k == 2.5)$i, integer())
+  expect_equal(filter(by_k, k == NA)$i, integer())
+  expect_equal(filter(by_k, k %in% c(5, NA, 1, 1))$i, filter(plain, k %in% c(5, NA, 1, 1))$i)
+  expect_equal(filter(by_v, v %in% c(NaN, 1))$i, c(4L, 5L, 1L))
+  expect_equal(filter(by_v, v %in% NA)$i, c(3L, 7L))
+  expect_equal(sorted_vars(filter(by_k, k %in% 1:2)), "k")
+
+  expect_equal(group_size(group_by(by_k, k)), group_size(group_by(plain, k)))
+  expect_equal(attr(group_by(by_k, k), "labels"), attr(group_by(plain, k), "labels"))
+
+  y <- data_frame(k = c(1L, 2L, 2L, 4L, NA), w = 1:5)
+  sorted_y <- arrange(y, k)
+  expect_equal(inner_join(by_k, sorted_y, by = "k"), inner_join(plain, y, by = "k"))
+  expect_equal(left_join(by_k, sorted_y, by = "k"), left_join(plain, y, by = "k"))
+  expect_equal(left_join(by_k, sorted_y, by = "k")$w, c(1L, 1L, 2L, 3L, 2L, 3L, NA, NA, 5L))
+})
+
+test_that("sorted variables are remembered without the group index cache", {
+  old <- options(dplyr.group_index_cache_size = 0)
+  on.exit(options(old))
+
+  df <- arrange(data_frame(x = c(3, 1, 2, 2), y = 1:4), x)
+  res <- filter(df, y > 1)
+  expect_equal(sorted_vars(res), "x")
+  expect_equal(filter(res, x == 2)$y, 3:4)
+
+  stale <- data_frame(x = c(2, 1, 2, 3), y = 1:4)
+  attr(stale, "dplyr_sorted") <- "x"
+  res <- filter(stale, y > 0)
+  expect_equal(attr(res, "dplyr_sorted"), "x")
+  expect_equal(sorted_vars(res), character())
+  expect_equal(filter(res, x == 2)$y, c(1L, 3L))
+})
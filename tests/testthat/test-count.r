@@ -49,3 +49,18 @@ test_that("n_distinct treats NA correctly in the REALSXP case (#384)", {
   expect_equal( n_distinct( c(1.0,NA,NA) ), 2 )
 })
 
+
+test_that("n_distinct counts dense and sparse integer values alike", {
+  df <- data.frame(
+    g = c(1, 1, 2, 2, 2),
+    x = c(3L, NA, 3L, 1e8L, 1L),
+    f = factor(c("b", NA, "a", "b", "b"))
+  )
+  expect_equal(n_distinct(df$x), 4L)
+  expect_equal(n_distinct(df$x[-4]), 3L)
+  expect_equal(n_distinct(df$f, na.rm = TRUE), 2L)
+
+  res <- summarise(group_by(df, g), x = n_distinct(x), f = n_distinct(f, na.rm = TRUE))
+  expect_equal(res$x, c(2L, 3L))
+  expect_equal(res$f, c(1L, 2L))
+})
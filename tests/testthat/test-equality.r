@@ -118,3 +118,18 @@ test_that("numeric and integer can be compared if convert = TRUE", {
   expect_match(all.equal(df1, df2), "Incompatible")
   expect_true(all.equal(df1, df2, convert = TRUE))
 })
+
+test_that("equality reports rows that differ, and rows in a different order", {
+  df1 <- data_frame(x = c(1L, 2L, 2L, 3L), y = c("a", "b", "b", "c"))
+
+  expect_true(all_equal(df1, df1, ignore_row_order = FALSE))
+  expect_true(all_equal(df1, df1[4:1, ]))
+  expect_equal(
+    all_equal(df1, df1[4:1, ], ignore_row_order = FALSE),
+    "Same row values, but different order"
+  )
+
+  df2 <- data_frame(x = c(1L, 2L, 3L, 4L), y = c("a", "b", "c", "d"))
+  expect_match(all_equal(df1, df2), "Rows in y but not x: 4")
+  expect_match(all_equal(df1, df2), "Rows with difference occurences in x and y: 2")
+})
@@ -389,3 +389,15 @@ test_that("filter fails gracefully on raw columns (#1803)", {
   expect_error( filter(df, a == 1), "unsupported type" )
   expect_error( filter(df, b == 1), "unsupported type" )
 })
+
+test_that("grouped filter evaluates elementwise conditions once", {
+  df <- group_by(data_frame(g = rep(1:4, each = 2), x = 1:8), g)
+  res <- profile_verbs(filter(df, x %in% c(2, 3, 8), x > 2))
+  expect_equal(res$x, c(3L, 8L))
+  expect_equal(res$g, c(2L, 4L))
+
+  evaluated <- last_profile()
+  evaluated <- evaluated[evaluated$phase == "evaluate", ]
+  expect_equal(evaluated$handler, "elementwise")
+  expect_equal(evaluated$callbacks, 1L)
+})
@@ -256,3 +256,122 @@ test_that("rowwise fails gracefully on raw columns (#1803)", {
   df <- data_frame(a = 1:3, b = as.raw(1:3))
   expect_error( rowwise(df), "unsupported type" )
 })
+
+test_that("group_by_sorted gives the same results as group_by", {
+  df <- arrange(mtcars, cyl, gear)
+  g1 <- group_by(df, cyl, gear)
+  g2 <- group_by_sorted(df, cyl, gear)
+
+  expect_is( g2, "adj_grouped_df" )
+  expect_null( attr(g2, "indices") )
+  expect_equal( group_size(g2), group_size(g1) )
+  expect_equal( n_groups(g2), n_groups(g1) )
+
+  expect_equal(
+    summarise(g2, n = n(), disp = mean(disp)) %>% ungroup,
+    summarise(g1, n = n(), disp = mean(disp)) %>% ungroup
+  )
+  expect_equal(
+    mutate(g2, z = disp - mean(disp))$z,
+    mutate(g1, z = disp - mean(disp))$z
+  )
+  expect_equal(
+    filter(g2, disp == max(disp)) %>% ungroup,
+    filter(g1, disp == max(disp)) %>% ungroup
+  )
+  expect_equal(
+    do(g2, head(., 1)) %>% ungroup,
+    do(g1, head(., 1)) %>% ungroup
+  )
+})
+
+test_that("adjacent grouping is kept by filter, mutate and summarise", {
+  df <- data_frame(g = rep(1:3, c(3, 2, 4)), h = rep(1:2, c(5, 4)), x = 1:9)
+  g <- group_by_sorted(df, h, g)
+
+  res <- filter(g, x > 2)
+  expect_is( res, "adj_grouped_df" )
+  expect_equal( group_size(res), c(1L, 2L, 4L) )
+  expect_equal( attr(res, "labels")$g, 1:3 )
+
+  res <- filter(g, x > 3)
+  expect_equal( group_size(res), c(2L, 4L) )
+  expect_equal( attr(res, "labels")$g, 2:3 )
+
+  expect_is( mutate(g, y = x * 2), "adj_grouped_df" )
+
+  res <- summarise(g, x = sum(x))
+  expect_is( res, "adj_grouped_df" )
+  expect_equal( group_size(res), c(2L, 1L) )
+})
+
+test_that("arrange keeps adjacent grouping only when sorted by the groups", {
+  df <- data_frame(g = rep(1:3, c(3, 2, 4)), x = c(3:1, 2:1, 4:1))
+  g <- group_by_sorted(df, g)
+
+  res <- arrange(g, desc(g), x)
+  expect_is( res, "adj_grouped_df" )
+  expect_equal( group_size(res), c(4L, 2L, 3L) )
+
+  res <- arrange(g, x)
+  expect_false( inherits(res, "adj_grouped_df") )
+  expect_equal( group_size(res), c(3L, 2L, 4L) )
+})
+
+test_that("grouping the same columns again reuses their index", {
+  old <- options(dplyr.group_index_cache_size = 16)
+  on.exit(options(old))
+  clear_group_index_cache()
+  df <- data_frame(g = rep(c("b", "a", "c"), 10), h = rep(1:2, 15), x = 1:30)
+  by_g <- group_by(df, g, h)
+
+  profile_verbs(again <- group_by(ungroup(by_g), g, h))
+  prof <- last_profile()
+  expect_equal(prof$handler[prof$phase == "index"], "cache")
+  expect_identical(attr(again, "indices"), attr(by_g, "indices"))
+  expect_identical(attr(again, "labels"), attr(by_g, "labels"))
+
+  # other variables, or modified columns, have their own index
+  profile_verbs(by_h <- group_by(df, h))
+  prof <- last_profile()
+  expect_true(is.na(prof$handler[prof$phase == "index"]))
+
+  df$g[1] <- "z"
+  res <- group_by(df, g, h)
+  expect_equal(n_groups(res), n_groups(by_g) + 1L)
+
+  expect_true(clear_group_index_cache() > 0)
+})
+
+test_that("the group index cache is off by default", {
+  old <- options(dplyr.group_index_cache_size = NULL)
+  on.exit(options(old))
+  clear_group_index_cache()
+  by_g <- group_by(data_frame(g = c(2, 1, 2)), g)
+  expect_equal(clear_group_index_cache(), 0L)
+})
+
+test_that("the group index is kept by saveRDS() and readRDS()", {
+  by_g <- group_by(data_frame(g = c(2, 1, 2, 3), x = 1:4), g)
+  path <- tempfile()
+  on.exit(unlink(path))
+  saveRDS(by_g, path)
+  res <- readRDS(path)
+  expect_identical(attr(res, "indices"), attr(by_g, "indices"))
+  expect_equal(summarise(res, x = sum(x))$x, c(2L, 4L, 4L))
+})
+
+test_that("dense integer and factor keys are grouped in the order of the labels", {
+  df <- data.frame(k = c(3L, NA, 1L, 3L, 1L), f = factor(c("b", "a", NA, "b", "c")))
+
+  by_k <- group_by(df, k)
+  expect_equal(attr(by_k, "labels")$k, c(1L, 3L, NA))
+  expect_equal(attr(by_k, "indices"), list(c(2L, 4L), c(0L, 3L), 1L))
+
+  by_f <- group_by(df, f)
+  expect_equal(as.character(attr(by_f, "labels")$f), c("a", "b", "c", NA))
+  expect_equal(group_size(by_f), c(1L, 2L, 1L, 1L))
+
+  expect_equal(distinct(df, k)$k, c(3L, NA, 1L))
+  expect_equal(as.character(distinct(df, f)$f), c("b", "a", NA, "c"))
+})
@@ -597,3 +597,111 @@ test_that( "left_join handles mix of encodings in column names (#1571)", {
   expect_equal( res[["l\u00f8penummer"]], 1:6)
 
 })
+
+test_that("string keys in different encodings match", {
+  utf8 <- c("\u00e9l\u00e8ve", "b", NA, "\u00e9l\u00e8ve")
+  latin1 <- iconv(utf8, from = "UTF-8", to = "latin1")
+  x <- data_frame(k = utf8, x = 1:4)
+  y <- data_frame(k = latin1[c(1, 2, 3)], y = 1:3)
+
+  res <- left_join(x, y, by = "k")
+  expect_equal( res$y, c(1L, 2L, 3L, 1L) )
+  expect_equal( res$k, utf8 )
+
+  res <- inner_join(y, x, by = "k")
+  expect_equal( nrow(res), 4L )
+  expect_equal( sort(res$x), 1:4 )
+
+  x$k <- factor(x$k)
+  res <- suppressWarnings(left_join(x, y, by = "k"))
+  expect_equal( res$y, c(1L, 2L, 3L, 1L) )
+  expect_equal( res$k, utf8 )
+})
+
+test_that("joins and filters on an indexed table give the results of the hash join", {
+  x <- data_frame(k = c(3L, 1L, NA, 2L, 3L, 5L), x = 1:6)
+  y <- data_frame(k = c(2L, 3L, 1L, 3L, NA), y = 1:5)
+  indexed <- index_by(y, k)
+  expect_equal(indexed_vars(indexed), "k")
+  expect_equal(indexed_vars(y), character())
+
+  expect_equal(inner_join(x, indexed, by = "k"), inner_join(x, y, by = "k"))
+  expect_equal(left_join(x, indexed, by = "k"), left_join(x, y, by = "k"))
+  expect_equal(semi_join(x, indexed, by = "k")$x, semi_join(x, y, by = "k")$x)
+  expect_equal(semi_join(indexed, x, by = "k")$y, semi_join(y, x, by = "k")$y)
+
+  expect_equal(filter(indexed, k == 3L)$y, c(2L, 4L))
+  expect_equal(filter(indexed, k == NA_integer_)$y, integer())
+  expect_equal(filter(indexed, k %in% c(NA, 1L, 3L, 1L))$y, c(2L, 3L, 4L, 5L))
+  # whole numbers of another type use the index too
+  res <- profile_verbs(filter(indexed, k == 3))
+  expect_equal(res$y, c(2L, 4L))
+  expect_equal(last_profile()$handler[last_profile()$phase == "evaluate"], "index")
+  expect_equal(filter(indexed, k %in% c(1, NA, 2.5))$y, c(3L, 5L))
+
+  # the values are evaluated once, even when the index can not be used
+  calls <- 0
+  value <- function(x) {
+    calls <<- calls + 1
+    x
+  }
+  expect_equal(filter(indexed, k == value(2.5))$y, integer())
+  expect_equal(filter(indexed, k %in% value(c(1, 3)))$y, c(2L, 3L, 4L))
+  expect_equal(calls, 2)
+
+  # the index belongs to the columns it was built from
+  modified <- indexed
+  modified$k[1] <- 4L
+  expect_equal(indexed_vars(modified), character())
+  expect_equal(filter(modified, k == 4L)$y, 1L)
+  expect_equal(indexed_vars(indexed), "k")
+})
+
+test_that("indexed string keys match strings in other encodings", {
+  utf8 <- "\u00e9"
+  latin1 <- iconv(utf8, "UTF-8", "latin1")
+  y <- index_by(data_frame(k = c("a", utf8), y = 1:2), k)
+  x <- data_frame(k = c(latin1, "b", "a"), x = 1:3)
+
+  expect_equal(left_join(x, y, by = "k")$y, c(2L, NA, 1L))
+  expect_equal(filter(y, k == latin1)$y, 2L)
+  expect_error(index_by(data_frame(f = factor("a")), f), "cannot index")
+})
+
+test_that("joins by dense integer keys match joins by character keys", {
+  x <- data.frame(k = c(3L, NA, 1L, 7L, 3L), x = 1:5)
+  y <- data.frame(k = c(1L, 3L, 3L, NA, 5L), y = 1:5)
+  chr <- function(df) mutate(df, k = as.character(k))
+  int <- function(df) mutate(df, k = as.integer(k))
+
+  check <- function(x, y) {
+    for (join in list(inner_join, left_join, right_join, full_join, semi_join)) {
+      expect_equal(join(x, y, by = "k"), int(join(chr(x), chr(y), by = "k")))
+    }
+    expect_equal(sort(anti_join(x, y, by = "k")$x), 4L)
+  }
+  check(x, y)
+
+  # keys too sparse to be indexed by value are hashed
+  x$k[4] <- 1e8L
+  y$k[5] <- -1e8L
+  check(x, y)
+})
+
+test_that("joins by several whole number keys match joins by character keys", {
+  x <- data.frame(a = c(1L, 2L, NA, 2L), b = c(10, 20, 30, NA), x = 1:4)
+  y <- data.frame(a = c(2L, 1L, NA, 2L, 3L), b = c(20, 10, 30, NA, 10), y = 1:5)
+  chr <- function(df) mutate(df, a = as.character(a), b = as.character(b))
+
+  for (join in list(inner_join, left_join, right_join, full_join, semi_join)) {
+    res <- join(x, y, by = c("a", "b"))
+    expect_equal(chr(res), join(chr(x), chr(y), by = c("a", "b")))
+  }
+  expect_equal(nrow(anti_join(x, y, by = c("a", "b"))), 0L)
+
+  keys_x <- x[c("a", "b")]
+  keys_y <- y[c("a", "b")]
+  expect_equal(nrow(intersect(keys_x, keys_y)), 4L)
+  expect_equal(nrow(union(keys_x, keys_y)), 5L)
+  expect_equal(setdiff(keys_y, keys_x)$a, 3L)
+})
@@ -593,3 +593,19 @@ test_that("mutate fails gracefully on raw columns (#1803)", {
   expect_error( mutate(df, b = 1), 'Unsupported type RAWSXP for column "b"' )
   expect_error( mutate(df, c = 1), 'Unsupported type RAWSXP for column "b"' )
 })
+
+test_that("grouped mutate evaluates elementwise expressions once", {
+  df <- group_by(data_frame(g = rep(1:4, each = 2), x = 1:8), g)
+  res <- profile_verbs(mutate(df, y = x * 2, z = abs(y - 9) > 3, m = x - mean(x)))
+  expect_equal(res$y, (1:8) * 2)
+  expect_equal(res$z, abs((1:8) * 2 - 9) > 3)
+  expect_equal(res$m, rep(c(-0.5, 0.5), 4))
+
+  prof <- last_profile()
+  evaluated <- prof[prof$verb == "mutate" & prof$phase == "evaluate", ]
+  expect_equal(evaluated$handler, c("elementwise", "elementwise", "R"))
+  expect_equal(evaluated$callbacks[1:2], c(1L, 1L))
+
+  log <- function(x) x
+  expect_equal(mutate(df, y = log(x))$y, 1:8)
+})
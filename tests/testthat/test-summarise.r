@@ -653,3 +653,89 @@ test_that("summarise fails gracefully on raw columns (#1803)", {
   df <- data_frame(a = 1:3, b = as.raw(1:3))
   expect_error( summarise(df, c = b[[1]]), 'Unsupported type RAWSXP for column "c"' )
 })
+
+test_that("hybrid reducers agree on contiguous and scattered groups", {
+  df <- data_frame(
+    g = rep(1:3, c(4, 1, 5)),
+    x = c(1, NA, 3, 4, 5, 6, 7, NA, 9, 10),
+    y = c(1L, 2L, NA, 4L, 5L, 6L, 7L, 8L, 9L, 10L)
+  )
+  f <- function(data) {
+    summarise(data,
+      mx = mean(x, na.rm = TRUE), sx = sum(x, na.rm = TRUE),
+      vx = var(x, na.rm = TRUE), dx = sd(x),
+      my = mean(y), sy = sum(y), vy = var(y, na.rm = TRUE)
+    )
+  }
+  expect_equal(f(group_by_sorted(df, g)), f(group_by(df, g)))
+  expect_equal(f(df), f(group_by(mutate(df, h = 1L), h)) %>% select(-h))
+})
+
+test_that("profile_verbs() records how expressions were evaluated", {
+  df <- group_by(data_frame(g = rep(1:3, each = 2), x = 1:6), g)
+  res <- profile_verbs(summarise(df, m = mean(x), u = length(unique(x))))
+  expect_equal(res$m, c(1.5, 3.5, 5.5))
+
+  prof <- last_profile()
+  expect_is(prof, "tbl_df")
+  evaluated <- prof[prof$verb == "summarise" & prof$phase == "evaluate", ]
+  expect_equal(evaluated$name, c("m", "u"))
+  expect_equal(evaluated$handler, c("hybrid", "R"))
+  expect_equal(evaluated$callbacks[1], 0L)
+  expect_true(evaluated$callbacks[2] >= 3L)
+  expect_equal(evaluated$groups, c(3L, 3L))
+
+  summarise(df, m = mean(x))
+  expect_equal(last_profile(), prof)
+})
+
+test_that("profile_verbs() does not record phases left by an error", {
+  df <- data_frame(x = 1:3)
+  expect_error(profile_verbs(summarise(df, m = mean(x), s = stop("boom"))), "boom")
+  prof <- last_profile()
+  expect_equal(prof$name[prof$phase == "evaluate"], "m")
+  expect_false("structure" %in% prof$phase)
+})
+
+test_that("hybrid reducers handle constant columns", {
+  df <- data_frame(g = rep(1:3, c(2, 3, 1)), i = 7L, d = 2.5, n = NA_real_, s = "a")
+  gdf <- group_by(df, g)
+  res <- summarise(gdf,
+    si = sum(i), mi = mean(i), sd = sum(d), md = mean(d),
+    sn = sum(n), sn_rm = sum(n, na.rm = TRUE), mn_rm = mean(n, na.rm = TRUE),
+    ds = n_distinct(s), dn = n_distinct(n), dn_rm = n_distinct(n, na.rm = TRUE)
+  )
+  expect_equal(res$si, c(14L, 21L, 7L))
+  expect_equal(res$mi, c(7, 7, 7))
+  expect_equal(res$sd, c(5, 7.5, 2.5))
+  expect_equal(res$md, c(2.5, 2.5, 2.5))
+  expect_equal(res$sn, rep(NA_real_, 3))
+  expect_equal(res$sn_rm, c(0, 0, 0))
+  expect_equal(res$mn_rm, rep(NaN, 3))
+  expect_equal(res$ds, c(1L, 1L, 1L))
+  expect_equal(res$dn, c(1L, 1L, 1L))
+  expect_equal(res$dn_rm, c(0L, 0L, 0L))
+
+  big <- group_by(data_frame(g = rep(1:2, each = 2), i = .Machine$integer.max), g)
+  expect_warning(res <- summarise(big, s = sum(i)), "integer overflow")
+  expect_equal(res$s, c(NA_integer_, NA_integer_))
+})
+
+test_that("hybrid reductions of many rows give the same results with several threads", {
+  n <- 3e5
+  df <- data_frame(x = c(NA, seq_len(n - 1) / 7), i = c(seq_len(n - 1) %% 11L, NA))
+  f <- function() {
+    summarise(df, s = sum(x, na.rm = TRUE), m = mean(x), m2 = mean(x, na.rm = TRUE),
+      v = var(x, na.rm = TRUE), lo = min(i, na.rm = TRUE), hi = max(i),
+      si = sum(i, na.rm = TRUE))
+  }
+  expect_equal(with_dplyr_threads(4, f()), with_dplyr_threads(1, f()))
+})
+
+test_that("hybrid reducers see columns replaced within a verb", {
+  gdf <- group_by(data_frame(g = rep(1:2, each = 2), x = 1), g)
+  res <- mutate(gdf, a = sum(x), x = c(1, 2, 3, 5), b = sum(x), d = n_distinct(x))
+  expect_equal(res$a, rep(2, 4))
+  expect_equal(res$b, c(3, 3, 8, 8))
+  expect_equal(res$d, rep(2L, 4))
+})
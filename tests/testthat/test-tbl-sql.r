@@ -9,3 +9,40 @@ test_that("can generate sql tbls with raw sql", {
     expect_equal(collect(tbl), collect(clone))
   }
 })
+
+test_that("paged collect gives the same result as a single fetch", {
+  skip_if_no_sqlite()
+
+  df <- data_frame(
+    g = c(3, 1, 2, 1, 3, 3, 2),
+    h = c("b", "a", "a", "a", "b", NA, "a"),
+    x = 1:7
+  )
+  tbls <- test_load(df, ignore = c("df", "postgres"))
+  sqlite <- tbls$sqlite
+
+  for (page_size in c(1, 2, 5, 10)) {
+    out <- dplyr:::collect_paged(sqlite, sql_render(sqlite), page_size = page_size)
+    expect_equal(out, collect(sqlite, n = 10))
+
+    grouped <- sqlite %>% group_by(g, h)
+    out <- dplyr:::collect_paged(grouped, sql_render(grouped), page_size = page_size)
+    expect_identical(groups(out), groups(grouped))
+    expect_equal(attr(out, "indices"), attr(group_by(df, g, h), "indices"))
+    expect_equal(attr(out, "labels"), attr(collect(grouped, n = 10), "labels"))
+    expect_equal(group_size(out), group_size(group_by(df, g, h)))
+  }
+})
+
+test_that("paged collect respects n", {
+  skip_if_no_sqlite()
+
+  df <- data_frame(x = 1:10)
+  sqlite <- test_load(df, ignore = c("df", "postgres"))$sqlite
+
+  expect_warning(
+    out <- dplyr:::collect_paged(sqlite, sql_render(sqlite), n = 5, page_size = 2),
+    "Only first 5 results retrieved"
+  )
+  expect_equal(out$x, 1:5)
+})